@@ -0,0 +1,650 @@
+#include "assetstore.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QDebug>
+
+AssetStore *AssetStore::instance()
+{
+    static AssetStore *store = new AssetStore();
+    return store;
+}
+
+AssetStore::Mapping::~Mapping()
+{
+    file->unmap(const_cast<uchar*>(data));
+    delete file;
+}
+
+AssetStore::AssetStore(QObject *parent)
+    : QObject(parent)
+    , m_totalSize(0)
+    , m_maxSize(DefaultMaxSize)
+    , m_saveScheduled(false)
+    , m_evictionEnabled(false)
+    , m_mappingCount(0)
+    , m_pool(nullptr)
+{
+    m_rootPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/assets";
+
+    // Créer le dossier de stockage si nécessaire
+    QDir dir(m_rootPath);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    scan();
+
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(1);
+
+    // Créé à la première utilisation, éventuellement sur un thread de travail sans boucle
+    // d'événements: les sauvegardes de l'index sont confiées au thread principal
+    if (qApp) {
+        moveToThread(qApp->thread());
+    }
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        m_pool->clear();
+        m_pool->waitForDone();
+
+        // Une sauvegarde encore en attente ne serait plus traitée
+        bool saveScheduled;
+        {
+            QMutexLocker locker(&m_mutex);
+            saveScheduled = m_saveScheduled;
+        }
+        if (saveScheduled) {
+            saveIndex();
+        }
+    }, Qt::DirectConnection);
+}
+
+QString AssetStore::hashFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+
+    // Hacher directement la projection mémoire quand c'est possible
+    if (uchar *data = file.map(0, file.size())) {
+        hash.addData(QByteArrayView(data, file.size()));
+        file.unmap(data);
+    } else if (!hash.addData(&file)) {
+        return QString();
+    }
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool AssetStore::isValidHash(const QString &hash)
+{
+    if (hash.size() != 64) {
+        return false;
+    }
+    for (const QChar c : hash) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString AssetStore::importFile(const QString &filePath)
+{
+    QFileInfo fileInfo(filePath);
+    if (filePath.isEmpty() || !fileInfo.isFile()) {
+        return QString();
+    }
+
+    const QString canonicalPath = fileInfo.canonicalFilePath();
+    const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Réutiliser l'empreinte si le fichier n'a pas changé depuis le dernier import
+    {
+        QMutexLocker locker(&m_mutex);
+        auto cached = m_hashCache.constFind(canonicalPath);
+        if (cached != m_hashCache.constEnd() && cached->size == fileInfo.size()
+            && cached->modified == modified) {
+            auto entry = m_entries.find(cached->hash);
+            if (entry != m_entries.end()) {
+                entry->lastAccess = now;
+                scheduleSaveLocked();
+                return cached->hash;
+            }
+        }
+    }
+
+    // Un fichier déjà rangé dans le stockage est son propre contenu
+    QString hash = hashForStoredPath(canonicalPath);
+    if (hash.isEmpty()) {
+        hash = hashFile(canonicalPath);
+    }
+    if (hash.isEmpty()) {
+        qDebug() << "ERREUR: Impossible de lire le fichier à importer:" << filePath;
+        return QString();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_hashCache.insert(canonicalPath, { fileInfo.size(), modified, hash });
+
+        auto entry = m_entries.find(hash);
+        if (entry != m_entries.end()) {
+            entry->lastAccess = now;
+            scheduleSaveLocked();
+            return hash;
+        }
+    }
+
+    // Copier hors verrou dans un fichier temporaire, puis le renommer en une seule opération
+    const QString storedName = fileInfo.suffix().isEmpty()
+        ? hash : hash + "." + fileInfo.suffix().toLower();
+    const QString temporaryPath = m_rootPath + "/" + hash + ".import";
+
+    QFile::remove(temporaryPath);
+    if (!QFile::copy(canonicalPath, temporaryPath)) {
+        qDebug() << "ERREUR: Impossible de copier" << filePath << "dans le stockage";
+        return QString();
+    }
+
+    bool added = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_entries.contains(hash)) {
+            QFile::remove(m_rootPath + "/" + storedName);
+            if (!QFile::rename(temporaryPath, m_rootPath + "/" + storedName)) {
+                qDebug() << "ERREUR: Impossible de ranger" << filePath << "dans le stockage";
+                QFile::remove(temporaryPath);
+                return QString();
+            }
+            insertEntryLocked(hash, storedName, fileInfo.size());
+            added = true;
+        } else {
+            // Importé entre-temps par un autre thread
+            QFile::remove(temporaryPath);
+        }
+    }
+
+    if (added) {
+        qDebug() << "Fichier importé dans le stockage:" << filePath << "->" << hash;
+        emit assetAdded(hash);
+    }
+
+    return hash;
+}
+
+void AssetStore::importFileAsync(const QString &filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (filePath.isEmpty() || m_importing.contains(filePath)) {
+            return;
+        }
+        m_importing.insert(filePath);
+    }
+
+    m_pool->start([this, filePath]() {
+        const QString hash = importFile(filePath);
+        {
+            QMutexLocker locker(&m_mutex);
+            m_importing.remove(filePath);
+        }
+        emit fileImported(filePath, hash);
+    });
+}
+
+QString AssetStore::cachedHash(const QString &filePath) const
+{
+    const QString storedHash = hashForStoredPath(filePath);
+    if (!storedHash.isEmpty()) {
+        return contains(storedHash) ? storedHash : QString();
+    }
+
+    const QFileInfo fileInfo(filePath);
+    if (filePath.isEmpty() || !fileInfo.isFile()) {
+        return QString();
+    }
+
+    // Une simple lecture des attributs du fichier, sans ouvrir son contenu
+    QMutexLocker locker(&m_mutex);
+    auto cached = m_hashCache.constFind(fileInfo.canonicalFilePath());
+    if (cached == m_hashCache.constEnd() || cached->size != fileInfo.size()
+        || cached->modified != fileInfo.lastModified().toMSecsSinceEpoch()
+        || !m_entries.contains(cached->hash)) {
+        return QString();
+    }
+    return cached->hash;
+}
+
+bool AssetStore::contains(const QString &hash) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(hash);
+}
+
+QString AssetStore::filePath(const QString &hash) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(hash);
+    return it != m_entries.constEnd() ? m_rootPath + "/" + it->name : QString();
+}
+
+qint64 AssetStore::fileSize(const QString &hash) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(hash);
+    return it != m_entries.constEnd() ? it->size : -1;
+}
+
+QByteArray AssetStore::readChunk(const QString &hash, qint64 offset, qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(hash);
+    if (it == m_entries.end() || offset < 0 || offset >= it->size) {
+        return QByteArray();
+    }
+
+    const std::shared_ptr<Mapping> mapping = mapLocked(it.value());
+    if (!mapping) {
+        return QByteArray();
+    }
+
+    // La copie se fait sous verrou: une éviction concurrente ne peut pas retirer la projection
+    it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    return QByteArray(reinterpret_cast<const char*>(mapping->data) + offset, qMin(maxSize, it->size - offset));
+}
+
+std::shared_ptr<const AssetStore::Mapping> AssetStore::map(const QString &hash)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(hash);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Mapping> mapping = mapLocked(it.value());
+    if (!mapping) {
+        return nullptr;
+    }
+
+    it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    scheduleSaveLocked();
+    return mapping;
+}
+
+void AssetStore::retain(const QString &path)
+{
+    const QString hash = hashForStoredPath(path);
+    if (hash.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(hash);
+    if (it != m_entries.end()) {
+        it->pins++;
+        it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+        scheduleSaveLocked();
+    }
+}
+
+void AssetStore::release(const QString &path)
+{
+    const QString hash = hashForStoredPath(path);
+    if (hash.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(hash);
+    if (it != m_entries.end() && it->pins > 0) {
+        it->pins--;
+        if (it->pins == 0) {
+            evictLocked();
+        }
+    }
+}
+
+void AssetStore::enableEviction()
+{
+    QMutexLocker locker(&m_mutex);
+    m_evictionEnabled = true;
+    evictLocked();
+}
+
+void AssetStore::setMaxSize(qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxSize = qMax<qint64>(0, maxSize);
+    evictLocked();
+}
+
+qint64 AssetStore::maxSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxSize;
+}
+
+qint64 AssetStore::totalSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalSize;
+}
+
+qint64 AssetStore::partialSize(const QString &hash) const
+{
+    const QString partial = partialPath(hash);
+    return partial.isEmpty() ? 0 : QFileInfo(partial).size();
+}
+
+bool AssetStore::writeChunk(const QString &hash, qint64 offset, const QByteArray &data)
+{
+    const QString partial = partialPath(hash);
+    if (partial.isEmpty()) {
+        qDebug() << "ERREUR: Empreinte invalide, portion ignorée:" << hash;
+        return false;
+    }
+
+    QFile file(partial);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qDebug() << "ERREUR: Impossible d'ouvrir le fichier partiel" << file.fileName();
+        return false;
+    }
+
+    // Les portions arrivent dans l'ordre: refuser un trou ou un recouvrement
+    if (file.size() != offset) {
+        qDebug() << "AVERTISSEMENT: Portion inattendue pour" << hash << "position" << offset
+                 << "taille locale" << file.size();
+        return false;
+    }
+
+    file.seek(offset);
+    return file.write(data) == data.size();
+}
+
+bool AssetStore::finalizeDownload(const QString &hash, const QString &suffix)
+{
+    const QString partial = partialPath(hash);
+    if (partial.isEmpty()) {
+        qDebug() << "ERREUR: Empreinte invalide, téléchargement refusé:" << hash;
+        return false;
+    }
+
+    // Vérifier que le contenu reçu correspond bien à l'empreinte annoncée
+    if (hashFile(partial) != hash) {
+        qDebug() << "ERREUR: Empreinte invalide pour le fichier téléchargé" << hash << ", suppression";
+        QFile::remove(partial);
+        return false;
+    }
+
+    // L'extension vient du pair: elle ne doit pas pouvoir sortir du dossier
+    bool validSuffix = suffix.size() <= 10;
+    for (const QChar c : suffix) {
+        validSuffix = validSuffix && c.isLetterOrNumber() && c.unicode() < 128;
+    }
+    const QString storedName = (suffix.isEmpty() || !validSuffix) ? hash : hash + "." + suffix.toLower();
+    const qint64 size = QFileInfo(partial).size();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_entries.contains(hash)) {
+            QFile::remove(m_rootPath + "/" + storedName);
+            if (!QFile::rename(partial, m_rootPath + "/" + storedName)) {
+                qDebug() << "ERREUR: Impossible de finaliser le fichier" << storedName;
+                return false;
+            }
+            insertEntryLocked(hash, storedName, size);
+        } else {
+            QFile::remove(partial);
+        }
+    }
+
+    qDebug() << "Fichier téléchargé et vérifié:" << storedName;
+    emit assetAdded(hash);
+
+    return true;
+}
+
+void AssetStore::discardPartial(const QString &hash)
+{
+    const QString partial = partialPath(hash);
+    if (!partial.isEmpty()) {
+        QFile::remove(partial);
+    }
+}
+
+void AssetStore::saveIndex()
+{
+    QJsonObject entries;
+    QJsonObject paths;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_saveScheduled = false;
+
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            QJsonObject entry;
+            entry["name"] = it->name;
+            entry["size"] = it->size;
+            entry["last_access"] = it->lastAccess;
+            entries[it.key()] = entry;
+        }
+
+        // Seules les empreintes encore présentes dans le stockage méritent d'être conservées
+        for (auto it = m_hashCache.constBegin(); it != m_hashCache.constEnd(); ++it) {
+            if (!m_entries.contains(it->hash)) {
+                continue;
+            }
+            QJsonObject path;
+            path["size"] = it->size;
+            path["modified"] = it->modified;
+            path["hash"] = it->hash;
+            paths[it.key()] = path;
+        }
+    }
+
+    QJsonObject index;
+    index["version"] = 1;
+    index["entries"] = entries;
+    index["paths"] = paths;
+
+    // Écrire dans un fichier temporaire pour ne jamais laisser un index tronqué
+    const QString indexPath = m_rootPath + "/index.json";
+    QFile file(indexPath + ".tmp");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "ERREUR: Impossible d'écrire l'index du stockage:" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    file.close();
+
+    QFile::remove(indexPath);
+    QFile::rename(file.fileName(), indexPath);
+}
+
+void AssetStore::scan()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_hashCache.clear();
+    m_totalSize = 0;
+    m_mappingCount = 0;
+
+    // Charger l'index de la session précédente
+    QJsonObject index;
+    QFile indexFile(m_rootPath + "/index.json");
+    if (indexFile.open(QIODevice::ReadOnly)) {
+        index = QJsonDocument::fromJson(indexFile.readAll()).object();
+        indexFile.close();
+    }
+    const QJsonObject indexedEntries = index["entries"].toObject();
+
+    // Le dossier fait foi: un fichier absent de l'index est ajouté, une entrée sans fichier est oubliée
+    QDir dir(m_rootPath);
+    const QFileInfoList files = dir.entryInfoList(QDir::Files);
+    for (const QFileInfo &file : files) {
+        // Fichiers partiels, imports interrompus et index ne sont pas des fichiers stockés
+        if (file.suffix() == "part" || file.fileName().startsWith("index.json")) {
+            continue;
+        }
+        if (file.suffix() == "import") {
+            QFile::remove(file.absoluteFilePath());
+            continue;
+        }
+
+        const QString hash = file.completeBaseName();
+        const QJsonObject indexed = indexedEntries[hash].toObject();
+
+        Entry entry;
+        entry.name = file.fileName();
+        entry.size = file.size();
+        entry.lastAccess = indexed["last_access"].toInteger(file.lastModified().toMSecsSinceEpoch());
+        entry.pins = 0;
+
+        m_entries.insert(hash, entry);
+        m_totalSize += entry.size;
+    }
+
+    const QJsonObject paths = index["paths"].toObject();
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        const QJsonObject path = it.value().toObject();
+        const QString hash = path["hash"].toString();
+        if (m_entries.contains(hash)) {
+            m_hashCache.insert(it.key(), { path["size"].toInteger(), path["modified"].toInteger(), hash });
+        }
+    }
+
+    qDebug() << "Stockage des fichiers:" << m_entries.size() << "fichiers," << m_totalSize
+             << "octets dans" << m_rootPath;
+}
+
+void AssetStore::insertEntryLocked(const QString &hash, const QString &name, qint64 size)
+{
+    Entry entry;
+    entry.name = name;
+    entry.size = size;
+    entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+    entry.pins = 0;
+
+    m_entries.insert(hash, entry);
+    m_totalSize += size;
+
+    // Le fichier ajouté va être utilisé: l'évincer aussitôt le ferait retélécharger
+    evictLocked(hash);
+    scheduleSaveLocked();
+}
+
+std::shared_ptr<AssetStore::Mapping> AssetStore::mapLocked(Entry &entry)
+{
+    if (entry.mapping) {
+        return entry.mapping;
+    }
+
+    QFile *file = new QFile(m_rootPath + "/" + entry.name);
+    uchar *data = file->open(QIODevice::ReadOnly) ? file->map(0, entry.size) : nullptr;
+    if (!data) {
+        qDebug() << "ERREUR: Impossible de projeter en mémoire le fichier" << entry.name;
+        delete file;
+        return nullptr;
+    }
+
+    // La projection reste valide après la fermeture: ne pas garder un descripteur par fichier
+    file->close();
+
+    // Libérer d'abord la place, pour ne pas retirer aussitôt la nouvelle projection
+    if (m_mappingCount >= MaxMappings) {
+        releaseIdleMappingsLocked();
+    }
+
+    entry.mapping = std::shared_ptr<Mapping>(new Mapping{ file, data, entry.size });
+    m_mappingCount++;
+    return entry.mapping;
+}
+
+void AssetStore::releaseIdleMappingsLocked()
+{
+    for (Entry &entry : m_entries) {
+        if (entry.mapping && entry.mapping.use_count() == 1) {
+            entry.mapping.reset();
+            m_mappingCount--;
+        }
+    }
+}
+
+void AssetStore::evictLocked(const QString &keep)
+{
+    if (!m_evictionEnabled) {
+        return;
+    }
+
+    while (m_totalSize > m_maxSize) {
+        // Chercher le fichier non retenu utilisé le moins récemment
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->pins == 0 && it.key() != keep && (oldest == m_entries.end() || it->lastAccess < oldest->lastAccess)) {
+                oldest = it;
+            }
+        }
+
+        if (oldest == m_entries.end()) {
+            qDebug() << "AVERTISSEMENT: Stockage plein (" << m_totalSize << "/" << m_maxSize
+                     << "octets) mais tous les fichiers sont utilisés";
+            break;
+        }
+
+        qDebug() << "Éviction du fichier" << oldest->name << "(" << oldest->size << "octets)";
+
+        // La projection n'est retirée qu'une fois relâchée par ses derniers lecteurs
+        if (!QFile::remove(m_rootPath + "/" + oldest->name)) {
+            qDebug() << "AVERTISSEMENT: Impossible de supprimer le fichier évincé" << oldest->name;
+        }
+        const QString hash = oldest.key();
+        m_totalSize -= oldest->size;
+        if (oldest->mapping) {
+            m_mappingCount--;
+        }
+        m_entries.erase(oldest);
+        emit assetEvicted(hash);
+
+        scheduleSaveLocked();
+    }
+}
+
+void AssetStore::scheduleSaveLocked()
+{
+    if (m_saveScheduled) {
+        return;
+    }
+
+    m_saveScheduled = true;
+    QMetaObject::invokeMethod(this, &AssetStore::saveIndex, Qt::QueuedConnection);
+}
+
+QString AssetStore::hashForStoredPath(const QString &path) const
+{
+    const QFileInfo fileInfo(path);
+    if (path.isEmpty() || fileInfo.absolutePath() != QFileInfo(m_rootPath).absoluteFilePath()) {
+        return QString();
+    }
+
+    return fileInfo.completeBaseName();
+}
+
+QString AssetStore::partialPath(const QString &hash) const
+{
+    if (!isValidHash(hash)) {
+        return QString();
+    }
+    return m_rootPath + "/" + hash + ".part";
+}
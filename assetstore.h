@@ -0,0 +1,338 @@
+#ifndef ASSETSTORE_H
+#define ASSETSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <memory>
+
+class QFile;
+class QThreadPool;
+
+/**
+ * @brief Stockage local des fichiers audio et images, adressés par leur contenu
+ *
+ * Chaque fichier est identifié par l'empreinte SHA-256 de son contenu et rangé dans
+ * le dossier de données de l'application sous le nom "<empreinte>.<extension>".
+ * Un même son n'est donc stocké et transféré qu'une seule fois, quel que soit le
+ * chemin d'origine. Les téléchargements en cours sont écrits dans un fichier ".part"
+ * qui permet de reprendre un transfert interrompu.
+ *
+ * Le stockage est limité à maxSize() octets : au-delà, les fichiers utilisés le moins
+ * récemment sont supprimés, sauf ceux retenus par un pad (retain()). L'éviction ne
+ * commence qu'après enableEviction(), une fois la taille configurée et les fichiers des
+ * tableaux chargés retenus : au démarrage, aucun pad n'a encore rien retenu. L'index des
+ * fichiers, leur date de dernier accès et les empreintes des chemins déjà importés
+ * sont conservés dans "index.json", si bien qu'un board rechargé ou une room rejointe
+ * à nouveau ne recopie ni ne retélécharge aucun fichier déjà présent.
+ *
+ * Les lectures passent par une projection mémoire du fichier (QFile::map), partagée
+ * avec le cache de pages du système : relire un fichier récent ne coûte aucune lecture
+ * disque ni copie. Une projection est partagée avec ses lecteurs et n'est retirée qu'après
+ * le dernier d'entre eux, même si le fichier a été évincé entre-temps. Le fichier est
+ * fermé dès qu'il est projeté, et au-delà de MaxMappings projections, celles que plus
+ * aucun lecteur ne tient sont retirées : un grand tableau n'épuise ni les descripteurs
+ * de fichiers ni l'espace d'adressage.
+ *
+ * Toutes les méthodes peuvent être appelées depuis n'importe quel thread.
+ */
+class AssetStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const qint64 DefaultMaxSize = 2LL * 1024 * 1024 * 1024; ///< Taille maximale par défaut
+    static const int MaxMappings = 256;                             ///< Projections gardées avant de retirer celles sans lecteur
+
+    /**
+     * @brief Projection mémoire d'un fichier stocké
+     * @details Le fichier est fermé aussitôt projeté ; l'objet QFile n'est gardé que pour
+     *          dé-projeter à la destruction, quand plus personne ne tient la projection.
+     */
+    struct Mapping {
+        QFile *file;            // Fichier (fermé) qui a créé la projection
+        const uchar *data;      // Début de la projection mémoire
+        qint64 size;            // Taille projetée en octets
+
+        ~Mapping();
+    };
+
+    /**
+     * @brief Obtient l'instance partagée par toute l'application
+     * @return Instance unique
+     */
+    static AssetStore *instance();
+
+    /**
+     * @brief Calcule l'empreinte d'un fichier
+     * @param filePath Chemin du fichier
+     * @return Empreinte SHA-256 en hexadécimal, ou une chaîne vide si le fichier est illisible
+     */
+    static QString hashFile(const QString &filePath);
+
+    /**
+     * @brief Vérifie qu'une empreinte reçue est bien une empreinte SHA-256
+     * @details Une empreinte sert de nom de fichier : seules 64 lettres hexadécimales
+     *          minuscules sont acceptées, ce qui exclut tout chemin.
+     * @param hash Empreinte à vérifier
+     * @return true si l'empreinte est bien formée
+     */
+    static bool isValidHash(const QString &hash);
+
+    /**
+     * @brief Ajoute un fichier local au stockage
+     * @details Le fichier est copié s'il n'est pas déjà présent. L'empreinte d'un chemin
+     *          déjà importé est mise en cache tant que le fichier n'est pas modifié.
+     * @param filePath Chemin du fichier à importer
+     * @return Empreinte du fichier, ou une chaîne vide en cas d'échec
+     */
+    QString importFile(const QString &filePath);
+
+    /**
+     * @brief Ajoute un fichier local au stockage en arrière-plan
+     * @details Le calcul de l'empreinte et la copie se font sur un thread de travail ;
+     *          fileImported() est émis à la fin. Un fichier déjà en cours d'import n'est
+     *          pas relancé.
+     * @param filePath Chemin du fichier à importer
+     */
+    void importFileAsync(const QString &filePath);
+
+    /**
+     * @brief Obtient l'empreinte d'un fichier local sans le lire
+     * @details Seule une empreinte déjà connue est retournée : celle d'un fichier du
+     *          stockage, ou celle d'un fichier déjà importé et non modifié depuis.
+     * @param filePath Chemin du fichier
+     * @return Empreinte, ou une chaîne vide si elle n'est pas connue
+     */
+    QString cachedHash(const QString &filePath) const;
+
+    /**
+     * @brief Indique si un fichier complet est disponible localement
+     * @param hash Empreinte du fichier
+     */
+    bool contains(const QString &hash) const;
+
+    /**
+     * @brief Obtient le chemin local d'un fichier stocké
+     * @param hash Empreinte du fichier
+     * @return Chemin du fichier, ou une chaîne vide s'il n'est pas disponible
+     */
+    QString filePath(const QString &hash) const;
+
+    /**
+     * @brief Retrouve l'empreinte d'un chemin situé dans le stockage
+     * @param path Chemin local
+     * @return Empreinte, ou une chaîne vide si le chemin est hors du stockage
+     */
+    QString hashForStoredPath(const QString &path) const;
+
+    /**
+     * @brief Obtient la taille d'un fichier stocké
+     * @param hash Empreinte du fichier
+     * @return Taille en octets, ou -1 s'il n'est pas disponible
+     */
+    qint64 fileSize(const QString &hash) const;
+
+    /**
+     * @brief Lit une portion d'un fichier stocké
+     * @param hash Empreinte du fichier
+     * @param offset Position de début
+     * @param maxSize Nombre maximal d'octets à lire
+     * @return Octets lus (vide en fin de fichier ou si le fichier est absent)
+     */
+    QByteArray readChunk(const QString &hash, qint64 offset, qint64 maxSize);
+
+    /**
+     * @brief Donne accès au contenu d'un fichier stocké sans le copier
+     * @details La projection retournée reste valide tant qu'elle est tenue, même si le
+     *          fichier est évincé entre-temps.
+     * @param hash Empreinte du fichier
+     * @return Projection du fichier, ou nullptr s'il n'est pas disponible
+     */
+    std::shared_ptr<const Mapping> map(const QString &hash);
+
+    /**
+     * @brief Empêche l'éviction d'un fichier utilisé
+     * @details Les appels sont comptés ; un chemin situé hors du stockage est ignoré.
+     * @param path Chemin local du fichier (tel que retourné par filePath())
+     */
+    void retain(const QString &path);
+
+    /**
+     * @brief Libère un fichier retenu par retain()
+     * @param path Chemin local du fichier
+     */
+    void release(const QString &path);
+
+    /**
+     * @brief Autorise l'éviction et l'applique aussitôt si le stockage est trop grand
+     * @details À appeler une fois la taille maximale définie et l'interface restaurée.
+     */
+    void enableEviction();
+
+    /**
+     * @brief Définit la taille maximale du stockage
+     * @details Les fichiers les moins récemment utilisés sont évincés si nécessaire,
+     *          dès que l'éviction est autorisée.
+     * @param maxSize Taille maximale en octets
+     */
+    void setMaxSize(qint64 maxSize);
+
+    /**
+     * @brief Obtient la taille maximale du stockage
+     * @return Taille maximale en octets
+     */
+    qint64 maxSize() const;
+
+    /**
+     * @brief Obtient la taille totale des fichiers stockés
+     * @return Taille en octets
+     */
+    qint64 totalSize() const;
+
+    /**
+     * @brief Obtient la taille déjà téléchargée d'un fichier incomplet
+     * @param hash Empreinte du fichier
+     * @return Nombre d'octets présents dans le fichier ".part"
+     */
+    qint64 partialSize(const QString &hash) const;
+
+    /**
+     * @brief Écrit une portion reçue d'un fichier en cours de téléchargement
+     * @param hash Empreinte du fichier
+     * @param offset Position de la portion (doit correspondre à la taille déjà reçue)
+     * @param data Octets reçus
+     * @return true si la portion a été écrite
+     */
+    bool writeChunk(const QString &hash, qint64 offset, const QByteArray &data);
+
+    /**
+     * @brief Termine un téléchargement après vérification de l'empreinte
+     * @param hash Empreinte attendue
+     * @param suffix Extension du fichier d'origine
+     * @return true si le fichier est complet et intègre ; sinon le fichier partiel est supprimé
+     */
+    bool finalizeDownload(const QString &hash, const QString &suffix);
+
+    /**
+     * @brief Abandonne les octets déjà reçus d'un téléchargement
+     * @param hash Empreinte du fichier
+     */
+    void discardPartial(const QString &hash);
+
+signals:
+    /**
+     * @brief Signal émis lorsqu'un nouveau fichier devient disponible localement
+     * @param hash Empreinte du fichier
+     */
+    void assetAdded(const QString &hash);
+
+    /**
+     * @brief Signal émis lorsqu'un fichier est évincé du stockage (verrou tenu)
+     * @details Les connexions directes ne doivent pas rappeler le stockage.
+     * @param hash Empreinte du fichier supprimé
+     */
+    void assetEvicted(const QString &hash);
+
+    /**
+     * @brief Signal émis à la fin d'un import lancé par importFileAsync() (thread de travail)
+     * @param filePath Chemin du fichier, tel que donné à importFileAsync()
+     * @param hash Empreinte du fichier, ou une chaîne vide en cas d'échec
+     */
+    void fileImported(const QString &filePath, const QString &hash);
+
+private slots:
+    /**
+     * @brief Écrit l'index sur le disque
+     */
+    void saveIndex();
+
+private:
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit AssetStore(QObject *parent = nullptr);
+
+    /**
+     * @brief Fichier présent dans le stockage
+     */
+    struct Entry {
+        QString name;           // Nom du fichier dans le dossier du stockage
+        qint64 size;            // Taille en octets
+        qint64 lastAccess;      // Date du dernier accès (ms), pour l'éviction
+        int pins;               // Nombre d'utilisateurs qui empêchent l'éviction
+        std::shared_ptr<Mapping> mapping; // Projection mémoire partagée avec les lecteurs (nulle si non projeté)
+    };
+
+    /**
+     * @brief Empreinte déjà calculée pour un chemin local
+     */
+    struct HashCacheEntry {
+        qint64 size;            // Taille du fichier lors du calcul
+        qint64 modified;        // Date de modification lors du calcul (ms)
+        QString hash;           // Empreinte calculée
+    };
+
+    QString m_rootPath;                         // Dossier du stockage
+    QHash<QString, Entry> m_entries;            // Fichiers stockés par empreinte
+    QHash<QString, HashCacheEntry> m_hashCache; // Empreintes des fichiers locaux par chemin
+    qint64 m_totalSize;                         // Taille totale des fichiers stockés
+    qint64 m_maxSize;                           // Taille maximale avant éviction
+    bool m_saveScheduled;                       // Sauvegarde de l'index déjà demandée
+    bool m_evictionEnabled;                     // Éviction autorisée (enableEviction())
+    QSet<QString> m_importing;                  // Fichiers en cours d'import en arrière-plan
+    int m_mappingCount;                         // Fichiers projetés gardés par l'index
+    QThreadPool *m_pool;                        // Thread des imports en arrière-plan
+    mutable QMutex m_mutex;                     // Protège l'index
+
+    /**
+     * @brief Charge l'index puis le réconcilie avec le contenu du dossier
+     */
+    void scan();
+
+    /**
+     * @brief Ajoute un fichier à l'index et évince si nécessaire (verrou tenu)
+     * @param hash Empreinte du fichier
+     * @param name Nom du fichier dans le dossier du stockage
+     * @param size Taille du fichier
+     */
+    void insertEntryLocked(const QString &hash, const QString &name, qint64 size);
+
+    /**
+     * @brief Projette un fichier en mémoire si ce n'est pas déjà fait (verrou tenu)
+     * @param entry Fichier à projeter
+     * @return Projection du fichier, ou nullptr en cas d'échec
+     */
+    std::shared_ptr<Mapping> mapLocked(Entry &entry);
+
+    /**
+     * @brief Retire les projections que seul l'index tient encore (verrou tenu)
+     */
+    void releaseIdleMappingsLocked();
+
+    /**
+     * @brief Supprime les fichiers les moins récemment utilisés jusqu'à respecter la taille maximale (verrou tenu)
+     * @details Sans effet tant que l'éviction n'est pas autorisée. Le fichier épargné n'est
+     *          jamais évincé, quitte à dépasser la taille maximale.
+     * @param keep Empreinte du fichier à épargner (celui qui vient d'être ajouté)
+     */
+    void evictLocked(const QString &keep = QString());
+
+    /**
+     * @brief Demande une sauvegarde de l'index au prochain tour de boucle du thread principal (verrou tenu)
+     */
+    void scheduleSaveLocked();
+
+    /**
+     * @brief Obtient le chemin du fichier partiel d'un téléchargement
+     * @param hash Empreinte du fichier
+     * @return Chemin du fichier, ou une chaîne vide si l'empreinte est invalide
+     */
+    QString partialPath(const QString &hash) const;
+};
+
+#endif // ASSETSTORE_H
@@ -0,0 +1,723 @@
+#include "audioengine.h"
+#include "assetstore.h"
+#include "resampler.h"
+#include "latencymonitor.h"
+#include "audiostream.h"
+#include "mappedwav.h"
+#include "loudnessanalyzer.h"
+#include "chunkeddecoder.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAudioSink>
+#include <QAudioBuffer>
+#include <QMediaDevices>
+#include <QAudioDevice>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+AudioEngine *AudioEngine::instance()
+{
+    static AudioEngine *engine = new AudioEngine();
+    return engine;
+}
+
+AudioEngine::AudioEngine(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_output(nullptr)
+    , m_sink(nullptr)
+    , m_mixer(nullptr)
+    , m_finishedTimer(nullptr)
+    , m_decodePool(nullptr)
+    , m_streamPool(nullptr)
+    , m_streamingThreshold(DefaultStreamingThreshold)
+    , m_streamingHead(DefaultStreamingHead)
+    , m_reportedUnderruns(0)
+    , m_stopping(false)
+    , m_outputBuffer(DefaultOutputBuffer)
+    , m_outputPeriods(DefaultOutputPeriods)
+    , m_openedBuffer(0.0)
+    , m_openedPeriods(0)
+    , m_normalize(true)
+    , m_loudnessTarget(DefaultLoudnessTarget)
+{
+    // Format de mixage: flottants stéréo à la fréquence préférée du périphérique
+    const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    m_format.setSampleRate(device.preferredFormat().sampleRate());
+    m_format.setChannelCount(2);
+    m_format.setSampleFormat(QAudioFormat::Float);
+
+    // Le mixeur existe dès la construction: un déclenchement n'a jamais à attendre la sortie.
+    // Il appartient, avec la sortie, au contexte placé sur le thread temps réel
+    m_output = new QObject();
+    m_mixer = new AudioMixer(m_format.channelCount(), m_output);
+    m_mixer->open(QIODevice::ReadOnly);
+
+    // Décodage en arrière-plan, en laissant un cœur à l'interface et au mixage. Créé avant
+    // le départ du moteur sur son thread: un parent situé sur un autre thread serait refusé
+    m_decodePool = new QThreadPool(this);
+    m_decodePool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    m_decodePool->setThreadPriority(QThread::LowPriority);
+
+    // Un thread par flux: chacun attend que sa voix libère de la place dans son tampon
+    m_streamPool = new QThreadPool(this);
+    m_streamPool->setMaxThreadCount(AudioMixer::MaxStreams);
+    m_streamPool->setThreadPriority(QThread::HighPriority);
+
+    // Seuls la sortie et le mixeur vivent sur un thread dédié, prioritaire sur l'interface:
+    // rien n'y prend de verrou, ne lit de fichier ni ne libère de son
+    m_thread = new QThread();
+    m_thread->setObjectName("AudioOutput");
+    m_output->moveToThread(m_thread);
+    m_thread->start(QThread::TimeCriticalPriority);
+
+    QMetaObject::invokeMethod(m_output, [this]() {
+        openOutput();
+    }, Qt::QueuedConnection);
+
+    // Relève des fins de lecture, des sons réclamés et des mesures, sur le thread principal
+    m_finishedTimer = new QTimer(this);
+    m_finishedTimer->setInterval(20);
+    connect(m_finishedTimer, &QTimer::timeout, this, &AudioEngine::pollFinished);
+    m_finishedTimer->start();
+
+    // Décoder dès leur arrivée les sons importés ou reçus d'une room
+    connect(AssetStore::instance(), &AssetStore::assetAdded, this, [this](const QString &hash) {
+        const QString path = AssetStore::instance()->filePath(hash);
+        const QString suffix = QFileInfo(path).suffix();
+        if (suffix == "mp3" || suffix == "wav" || suffix == "ogg") {
+            preload(path);
+        }
+    });
+
+    // Corriger le gain des pads dès que la mesure de leur son arrive
+    connect(LoudnessAnalyzer::instance(), &LoudnessAnalyzer::analyzed, this,
+            [this](const QString &filePath, const LoudnessAnalyzer::Result &) {
+        QMutexLocker locker(&m_mutex);
+        applyGainLocked(filePath);
+    });
+
+    // Fermer proprement la sortie avant la fin de l'application
+    connect(qApp, &QCoreApplication::aboutToQuit, qApp, [this]() {
+        m_stopping.store(true);
+        m_finishedTimer->stop();
+        m_decodePool->clear();
+        m_decodePool->waitForDone();
+        m_streamPool->waitForDone();
+        QMetaObject::invokeMethod(m_output, [this]() {
+            shutdown();
+        }, Qt::BlockingQueuedConnection);
+        m_thread->quit();
+        m_thread->wait();
+    });
+
+    // Créé à la première utilisation, éventuellement hors du thread principal: la relève et
+    // les connexions ci-dessus doivent tourner dans une boucle d'événements
+    if (qApp) {
+        moveToThread(qApp->thread());
+    }
+}
+
+void AudioEngine::preload(const QString &filePath)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    int headMilliseconds = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_cache.contains(filePath) || m_decoding.contains(filePath)) {
+            return;
+        }
+        m_decoding.insert(filePath);
+
+        // Fichier long: ne décoder d'avance que le début, la suite sera lue en continu
+        if (m_streamingThreshold > 0 && QFileInfo(filePath).size() > m_streamingThreshold) {
+            headMilliseconds = m_streamingHead;
+        }
+    }
+
+    const QAudioFormat format = m_format;
+    m_decodePool->start([this, filePath, format, headMilliseconds]() {
+        finishDecode(filePath, decodeFile(filePath, format, m_stopping, headMilliseconds));
+    });
+}
+
+void AudioEngine::setPadSound(quintptr padKey, const QString &filePath)
+{
+    // Les commandes sont déposées sous le verrou pour rester ordonnées avec celles de finishDecode()
+    QMutexLocker locker(&m_mutex);
+    if (filePath.isEmpty()) {
+        m_padSounds.remove(padKey);
+        m_mixer->unbindPad(padKey);
+        return;
+    }
+
+    m_padSounds.insert(padKey, filePath);
+
+    // Agrandir la table des pads du mixeur avant qu'elle ne refuse celui-ci
+    m_mixer->reservePads(int(m_padSounds.size()));
+
+    // Son déjà décodé: l'associer aussitôt, sinon il le sera à la fin du décodage
+    std::shared_ptr<const AudioSample> sample = m_cache.lookup(filePath);
+    if (sample) {
+        m_mixer->bindPad(padKey, std::move(sample), normalizationGainLocked(filePath));
+        return;
+    }
+
+    m_mixer->unbindPad(padKey);
+    locker.unlock();
+    preload(filePath);
+}
+
+void AudioEngine::removePad(quintptr padKey)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_padSounds.remove(padKey);
+    }
+    m_mixer->stop(padKey);
+    m_mixer->unbindPad(padKey);
+}
+
+void AudioEngine::play(quintptr padKey, bool restart, float gain, float pan, qint64 inputTime)
+{
+    if (!m_mixer->trigger(padKey, restart, gain, pan, 0, inputTime)) {
+        qDebug() << "AVERTISSEMENT: File de déclenchement pleine, son ignoré";
+    }
+}
+
+void AudioEngine::playAt(quintptr padKey, bool restart, qint64 time, float gain, float pan)
+{
+    // Une trame déjà mixée ne peut plus être visée: le mixeur saute alors le début du son
+    if (!m_mixer->trigger(padKey, restart, gain, pan, m_mixer->frameAt(time))) {
+        qDebug() << "AVERTISSEMENT: File de déclenchement pleine, son ignoré";
+    }
+}
+
+void AudioEngine::playGroup(const QVector<GroupMember> &members, qint64 time, qint64 inputTime)
+{
+    if (members.size() > AudioMixer::MaxGroupMembers) {
+        qDebug() << "AVERTISSEMENT: Groupe de" << members.size() << "pads, seuls les"
+                 << AudioMixer::MaxGroupMembers << "premiers sont joués";
+    }
+
+    AudioMixer::GroupMember mixerMembers[AudioMixer::MaxGroupMembers];
+    const int count = qMin(int(members.size()), int(AudioMixer::MaxGroupMembers));
+    for (int i = 0; i < count; ++i) {
+        mixerMembers[i].padKey = members[i].padKey;
+        mixerMembers[i].restart = members[i].restart;
+        mixerMembers[i].gain = members[i].gain;
+        mixerMembers[i].offset = m_format.framesForDuration(qint64(members[i].offset) * 1000);
+    }
+
+    const qint64 startFrame = time > 0 ? m_mixer->frameAt(time) : 0;
+    if (count > 0 && !m_mixer->triggerGroup(mixerMembers, count, startFrame, inputTime)) {
+        qDebug() << "AVERTISSEMENT: File de déclenchement pleine, groupe ignoré";
+    }
+}
+
+void AudioEngine::stop(quintptr padKey)
+{
+    m_mixer->stop(padKey);
+}
+
+void AudioEngine::setMaxPolyphony(int voices)
+{
+    m_mixer->setMaxPolyphony(voices);
+}
+
+void AudioEngine::setStealPolicy(AudioMixer::StealPolicy policy)
+{
+    m_mixer->setStealPolicy(policy);
+}
+
+void AudioEngine::setSampleCacheBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    unbindEvictedLocked(m_cache.setBudget(bytes));
+}
+
+void AudioEngine::setStreamingThreshold(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_streamingThreshold = qMax<qint64>(0, bytes);
+}
+
+void AudioEngine::setStreamingHead(int milliseconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_streamingHead = qBound(50, milliseconds, 10000);
+}
+
+void AudioEngine::setLoudnessNormalization(bool enabled, double targetLufs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_normalize = enabled;
+    m_loudnessTarget = qBound(-40.0, targetLufs, 0.0);
+
+    // Les voix en cours gardent leur gain, les suivantes prennent le nouveau
+    QSet<QString> filePaths;
+    for (const QString &filePath : std::as_const(m_padSounds)) {
+        filePaths.insert(filePath);
+    }
+    for (const QString &filePath : std::as_const(filePaths)) {
+        applyGainLocked(filePath);
+    }
+}
+
+void AudioEngine::setOutputConfig(double bufferMilliseconds, int periods)
+{
+    const double buffer = qBound(MinOutputBuffer, bufferMilliseconds, MaxOutputBuffer);
+    const int bufferPeriods = qBound(1, periods, MaxOutputPeriods);
+    if (buffer != bufferMilliseconds || bufferPeriods != periods) {
+        qDebug() << "AVERTISSEMENT: Configuration de sortie invalide (" << bufferMilliseconds << "ms," << periods
+                 << "périodes), ramenée à" << buffer << "ms," << bufferPeriods << "périodes";
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_outputBuffer = buffer;
+        m_outputPeriods = bufferPeriods;
+    }
+
+    // La sortie appartient au thread temps réel
+    QMetaObject::invokeMethod(m_output, [this]() {
+        openOutput();
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::openOutput()
+{
+    double requested;
+    int periods;
+    {
+        QMutexLocker locker(&m_mutex);
+        requested = m_outputBuffer;
+        periods = m_outputPeriods;
+    }
+
+    // Déjà ouverte avec cette configuration
+    if (m_sink && requested == m_openedBuffer && periods == m_openedPeriods) {
+        return;
+    }
+    if (m_sink) {
+        m_sink->stop();
+        delete m_sink;
+        m_sink = nullptr;
+    }
+
+    // Tampon refusé: le doubler jusqu'au plus grand accepté, puis laisser choisir le périphérique (0)
+    QVector<double> ladder;
+    for (double buffer = requested; buffer <= MaxOutputBuffer; buffer *= 2.0) {
+        ladder.append(buffer);
+    }
+    ladder.append(0.0);
+
+    const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    for (double buffer : std::as_const(ladder)) {
+        m_sink = new QAudioSink(device, m_format, m_output);
+        if (buffer > 0.0) {
+            m_sink->setBufferSize(m_format.bytesForDuration(qint64(buffer * 1000.0)));
+        }
+        m_sink->start(m_mixer);
+
+        if (m_sink->error() == QAudio::NoError && m_sink->state() != QAudio::StoppedState) {
+            break;
+        }
+        qDebug() << "AVERTISSEMENT: Tampon de sortie de" << buffer << "ms refusé par le périphérique:" << m_sink->error();
+        m_sink->stop();
+        delete m_sink;
+        m_sink = nullptr;
+    }
+
+    m_openedBuffer = requested;
+    m_openedPeriods = periods;
+    if (!m_sink) {
+        qDebug() << "ERREUR: Impossible d'ouvrir la sortie audio";
+        return;
+    }
+
+    // Le périphérique peut arrondir la taille demandée: les périodes suivent le tampon obtenu
+    const qint64 bufferFrames = m_format.framesForBytes(m_sink->bufferSize());
+    const qint64 periodFrames = qMax<qint64>(MinPeriodFrames, bufferFrames / periods);
+    m_mixer->setOutputTiming(bufferFrames, periodFrames, m_format.sampleRate());
+    LatencyMonitor::instance()->setOutputTiming(m_format.durationForFrames(bufferFrames),
+                                                m_format.durationForFrames(periodFrames));
+
+    qDebug() << "Sortie audio ouverte:" << m_format.sampleRate() << "Hz," << m_format.channelCount()
+             << "canaux, tampon de" << m_format.durationForFrames(bufferFrames) / 1000.0 << "ms (demandé:"
+             << requested << "ms)," << periodFrames << "trames par période";
+}
+
+void AudioEngine::shutdown()
+{
+    if (m_sink) {
+        m_sink->stop();
+        delete m_sink;
+        m_sink = nullptr;
+    }
+    m_mixer->close();
+}
+
+void AudioEngine::pollFinished()
+{
+    QVector<quintptr> finished;
+    m_mixer->takeFinished(finished);
+
+    for (quintptr padKey : finished) {
+        emit padStopped(padKey);
+    }
+
+    // Pads déclenchés alors que leur son n'était pas associé (évincé du cache entre-temps)
+    QVector<quintptr> missing;
+    m_mixer->takeMissing(missing);
+
+    for (quintptr padKey : missing) {
+        QMutexLocker locker(&m_mutex);
+        const QString filePath = m_padSounds.value(padKey);
+        std::shared_ptr<const AudioSample> sample = filePath.isEmpty() ? nullptr : m_cache.lookup(filePath);
+
+        if (filePath.isEmpty()) {
+            m_mixer->unbindPad(padKey); // Pad inconnu: abandonner son déclenchement
+        } else if (sample) {
+            m_mixer->bindPad(padKey, std::move(sample), normalizationGainLocked(filePath));
+        } else {
+            locker.unlock();
+            preload(filePath); // Le déclenchement en attente partira à la fin du décodage
+        }
+    }
+
+    // Voix lues en continu qui viennent de démarrer
+    AudioStream *stream = nullptr;
+    while (m_mixer->takeStreamRequest(stream)) {
+        startStream(stream);
+    }
+
+    // Manques et dépassements de la sortie depuis le relevé précédent
+    const OutputStats outputStats = m_mixer->outputStats();
+    if (outputStats.underruns > m_reportedOutput.underruns || outputStats.overruns > m_reportedOutput.overruns) {
+        qDebug() << "AVERTISSEMENT: Sortie audio en retard," << outputStats.underruns - m_reportedOutput.underruns
+                 << "manques," << outputStats.overruns - m_reportedOutput.overruns << "dépassements (rappel le plus long:"
+                 << outputStats.maxCallback / 1000 << "µs)";
+    }
+    m_reportedOutput = outputStats;
+    LatencyMonitor::instance()->setOutputStats(outputStats);
+
+    const AudioMixer::StreamStats streamStats = m_mixer->streamStats();
+    if (streamStats.underruns > m_reportedUnderruns) {
+        qDebug() << "AVERTISSEMENT: Lecture en continu en retard," << streamStats.underruns - m_reportedUnderruns
+                 << "blocs incomplets (" << streamStats.underruns << "au total)";
+        m_reportedUnderruns = streamStats.underruns;
+    }
+
+    LatencySample latency;
+    while (m_mixer->takeLatency(latency)) {
+        LatencyMonitor::instance()->record(latency);
+    }
+
+    m_mixer->takeReleased();
+}
+
+std::shared_ptr<const AudioSample> AudioEngine::decodeFile(const QString &filePath, const QAudioFormat &format,
+                                                           const std::atomic<bool> &stopping, int headMilliseconds)
+{
+    // WAV déjà au format de mixage: lu sur place, sans décodage ni lecture en continu
+    std::shared_ptr<const AudioSample> mapped = MappedWav::load(filePath, format.sampleRate());
+    if (mapped) {
+        return mapped;
+    }
+
+    auto sample = std::make_shared<AudioSample>();
+    sample->channels = 0; // Fixés par le premier tampon décodé
+    sample->sampleRate = 0;
+
+    // Décoder au format natif du fichier: la conversion de fréquence est faite ensuite par le
+    // Resampler, plutôt que par le convertisseur du décodeur dont la qualité varie selon la plateforme
+    bool truncated = false;
+    QString error;
+    const ChunkedDecoder::Result decoded = ChunkedDecoder::decode(filePath, [&](const QAudioBuffer &buffer) {
+        appendBuffer(*sample, buffer);
+
+        // Tête d'un son lu en continu: décoder un peu plus que nécessaire, pour que le
+        // filtre de conversion des dernières trames conservées ait toutes ses trames source
+        if (headMilliseconds > 0
+            && sample->frameCount() >= qint64(headMilliseconds + 50) * sample->sampleRate / 1000) {
+            truncated = true;
+            return false;
+        }
+        return true;
+    }, &stopping, &error);
+
+    if (decoded == ChunkedDecoder::Failed) {
+        qDebug() << "ERREUR: Impossible de décoder" << filePath << ":" << error;
+        return nullptr;
+    }
+    if (decoded == ChunkedDecoder::Stopped && !truncated) {
+        return nullptr;
+    }
+
+    if (!truncated) {
+        qDebug() << "Son décodé:" << filePath << "(" << sample->frameCount() << "trames à" << sample->sampleRate << "Hz)";
+        return convertForOutput(std::move(sample), format);
+    }
+
+    // Ne garder que la tête, la suite est décodée par le flux de chaque voix
+    std::shared_ptr<AudioSample> head = convertForOutput(std::move(sample), format);
+    const qint64 headFrames = qMin(head->frameCount(), qint64(headMilliseconds) * format.sampleRate() / 1000);
+    head->pcm16.resize(headFrames * head->channels);
+    head->pcm16.squeeze();
+    head->streamPath = filePath;
+    qDebug() << "Début décodé pour la lecture en continu:" << filePath << "(" << headFrames << "trames)";
+    return head;
+}
+
+void AudioEngine::startStream(AudioStream *stream)
+{
+    const QAudioFormat format = m_format;
+    m_streamPool->start([this, stream, format]() {
+        // Voix déjà arrêtée: le flux revient à ce thread
+        if (!stream->start()) {
+            std::shared_ptr<const AudioSample> head;
+            stream->recycle(head);
+            return;
+        }
+        decodeStream(*stream, format, m_stopping);
+    });
+}
+
+void AudioEngine::decodeStream(AudioStream &stream, const QAudioFormat &format, const std::atomic<bool> &stopping)
+{
+    // Le flux garde sa tête jusqu'à ce que finish() le rende à la voix
+    const QString filePath = stream.head()->streamPath;
+    const int channels = stream.head()->channels;
+    qint64 skip = stream.head()->frameCount();
+
+    AudioSample chunk;
+    QVector<qint16> converted;
+    std::unique_ptr<Resampler> resampler;
+    std::unique_ptr<Resampler::Stream> resampling;
+
+    auto interrupted = [&stream, &stopping]() {
+        return stream.isCancelled() || stopping.load(std::memory_order_relaxed);
+    };
+
+    // Écrire les trames converties après la tête, en attendant que la voix libère de la place
+    auto deliver = [&]() {
+        const qint64 available = converted.size() / channels;
+        const qint64 skipped = qMin(skip, available);
+        const qint16 *samples = converted.constData() + skipped * channels;
+        qint64 frames = available - skipped;
+        skip -= skipped;
+
+        while (frames > 0 && !interrupted()) {
+            const qint64 written = stream.write(samples, frames);
+            samples += written * channels;
+            frames -= written;
+            if (frames > 0) {
+                QThread::msleep(5);
+            }
+        }
+        converted.clear();
+        return !interrupted();
+    };
+
+    QString error;
+    const ChunkedDecoder::Result decoded = ChunkedDecoder::decode(filePath, [&](const QAudioBuffer &buffer) {
+        if (!resampler) {
+            resampler.reset(new Resampler(buffer.format().sampleRate(), format.sampleRate()));
+            resampling.reset(new Resampler::Stream(*resampler, channels));
+        }
+
+        // Chaque tampon garde le format fourni par le décodeur, comme pour un son entier
+        chunk.data.clear();
+        chunk.pcm16.clear();
+        chunk.channels = 0;
+        appendBuffer(chunk, buffer);
+        resampling->push(chunk, converted);
+
+        return deliver();
+    }, &stopping, &error);
+
+    if (decoded == ChunkedDecoder::Failed) {
+        qDebug() << "ERREUR: Lecture en continu impossible" << filePath << ":" << error;
+    } else if (decoded == ChunkedDecoder::Finished && resampling) {
+        resampling->finish(converted);
+        deliver();
+    }
+
+    qDebug() << "Lecture en continu" << (interrupted() ? "interrompue:" : "décodée:") << filePath << ","
+             << stream.underruns() << "blocs incomplets";
+
+    // Voix arrêtée avant la fin: le flux revient à ce thread
+    if (!stream.finish()) {
+        std::shared_ptr<const AudioSample> head;
+        stream.recycle(head);
+    }
+}
+
+void AudioEngine::finishDecode(const QString &filePath, std::shared_ptr<const AudioSample> sample)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_decoding.remove(filePath);
+        if (sample) {
+            unbindEvictedLocked(m_cache.insert(filePath, sample));
+        }
+        bindPadsLocked(filePath, sample);
+    }
+
+    if (!sample) {
+        return;
+    }
+
+    const SampleCache::Stats stats = m_cache.stats();
+    qDebug() << "Cache des sons décodés:" << stats.samples << "sons," << stats.memoryUsage / (1024 * 1024)
+             << "/" << stats.budget / (1024 * 1024) << "Mo," << stats.hits << "succès," << stats.misses << "échecs";
+}
+
+void AudioEngine::bindPadsLocked(const QString &filePath, const std::shared_ptr<const AudioSample> &sample)
+{
+    // Un son nul abandonne les déclenchements en attente et signale leur fin
+    const float gain = sample ? normalizationGainLocked(filePath) : 1.0f;
+    for (auto it = m_padSounds.cbegin(); it != m_padSounds.cend(); ++it) {
+        if (it.value() == filePath && !m_mixer->bindPad(it.key(), sample, gain)) {
+            qDebug() << "AVERTISSEMENT: File de commandes du mixeur pleine, pad non associé:" << filePath;
+        }
+    }
+}
+
+float AudioEngine::normalizationGainLocked(const QString &filePath) const
+{
+    if (!m_normalize) {
+        return 1.0f;
+    }
+
+    LoudnessAnalyzer::Result loudness;
+    if (!LoudnessAnalyzer::instance()->lookup(filePath, loudness)) {
+        LoudnessAnalyzer::instance()->analyze(filePath);
+        return 1.0f;
+    }
+    if (!std::isfinite(loudness.integratedLoudness)) {
+        return 1.0f; // Son silencieux: rien à corriger
+    }
+
+    // Amener à la sonie visée sans dépasser le plafond de crête, dans des limites raisonnables
+    double gainDb = m_loudnessTarget - loudness.integratedLoudness;
+    if (std::isfinite(loudness.truePeak)) {
+        gainDb = qMin(gainDb, TruePeakCeiling - loudness.truePeak);
+    }
+    gainDb = qBound(-24.0, gainDb, 12.0);
+    return float(std::pow(10.0, gainDb / 20.0));
+}
+
+void AudioEngine::applyGainLocked(const QString &filePath)
+{
+    const float gain = normalizationGainLocked(filePath);
+    for (auto it = m_padSounds.cbegin(); it != m_padSounds.cend(); ++it) {
+        if (it.value() == filePath && !m_mixer->setPadGain(it.key(), gain)) {
+            qDebug() << "AVERTISSEMENT: File de commandes du mixeur pleine, gain non appliqué:" << filePath;
+        }
+    }
+}
+
+void AudioEngine::unbindEvictedLocked(const QStringList &evicted)
+{
+    // Les pads concernés réclameront leur son au prochain déclenchement
+    for (const QString &filePath : evicted) {
+        for (auto it = m_padSounds.cbegin(); it != m_padSounds.cend(); ++it) {
+            if (it.value() == filePath) {
+                m_mixer->unbindPad(it.key());
+            }
+        }
+    }
+}
+
+void AudioEngine::appendBuffer(AudioSample &sample, const QAudioBuffer &buffer)
+{
+    const QAudioFormat bufferFormat = buffer.format();
+    const int inputChannels = bufferFormat.channelCount();
+    const qint64 frames = buffer.frameCount();
+
+    if (!buffer.isValid() || inputChannels <= 0) {
+        return;
+    }
+
+    // Le premier tampon fixe la disposition: fréquence native, mono conservé tel quel,
+    // stéréo au-delà, et stockage 16 bits si le décodeur fournit des entiers 16 bits
+    const bool firstBuffer = sample.channels == 0;
+    if (firstBuffer) {
+        sample.channels = qMin(inputChannels, 2);
+        sample.sampleRate = bufferFormat.sampleRate();
+    } else if (bufferFormat.sampleRate() != sample.sampleRate) {
+        qDebug() << "AVERTISSEMENT: Fréquence décodée" << bufferFormat.sampleRate()
+                 << "différente du début du fichier" << sample.sampleRate;
+    }
+    const bool int16Storage = firstBuffer ? bufferFormat.sampleFormat() == QAudioFormat::Int16
+                                          : !sample.pcm16.isEmpty();
+    const qint64 samples = frames * sample.channels;
+
+    const qsizetype start = int16Storage ? sample.pcm16.size() : sample.data.size();
+    if (int16Storage) {
+        sample.pcm16.resize(start + samples);
+    } else {
+        sample.data.resize(start + samples);
+    }
+
+    // Cas courant: le décodeur fournit directement le format stocké
+    if (inputChannels == sample.channels) {
+        if (int16Storage && bufferFormat.sampleFormat() == QAudioFormat::Int16) {
+            std::copy_n(buffer.constData<qint16>(), samples, sample.pcm16.data() + start);
+            return;
+        }
+        if (!int16Storage && bufferFormat.sampleFormat() == QAudioFormat::Float) {
+            std::copy_n(buffer.constData<float>(), samples, sample.data.data() + start);
+            return;
+        }
+    }
+
+    // Sinon convertir échantillon par échantillon (canaux en trop ignorés)
+    const char *input = buffer.constData<char>();
+    const int bytesPerSample = bufferFormat.bytesPerSample();
+    for (qint64 frame = 0; frame < frames; ++frame) {
+        for (int channel = 0; channel < sample.channels; ++channel) {
+            const qint64 index = start + frame * sample.channels + channel;
+            const float value = bufferFormat.normalizedSampleValue(
+                input + (frame * inputChannels + channel) * bytesPerSample);
+            if (int16Storage) {
+                sample.pcm16[index] = qint16(qBound(-32768, qRound(value * 32767.0f), 32767));
+            } else {
+                sample.data[index] = value;
+            }
+        }
+    }
+}
+
+std::shared_ptr<AudioSample> AudioEngine::convertForOutput(std::shared_ptr<AudioSample> sample,
+                                                           const QAudioFormat &format)
+{
+    // Déjà au format des sons en cache
+    if (sample->sampleRate == format.sampleRate() && sample->isInt16()) {
+        return sample;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const Resampler resampler(sample->sampleRate, format.sampleRate());
+    std::shared_ptr<AudioSample> converted = resampler.process(*sample);
+
+    if (!resampler.isIdentity()) {
+        qDebug() << "Son converti de" << sample->sampleRate << "à" << format.sampleRate() << "Hz en"
+                 << timer.elapsed() << "ms";
+    }
+    return converted;
+}
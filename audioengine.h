@@ -0,0 +1,376 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QMutex>
+#include <QAudioFormat>
+#include <atomic>
+#include <memory>
+#include "audiosample.h"
+#include "audiomixer.h"
+#include "samplecache.h"
+
+class QThread;
+class QThreadPool;
+class QTimer;
+class QAudioSink;
+class QAudioBuffer;
+class AudioStream;
+
+/**
+ * @brief Moteur audio unique de l'application
+ *
+ * Un seul QAudioSink, ouvert en mode "pull" sur un AudioMixer, joue tous les sons de
+ * tous les pads. La sortie et le mixeur vivent seuls sur un thread de haute priorité,
+ * afin que le remplissage du tampon audio ne dépende pas de l'activité de l'interface.
+ * Le moteur lui-même reste sur le thread principal : c'est là que sont relevés les fins
+ * de lecture, les sons réclamés et les mesures, et libérés les sons abandonnés.
+ *
+ * Les sons sont décodés une fois en PCM (QAudioDecoder) par un groupe de threads de
+ * décodage, dès qu'un pad connaît son fichier ou qu'un fichier audio arrive dans
+ * l'AssetStore, puis convertis une fois à la fréquence de sortie par un Resampler
+ * polyphase ; un WAV déjà au format de mixage est simplement projeté en mémoire
+ * (MappedWav). Le résultat est conservé dans un SampleCache partagé par tous les pads
+ * et associé à chaque pad dans le mixeur (setPadSound()) ; un déclenchement se limite
+ * donc à déposer une commande dans la file sans verrou du mixeur, sans conversion ni
+ * recherche dans le cache. Un pad dont le son a été évincé du cache le réclame au
+ * moteur lors de son prochain déclenchement.
+ *
+ * Un fichier plus gros que le seuil de lecture en continu n'est décodé que sur ses
+ * premières millisecondes, gardées en cache pour un départ immédiat. Chaque voix qui
+ * le joue réserve un AudioStream du mixeur, rempli au fil de la lecture par un thread
+ * dédié qui décode et convertit la suite du fichier : la mémoire reste la même quelle
+ * que soit la durée du fichier.
+ *
+ * La sortie est ouverte avec le tampon demandé (setOutputConfig()) ; si le périphérique
+ * le refuse, le tampon est doublé jusqu'à être accepté, puis laissé au choix du
+ * périphérique en dernier recours. Le tampon est découpé en périodes, au début
+ * desquelles le mixeur prend en compte les déclenchements ; les manques et les
+ * dépassements des rappels sont comptés (outputStats()).
+ *
+ * Un son peut être visé à un instant précis (playAt()), et plusieurs pads peuvent être
+ * joués ensemble en une seule commande (playGroup()) : le mixeur les place à
+ * l'échantillon près, quel que soit le découpage des blocs.
+ *
+ * Chaque pad reçoit un gain de normalisation qui amène son son à la sonie visée, sans
+ * que sa crête vraie dépasse TruePeakCeiling. Les mesures viennent du LoudnessAnalyzer ;
+ * un son pas encore mesuré est joué à son niveau d'origine, puis corrigé dès que sa
+ * mesure arrive.
+ */
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const qint64 DefaultStreamingThreshold = 8LL * 1024 * 1024; ///< Taille lue en continu par défaut
+    static const int DefaultStreamingHead = 500;                        ///< Tête décodée d'avance par défaut (ms)
+    static constexpr double DefaultLoudnessTarget = -16.0;              ///< Sonie visée par défaut (LUFS)
+    static constexpr double TruePeakCeiling = -1.0;                     ///< Crête vraie maximale après normalisation (dBTP)
+    static constexpr double DefaultOutputBuffer = 10.0;                 ///< Tampon de sortie par défaut (ms)
+    static const int DefaultOutputPeriods = 2;                          ///< Périodes par tampon de sortie par défaut
+    static constexpr double MinOutputBuffer = 1.0;                      ///< Plus petit tampon de sortie accepté (ms)
+    static constexpr double MaxOutputBuffer = 200.0;                    ///< Plus grand tampon de sortie accepté (ms)
+    static const int MaxOutputPeriods = 8;                              ///< Nombre maximal de périodes par tampon
+    static const int MinPeriodFrames = 32;                              ///< Plus petite période de mixage (trames)
+
+    /**
+     * @brief Obtient l'instance partagée par toute l'application
+     * @return Instance unique
+     */
+    static AudioEngine *instance();
+
+    /**
+     * @brief Obtient le format de sortie utilisé pour le mixage
+     * @return Format du QAudioSink (flottants, stéréo)
+     */
+    QAudioFormat format() const { return m_format; }
+
+    /**
+     * @brief Lance le décodage d'un son en arrière-plan s'il n'est pas déjà disponible
+     * @param filePath Chemin du fichier audio
+     */
+    void preload(const QString &filePath);
+
+    /**
+     * @brief Définit le son joué par un pad et le prépare en arrière-plan
+     * @param padKey Identifiant du pad
+     * @param filePath Chemin du fichier audio
+     */
+    void setPadSound(quintptr padKey, const QString &filePath);
+
+    /**
+     * @brief Arrête et oublie un pad
+     * @param padKey Identifiant du pad
+     */
+    void removePad(quintptr padKey);
+
+    /**
+     * @brief Joue le son d'un pad
+     * @details Sans verrou ni allocation: peut être appelé depuis n'importe quel thread. Si le
+     *          son n'est pas encore décodé, il sera joué dès la fin du décodage.
+     * @param padKey Identifiant du pad qui déclenche le son
+     * @param restart Si true, une lecture en cours pour ce pad est relancée au début
+     * @param gain Gain linéaire de la voix
+     * @param pan Panoramique, de -1 (gauche) à 1 (droite)
+     * @param inputTime Réception du clic ou de la touche (LatencyMonitor::now()) ; 0 pour ne
+     *                  pas mesurer la latence de ce déclenchement
+     */
+    void play(quintptr padKey, bool restart, float gain = 1.0f, float pan = 0.0f, qint64 inputTime = 0);
+
+    /**
+     * @brief Joue le son d'un pad de façon à ce qu'il soit entendu à un instant précis
+     * @details La durée du tampon de sortie est déduite : le son est mixé d'autant plus tôt.
+     *          Un instant déjà trop proche pour être tenu est rattrapé : le son démarre à la
+     *          position où il en serait, ou n'est pas joué s'il serait déjà fini. Sans verrou
+     *          ni allocation, comme play().
+     * @param padKey Identifiant du pad qui déclenche le son
+     * @param restart Si true, une lecture en cours pour ce pad est relancée au début
+     * @param time Instant où le son doit être entendu (LatencyMonitor::now())
+     * @param gain Gain linéaire de la voix
+     * @param pan Panoramique, de -1 (gauche) à 1 (droite)
+     */
+    void playAt(quintptr padKey, bool restart, qint64 time, float gain = 1.0f, float pan = 0.0f);
+
+    /**
+     * @brief Pad d'un groupe joué d'un seul bloc (playGroup())
+     */
+    struct GroupMember {
+        quintptr padKey = 0;    ///< Pad joué
+        bool restart = false;   ///< Relancer la lecture en cours du pad
+        float gain = 1.0f;      ///< Gain linéaire de la voix
+        int offset = 0;         ///< Décalage après le départ du groupe (ms)
+    };
+
+    /**
+     * @brief Joue plusieurs pads ensemble, chacun à son décalage exact
+     * @details Le groupe est transmis au mixeur en une seule commande : toutes les voix
+     *          partent du même bloc, à l'échantillon près. Au-delà de AudioMixer::MaxGroupMembers
+     *          pads, les suivants sont ignorés.
+     * @param members Pads du groupe
+     * @param time Instant où le groupe doit être entendu (LatencyMonitor::now()) ; 0 pour
+     *             jouer tout de suite
+     * @param inputTime Réception du clic ou de la touche, 0 si non mesuré
+     */
+    void playGroup(const QVector<GroupMember> &members, qint64 time = 0, qint64 inputTime = 0);
+
+    /**
+     * @brief Arrête les sons d'un pad
+     * @param padKey Identifiant du pad
+     */
+    void stop(quintptr padKey);
+
+    /**
+     * @brief Définit le nombre maximal de voix simultanées d'un pad à lecture multiple
+     * @param voices Nombre de voix
+     */
+    void setMaxPolyphony(int voices);
+
+    /**
+     * @brief Définit la voix interrompue lorsque la polyphonie est atteinte
+     * @param policy Politique de vol de voix
+     */
+    void setStealPolicy(AudioMixer::StealPolicy policy);
+
+    /**
+     * @brief Définit la mémoire maximale occupée par les sons décodés
+     * @param bytes Budget en octets
+     */
+    void setSampleCacheBudget(qint64 bytes);
+
+    /**
+     * @brief Obtient les statistiques du cache des sons décodés
+     * @return Taille, budget et compteurs de succès/échecs
+     */
+    SampleCache::Stats sampleCacheStats() const { return m_cache.stats(); }
+
+    /**
+     * @brief Définit la taille de fichier à partir de laquelle un son est lu en continu
+     * @details S'applique aux sons décodés ensuite.
+     * @param bytes Taille du fichier en octets (0: jamais de lecture en continu)
+     */
+    void setStreamingThreshold(qint64 bytes);
+
+    /**
+     * @brief Définit la durée décodée d'avance d'un son lu en continu
+     * @param milliseconds Durée de la tête, jouée pendant que la suite se décode
+     */
+    void setStreamingHead(int milliseconds);
+
+    /**
+     * @brief Obtient les compteurs de la lecture en continu
+     * @return Manques de données et voix sans flux libre
+     */
+    AudioMixer::StreamStats streamStats() const { return m_mixer->streamStats(); }
+
+    /**
+     * @brief Définit le tampon de la sortie audio et la rouvre si besoin
+     * @details Les valeurs hors limites sont ramenées dans les bornes acceptées.
+     * @param bufferMilliseconds Durée du tampon du périphérique (ms)
+     * @param periods Nombre de périodes de mixage par tampon
+     */
+    void setOutputConfig(double bufferMilliseconds, int periods);
+
+    /**
+     * @brief Obtient les compteurs des rappels de la sortie audio
+     * @return Rappels, manques, dépassements et rappel le plus long
+     */
+    OutputStats outputStats() const { return m_mixer->outputStats(); }
+
+    /**
+     * @brief Obtient la latence de la sortie audio, entre le mixage et l'écoute
+     * @return Durée du tampon ouvert (ns), 0 tant que la sortie n'est pas ouverte
+     */
+    qint64 outputLatency() const { return m_mixer->outputLatency(); }
+
+    /**
+     * @brief Active la normalisation de la sonie des pads
+     * @param enabled Si false, chaque son est joué à son niveau d'origine
+     * @param targetLufs Sonie intégrée visée (LUFS)
+     */
+    void setLoudnessNormalization(bool enabled, double targetLufs);
+
+    /**
+     * @brief Ajoute un tampon décodé à un son, au format natif du fichier
+     * @details Le premier tampon fixe la fréquence et le nombre de canaux (au plus deux) ;
+     *          un son dont channels vaut 0 est donc prêt à recevoir un nouveau fichier.
+     * @param sample Son en cours de décodage
+     * @param buffer Tampon fourni par le décodeur
+     */
+    static void appendBuffer(AudioSample &sample, const QAudioBuffer &buffer);
+
+signals:
+    /**
+     * @brief Signal émis lorsqu'un pad n'a plus aucun son en cours de lecture
+     * @param padKey Identifiant du pad
+     */
+    void padStopped(quintptr padKey);
+
+private slots:
+    /**
+     * @brief Transmet les fins de lecture signalées par le mixeur, fournit les sons réclamés,
+     *        démarre les flux demandés et relève les mesures de latence
+     */
+    void pollFinished();
+
+private:
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit AudioEngine(QObject *parent = nullptr);
+
+    QThread *m_thread;                                          // Thread temps réel de la sortie
+    QObject *m_output;                                          // Contexte de la sortie et du mixeur, sur m_thread
+    QAudioSink *m_sink;                                         // Sortie audio unique
+    AudioMixer *m_mixer;                                        // Mixeur lu par la sortie
+    QTimer *m_finishedTimer;                                    // Relève des fins de lecture
+    QAudioFormat m_format;                                      // Format de sortie
+    QThreadPool *m_decodePool;                                  // Threads de décodage
+    QThreadPool *m_streamPool;                                  // Threads de lecture en continu
+    SampleCache m_cache;                                        // Sons décodés par chemin
+    QSet<QString> m_decoding;                                   // Sons en cours de décodage
+    QHash<quintptr, QString> m_padSounds;                       // Son de chaque pad
+    qint64 m_streamingThreshold;                                // Taille de fichier lue en continu (octets)
+    int m_streamingHead;                                        // Tête décodée d'avance (ms)
+    quint64 m_reportedUnderruns;                                // Manques de données déjà signalés
+    std::atomic<bool> m_stopping;                               // Fermeture en cours: interrompre les flux
+    double m_outputBuffer;                                      // Tampon de sortie demandé (ms)
+    int m_outputPeriods;                                        // Périodes par tampon demandées
+    double m_openedBuffer;                                      // Tampon demandé lors de la dernière ouverture (ms)
+    int m_openedPeriods;                                        // Périodes lors de la dernière ouverture
+    OutputStats m_reportedOutput;                               // Compteurs de sortie déjà signalés
+    bool m_normalize;                                           // Normalisation de la sonie active
+    double m_loudnessTarget;                                    // Sonie visée (LUFS)
+    mutable QMutex m_mutex;                                     // Protège les décodages, les sons des pads et les réglages
+
+    /**
+     * @brief Ouvre ou rouvre la sortie audio avec la configuration demandée (thread de la sortie)
+     */
+    void openOutput();
+
+    /**
+     * @brief Ferme la sortie audio et le mixeur (thread de la sortie)
+     */
+    void shutdown();
+
+    /**
+     * @brief Décode un fichier audio (thread de décodage)
+     * @details Le décodeur tourne dans une boucle d'événements locale au thread appelant
+     *          (ChunkedDecoder).
+     * @param filePath Chemin du fichier
+     * @param format Format de sortie souhaité
+     * @param stopping Indicateur de fermeture de l'application
+     * @param headMilliseconds Si non nul, seul le début du fichier est décodé et le son
+     *                         retourné est marqué pour la lecture en continu
+     * @return Son décodé, ou nullptr en cas d'échec ou d'interruption
+     */
+    static std::shared_ptr<const AudioSample> decodeFile(const QString &filePath, const QAudioFormat &format,
+                                                         const std::atomic<bool> &stopping,
+                                                         int headMilliseconds = 0);
+
+    /**
+     * @brief Confie un flux réservé par le mixeur à un thread de lecture en continu
+     * @param stream Flux à remplir
+     */
+    void startStream(AudioStream *stream);
+
+    /**
+     * @brief Décode la suite d'un son lu en continu dans le tampon de son flux (thread de lecture)
+     * @details Le fichier est décodé depuis le début et converti par un Resampler::Stream ;
+     *          les trames de la tête sont écartées. L'écriture attend tant que le tampon est plein.
+     * @param stream Flux démarré
+     * @param format Format de sortie
+     * @param stopping Indicateur de fermeture de l'application
+     */
+    static void decodeStream(AudioStream &stream, const QAudioFormat &format, const std::atomic<bool> &stopping);
+
+    /**
+     * @brief Convertit un son décodé au format des sons en cache (thread de décodage)
+     * @details Fréquence de sortie, échantillons 16 bits ; le nombre de canaux est conservé.
+     * @param sample Son au format natif du fichier
+     * @param format Format de sortie
+     * @return Son prêt à être mixé
+     */
+    static std::shared_ptr<AudioSample> convertForOutput(std::shared_ptr<AudioSample> sample,
+                                                         const QAudioFormat &format);
+
+    /**
+     * @brief Associe dans le mixeur un son à tous les pads qui le jouent (verrou tenu)
+     * @param filePath Chemin du fichier
+     * @param sample Son décodé, ou nullptr en cas d'échec
+     */
+    void bindPadsLocked(const QString &filePath, const std::shared_ptr<const AudioSample> &sample);
+
+    /**
+     * @brief Calcule le gain de normalisation d'un son (verrou tenu)
+     * @details Lance l'analyse du fichier s'il n'est pas encore mesuré.
+     * @param filePath Chemin du fichier
+     * @return Gain linéaire, 1 si la normalisation est inactive ou le son pas encore mesuré
+     */
+    float normalizationGainLocked(const QString &filePath) const;
+
+    /**
+     * @brief Applique le gain de normalisation d'un son à tous les pads qui le jouent (verrou tenu)
+     * @param filePath Chemin du fichier
+     */
+    void applyGainLocked(const QString &filePath);
+
+    /**
+     * @brief Oublie dans le mixeur les sons évincés du cache (verrou tenu)
+     * @param evicted Chemins des sons évincés
+     */
+    void unbindEvictedLocked(const QStringList &evicted);
+
+    /**
+     * @brief Publie un son décodé et l'associe aux pads qui le jouent
+     * @param filePath Chemin du fichier
+     * @param sample Son décodé, ou nullptr en cas d'échec
+     */
+    void finishDecode(const QString &filePath, std::shared_ptr<const AudioSample> sample);
+};
+
+#endif // AUDIOENGINE_H
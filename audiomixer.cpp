@@ -0,0 +1,843 @@
+#include "audiomixer.h"
+#include <QHash>
+#include <algorithm>
+#include <cstring>
+
+AudioMixer::AudioMixer(int channels, QObject *parent)
+    : QIODevice(parent)
+    , m_channels(channels)
+    , m_padCount(0)
+    , m_reservedPads(InitialPads)
+    , m_blockStart(0)
+    , m_startCounter(0)
+    , m_framePosition(0)
+    , m_maxPolyphony(8)
+    , m_stealPolicy(StealOldest)
+    , m_streamUnderruns(0)
+    , m_streamsUnavailable(0)
+    , m_periodFrames(0)
+    , m_bufferDuration(0)
+    , m_timingChanged(false)
+    , m_sampleRate(0)
+    , m_originTime(0)
+    , m_lastCallback(0)
+    , m_callbacks(0)
+    , m_outputUnderruns(0)
+    , m_callbackOverruns(0)
+    , m_maxCallback(0)
+    , m_scheduledCount(0)
+    , m_kernels(MixKernels::active())
+{
+    // Les voix et la table des pads sont dimensionnées une fois pour toutes
+    m_voices.resize(MaxVoices);
+    for (Voice &voice : m_voices) {
+        voice.padKey = 0;
+        voice.position = 0;
+        voice.delay = 0;
+        voice.skip = 0;
+        voice.endFrame = 0;
+        voice.startedAt = 0;
+        voice.level = 0.0f;
+        voice.gainLeft = 1.0f;
+        voice.gainRight = 1.0f;
+        voice.inputTime = 0;
+        voice.dispatchTime = 0;
+        voice.stream = nullptr;
+    }
+    m_pads.resize(2 * InitialPads);
+}
+
+void AudioMixer::reservePads(int pads)
+{
+    if (pads <= m_reservedPads) {
+        return;
+    }
+
+    int capacity = m_reservedPads;
+    while (capacity < pads) {
+        capacity *= 2;
+    }
+
+    // File pleine (sortie arrêtée): réessayé au prochain appel
+    QVector<PadSlot> table(2 * capacity);
+    if (m_tables.push(std::move(table))) {
+        m_reservedPads = capacity;
+    }
+}
+
+bool AudioMixer::bindPad(quintptr padKey, std::shared_ptr<const AudioSample> sample, float gain)
+{
+    Command command;
+    command.type = Command::Bind;
+    command.padKey = padKey;
+    command.gain = gain;
+    command.sample = std::move(sample);
+    return m_commands.push(std::move(command));
+}
+
+bool AudioMixer::setPadGain(quintptr padKey, float gain)
+{
+    Command command;
+    command.type = Command::Gain;
+    command.padKey = padKey;
+    command.gain = gain;
+    return m_commands.push(std::move(command));
+}
+
+bool AudioMixer::unbindPad(quintptr padKey)
+{
+    Command command;
+    command.type = Command::Unbind;
+    command.padKey = padKey;
+    return m_commands.push(std::move(command));
+}
+
+bool AudioMixer::trigger(quintptr padKey, bool restart, float gain, float pan, qint64 startFrame,
+                         qint64 inputTime)
+{
+    Command command;
+    command.type = Command::Trigger;
+    command.padKey = padKey;
+    command.restart = restart;
+    command.gain = gain;
+    command.pan = qBound(-1.0f, pan, 1.0f);
+    command.startFrame = startFrame;
+    command.inputTime = inputTime;
+
+    // File pleine: ignorer plutôt que d'attendre ou d'allouer
+    return m_commands.push(std::move(command));
+}
+
+bool AudioMixer::triggerGroup(const GroupMember *members, int count, qint64 startFrame, qint64 inputTime)
+{
+    if (count <= 0 || count > MaxGroupMembers) {
+        return false;
+    }
+
+    Command command;
+    command.type = Command::Group;
+    command.startFrame = startFrame;
+    command.inputTime = inputTime;
+    command.memberCount = count;
+    std::copy(members, members + count, command.members);
+
+    return m_commands.push(std::move(command));
+}
+
+bool AudioMixer::stop(quintptr padKey)
+{
+    Command command;
+    command.type = Command::Stop;
+    command.padKey = padKey;
+    return m_commands.push(std::move(command));
+}
+
+void AudioMixer::setMaxPolyphony(int voices)
+{
+    m_maxPolyphony.store(qBound(1, voices, int(MaxVoices)), std::memory_order_relaxed);
+}
+
+void AudioMixer::setStealPolicy(StealPolicy policy)
+{
+    m_stealPolicy.store(policy, std::memory_order_relaxed);
+}
+
+void AudioMixer::takeFinished(QVector<quintptr> &padKeys)
+{
+    quintptr padKey;
+    while (m_finished.pop(padKey)) {
+        padKeys.append(padKey);
+    }
+}
+
+void AudioMixer::takeMissing(QVector<quintptr> &padKeys)
+{
+    quintptr padKey;
+    while (m_missing.pop(padKey)) {
+        padKeys.append(padKey);
+    }
+}
+
+void AudioMixer::takeReleased()
+{
+    std::shared_ptr<const AudioSample> sample;
+    while (m_released.pop(sample)) {
+        sample.reset();
+    }
+
+    QVector<PadSlot> table;
+    while (m_retiredTables.pop(table)) {
+        table = QVector<PadSlot>();
+    }
+}
+
+AudioMixer::StreamStats AudioMixer::streamStats() const
+{
+    StreamStats stats;
+    stats.underruns = m_streamUnderruns.load(std::memory_order_relaxed);
+    stats.unavailable = m_streamsUnavailable.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AudioMixer::setOutputTiming(qint64 bufferFrames, qint64 periodFrames, int sampleRate)
+{
+    m_periodFrames.store(qMax<qint64>(0, periodFrames), std::memory_order_relaxed);
+    m_bufferDuration.store(sampleRate > 0 ? bufferFrames * 1000000000 / sampleRate : 0, std::memory_order_relaxed);
+    m_sampleRate.store(sampleRate, std::memory_order_relaxed);
+    m_timingChanged.store(true, std::memory_order_release);
+}
+
+OutputStats AudioMixer::outputStats() const
+{
+    OutputStats stats;
+    stats.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    stats.underruns = m_outputUnderruns.load(std::memory_order_relaxed);
+    stats.overruns = m_callbackOverruns.load(std::memory_order_relaxed);
+    stats.maxCallback = m_maxCallback.load(std::memory_order_relaxed);
+    return stats;
+}
+
+qint64 AudioMixer::bytesAvailable() const
+{
+    // Le mixeur produit du silence à la demande: il a toujours des données à fournir
+    return QIODevice::bytesAvailable() + 1024 * 1024;
+}
+
+qint64 AudioMixer::readData(char *data, qint64 maxSize)
+{
+    const qint64 callbackStart = LatencyMonitor::now();
+    const qint64 bufferDuration = m_bufferDuration.load(std::memory_order_relaxed);
+    const int sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+
+    // Rappel plus tardif que la durée du tampon: le périphérique a joué du silence entre-temps
+    if (m_timingChanged.exchange(false, std::memory_order_acquire)) {
+        m_lastCallback = 0;
+    }
+    if (m_lastCallback > 0 && bufferDuration > 0 && callbackStart - m_lastCallback > bufferDuration) {
+        m_outputUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_lastCallback = callbackStart;
+
+    const qint64 frameBytes = qint64(sizeof(float)) * m_channels;
+    const qint64 frames = maxSize / frameBytes;
+    float *output = reinterpret_cast<float*>(data);
+
+    // Une période à la fois: les commandes arrivées entre-temps partent dès la suivante
+    const qint64 periodFrames = m_periodFrames.load(std::memory_order_relaxed);
+    qint64 done = 0;
+    while (done < frames) {
+        const qint64 count = periodFrames > 0 ? qMin(periodFrames, frames - done) : frames - done;
+        mixPeriod(output + done * m_channels, count);
+        done += count;
+    }
+
+    // Mixage plus long que le son produit: le tampon du périphérique se vide plus vite qu'il
+    // n'est rempli. Un rappel qui demande plusieurs périodes dispose d'autant de temps
+    const qint64 duration = LatencyMonitor::now() - callbackStart;
+    const qint64 producedDuration = sampleRate > 0 ? frames * 1000000000 / sampleRate : 0;
+    if (producedDuration > 0 && duration > producedDuration) {
+        m_callbackOverruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (duration > m_maxCallback.load(std::memory_order_relaxed)) {
+        m_maxCallback.store(duration, std::memory_order_relaxed);
+    }
+    m_callbacks.fetch_add(1, std::memory_order_relaxed);
+
+    // Tampon plein: sa dernière trame sera entendue une durée de tampon plus tard
+    if (sampleRate > 0) {
+        // Secondes et reste séparés: le produit ne déborde pas, même après des jours de lecture
+        const qint64 produced = m_framePosition.load(std::memory_order_relaxed);
+        const qint64 producedTime = produced / sampleRate * 1000000000
+                                    + produced % sampleRate * 1000000000 / sampleRate;
+        m_originTime.store(callbackStart + duration + bufferDuration - producedTime, std::memory_order_relaxed);
+    }
+
+    return frames * frameBytes;
+}
+
+qint64 AudioMixer::frameAt(qint64 time) const
+{
+    const qint64 origin = m_originTime.load(std::memory_order_relaxed);
+    const int sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+    if (origin == 0 || sampleRate <= 0) {
+        return 0;
+    }
+    const qint64 elapsed = time - origin;
+    if (elapsed <= 0) {
+        return 0;
+    }
+    return elapsed / 1000000000 * sampleRate + elapsed % 1000000000 * sampleRate / 1000000000;
+}
+
+void AudioMixer::mixPeriod(float *output, qint64 frames)
+{
+    m_blockStart = m_framePosition.load(std::memory_order_relaxed);
+    applyCommands(frames);
+
+    const qint64 samples = frames * m_channels;
+
+    std::memset(output, 0, size_t(samples) * sizeof(float));
+
+    // Mesures des voix horodatées dont la première trame est écrite dans ce bloc
+    LatencySample latencies[MaxVoices];
+    int latencyCount = 0;
+
+    for (Voice &voice : m_voices) {
+        if (!voice.sample) {
+            continue;
+        }
+
+        // Voix relancée par un départ programmé: elle s'arrête à la trame de ce départ
+        qint64 limit = frames;
+        if (voice.endFrame > 0) {
+            limit = qBound<qint64>(0, voice.endFrame - m_blockStart, frames);
+        }
+
+        // Voix programmée plus tard: avancer jusqu'à sa trame de départ
+        qint64 offset = 0;
+        if (voice.delay > 0) {
+            offset = qMin(voice.delay, frames);
+            voice.delay -= offset;
+            if (offset == frames && limit == frames) {
+                continue;
+            }
+        }
+        if (offset >= limit) {
+            releaseVoice(voice);
+            continue;
+        }
+
+        // Additionner la portion restante du son dans le bus de sortie stéréo
+        const AudioSample &sample = *voice.sample;
+        const bool stereo = sample.channels == 2;
+        qint64 remaining = limit - offset;
+        voice.level = 0.0f;
+
+        if (voice.position < sample.frameCount()) {
+            const qint64 count = qMin(remaining, sample.frameCount() - voice.position);
+            voice.level = m_kernels.mix[sample.isInt16()][stereo](output + offset * m_channels,
+                                                                  sample.samplesAt(voice.position), count,
+                                                                  voice.gainLeft, voice.gainRight);
+            voice.position += count;
+            offset += count;
+            remaining -= count;
+        }
+
+        // Après la tête d'un son lu en continu: enchaîner sur le tampon du flux
+        if (voice.stream) {
+            // Départ rattrapé au-delà de la tête: jeter les trames qui auraient déjà été entendues
+            while (voice.skip > 0) {
+                qint64 count = voice.skip;
+                voice.stream->readPointer(count);
+                if (count == 0) {
+                    break;
+                }
+                voice.stream->consume(count);
+                voice.skip -= count;
+                voice.position += count;
+            }
+
+            while (remaining > 0 && voice.skip == 0) {
+                qint64 count = remaining;
+                const qint16 *input = voice.stream->readPointer(count);
+                if (count == 0) {
+                    break;
+                }
+                voice.level = qMax(voice.level, m_kernels.mix[true][stereo](output + offset * m_channels, input, count,
+                                                                            voice.gainLeft, voice.gainRight));
+                voice.stream->consume(count);
+                voice.position += count;
+                offset += count;
+                remaining -= count;
+            }
+
+            // Décodage en retard: le reste du bloc est silencieux, la voix reprendra où elle en est
+            if (remaining > 0 && voice.skip == 0 && !voice.stream->atEnd()) {
+                voice.stream->countUnderrun();
+                m_streamUnderruns.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (voice.inputTime > 0) {
+            LatencySample &latency = latencies[latencyCount++];
+            latency.padKey = voice.padKey;
+            latency.inputTime = voice.inputTime;
+            latency.dispatchTime = voice.dispatchTime;
+            voice.inputTime = 0;
+        }
+
+        // Libérer la voix à la fin du son ou à sa trame d'arrêt
+        const bool ended = voice.stream ? voice.stream->atEnd() : voice.position >= sample.frameCount();
+        if (ended || limit < frames) {
+            releaseVoice(voice);
+        }
+    }
+
+    // Écrêtage doux de la somme
+    m_kernels.softClip(output, samples);
+
+    // Le bloc est prêt à partir vers le périphérique: dater la première trame des nouvelles voix
+    if (latencyCount > 0) {
+        const qint64 outputTime = LatencyMonitor::now();
+        for (int i = 0; i < latencyCount; ++i) {
+            latencies[i].outputTime = outputTime;
+            m_latencies.push(latencies[i]);
+        }
+    }
+
+    m_framePosition.store(m_blockStart + frames, std::memory_order_relaxed);
+}
+
+qint64 AudioMixer::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+void AudioMixer::applyCommands(qint64 frames)
+{
+    const qint64 blockEnd = m_blockStart + frames;
+
+    adoptTables();
+
+    Command command;
+    qint64 dispatchTime = 0;
+    while (m_commands.pop(command)) {
+        // Un seul relevé d'horloge par bloc, et seulement s'il y a des commandes
+        if (dispatchTime == 0) {
+            dispatchTime = LatencyMonitor::now();
+        }
+        command.dispatchTime = dispatchTime;
+
+        switch (command.type) {
+        case Command::Bind: {
+            PadSlot *pad = findPad(command.padKey, true);
+            if (!pad) {
+                m_finished.push(command.padKey);
+                retireSample(command.sample);
+                break;
+            }
+            retireSample(pad->sample);
+            pad->sample = std::move(command.sample);
+            pad->gain = command.gain;
+
+            // Jouer le déclenchement qui attendait ce son, ou l'abandonner si le décodage a échoué
+            if (pad->hasPending) {
+                pad->hasPending = false;
+                if (pad->sample) {
+                    startVoice(pad->pending, *pad);
+                } else {
+                    m_finished.push(command.padKey);
+                }
+            }
+            break;
+        }
+
+        case Command::Unbind: {
+            PadSlot *pad = findPad(command.padKey, false);
+            if (cancelScheduled(command.padKey) && !(pad && pad->hasPending)) {
+                m_finished.push(command.padKey);
+            }
+            if (pad) {
+                if (pad->hasPending) {
+                    m_finished.push(command.padKey);
+                }
+                retireSample(pad->sample);
+                pad->hasPending = false;
+                pad->padKey = RemovedKey;
+                m_padCount--;
+            }
+            break;
+        }
+
+        case Command::Stop: {
+            PadSlot *pad = findPad(command.padKey, false);
+            if (pad) {
+                pad->hasPending = false;
+            }
+            cancelScheduled(command.padKey);
+            stopVoices(command.padKey);
+            m_finished.push(command.padKey);
+            break;
+        }
+
+        case Command::Trigger:
+            // Départ après cette période: attendre sans occuper de voix ni relancer celles du pad
+            if (command.startFrame >= blockEnd && schedule(command)) {
+                break;
+            }
+            applyTrigger(command);
+            break;
+
+        case Command::Group: {
+            // Un seul départ pour tout le groupe, fixé ici: chaque membre tombe à son décalage exact
+            // (un départ déjà passé est rattrapé par chaque membre, comme un déclenchement seul)
+            const qint64 groupStart = command.startFrame > 0 ? command.startFrame : m_blockStart;
+            for (int i = 0; i < command.memberCount; ++i) {
+                const GroupMember &member = command.members[i];
+                Command trigger;
+                trigger.type = Command::Trigger;
+                trigger.padKey = member.padKey;
+                trigger.restart = member.restart;
+                trigger.gain = member.gain;
+                trigger.startFrame = groupStart + qMax<qint64>(0, member.offset);
+                trigger.inputTime = i == 0 ? command.inputTime : 0;   // Une seule mesure par groupe
+                trigger.dispatchTime = command.dispatchTime;
+
+                if (trigger.startFrame >= blockEnd && schedule(trigger)) {
+                    continue;
+                }
+                applyTrigger(trigger);
+            }
+            break;
+        }
+
+        case Command::Gain: {
+            // Les voix déjà lancées gardent leur gain: seul le prochain déclenchement change
+            PadSlot *pad = findPad(command.padKey, false);
+            if (pad) {
+                pad->gain = command.gain;
+            }
+            break;
+        }
+        }
+    }
+
+    // Départs programmés dont la trame tombe dans cette période, dans l'ordre des trames
+    auto later = [](const Command &a, const Command &b) { return a.startFrame > b.startFrame; };
+    while (m_scheduledCount > 0 && m_scheduled[0].startFrame < blockEnd) {
+        std::pop_heap(m_scheduled, m_scheduled + m_scheduledCount, later);
+        --m_scheduledCount;
+        applyTrigger(m_scheduled[m_scheduledCount]);
+    }
+}
+
+void AudioMixer::applyTrigger(const Command &command)
+{
+    PadSlot *pad = findPad(command.padKey, true);
+    if (!pad) {
+        m_finished.push(command.padKey);
+        return;
+    }
+
+    // Son pas encore associé: garder le déclenchement et le réclamer au moteur
+    if (!pad->sample) {
+        pad->pending = command;
+        pad->hasPending = true;
+        m_missing.push(command.padKey);
+        return;
+    }
+
+    startVoice(command, *pad);
+}
+
+bool AudioMixer::schedule(Command &command)
+{
+    // File pleine: la voix démarre tout de suite, retardée de son décalage comme avant
+    if (m_scheduledCount >= MaxScheduled) {
+        return false;
+    }
+
+    auto later = [](const Command &a, const Command &b) { return a.startFrame > b.startFrame; };
+    m_scheduled[m_scheduledCount] = std::move(command);
+    ++m_scheduledCount;
+    std::push_heap(m_scheduled, m_scheduled + m_scheduledCount, later);
+    return true;
+}
+
+bool AudioMixer::cancelScheduled(quintptr padKey)
+{
+    const int count = m_scheduledCount;
+    m_scheduledCount = int(std::remove_if(m_scheduled, m_scheduled + m_scheduledCount, [padKey](const Command &command) {
+        return command.padKey == padKey;
+    }) - m_scheduled);
+    if (m_scheduledCount == count) {
+        return false;
+    }
+
+    auto later = [](const Command &a, const Command &b) { return a.startFrame > b.startFrame; };
+    std::make_heap(m_scheduled, m_scheduled + m_scheduledCount, later);
+    return true;
+}
+
+bool AudioMixer::hasScheduled(quintptr padKey) const
+{
+    for (int i = 0; i < m_scheduledCount; ++i) {
+        if (m_scheduled[i].padKey == padKey) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioMixer::startVoice(const Command &command, const PadSlot &pad)
+{
+    const std::shared_ptr<const AudioSample> &sample = pad.sample;
+
+    // Départ déjà passé (déclenchement distant reçu en retard): reprendre là où le son en
+    // serait, pour rester aligné avec les autres pairs, ou l'ignorer s'il serait déjà fini
+    const qint64 late = command.startFrame > 0 && command.startFrame < m_blockStart
+        ? m_blockStart - command.startFrame : 0;
+    if (late > 0 && !sample->isStreamed() && late >= sample->frameCount()) {
+        // Aucune voix ne démarre: le pad ne s'est tu que s'il ne joue rien d'autre
+        for (const Voice &other : m_voices) {
+            if (other.sample && other.padKey == command.padKey) {
+                return;
+            }
+        }
+        if (!hasScheduled(command.padKey)) {
+            m_finished.push(command.padKey);
+        }
+        return;
+    }
+
+    // Relance: libérer les voix existantes du pad, ou les arrêter à la trame du départ programmé
+    const qint64 delay = command.startFrame > m_blockStart ? command.startFrame - m_blockStart : 0;
+    if (command.restart && delay > 0) {
+        for (Voice &other : m_voices) {
+            if (other.sample && other.padKey == command.padKey
+                && (other.endFrame == 0 || other.endFrame > command.startFrame)) {
+                other.endFrame = command.startFrame;
+            }
+        }
+    } else if (command.restart) {
+        stopVoices(command.padKey);
+    }
+
+    Voice &voice = allocateVoice(command.padKey);
+    releaseStream(voice);
+    retireSample(voice.sample);
+    voice.sample = sample;
+    voice.padKey = command.padKey;
+    voice.position = qMin(late, sample->frameCount());
+    voice.skip = late - voice.position;
+    voice.delay = delay;
+    voice.endFrame = 0;
+    voice.startedAt = ++m_startCounter;
+    voice.level = 1.0f; // Une voix qui démarre n'est jamais la plus discrète
+    voice.inputTime = command.inputTime;
+    voice.dispatchTime = command.dispatchTime;
+
+    // Panoramique linéaire: le canal opposé est atténué, le canal du côté choisi garde le gain
+    const float gain = command.gain * pad.gain;
+    voice.gainLeft = gain * (command.pan > 0.0f ? 1.0f - command.pan : 1.0f);
+    voice.gainRight = gain * (command.pan < 0.0f ? 1.0f + command.pan : 1.0f);
+
+    if (sample->isStreamed()) {
+        claimStream(voice);
+    }
+}
+
+void AudioMixer::stopVoices(quintptr padKey)
+{
+    for (Voice &voice : m_voices) {
+        if (voice.sample && voice.padKey == padKey) {
+            releaseStream(voice);
+            retireSample(voice.sample);
+            voice.padKey = 0;
+        }
+    }
+}
+
+AudioMixer::PadSlot *AudioMixer::findPad(quintptr padKey, bool create)
+{
+    // Adressage ouvert avec sondage linéaire; les cases libérées sont réutilisées à l'insertion
+    const int tableSize = int(m_pads.size());
+    const int mask = tableSize - 1;
+    const int start = int(qHash(padKey) & uint(mask));
+    PadSlot *removed = nullptr;
+
+    for (int i = 0; i < tableSize; ++i) {
+        PadSlot &slot = m_pads[(start + i) & mask];
+        if (slot.padKey == padKey) {
+            return &slot;
+        }
+        if (slot.padKey == RemovedKey) {
+            if (!removed) {
+                removed = &slot;
+            }
+            continue;
+        }
+        if (slot.padKey == EmptyKey) {
+            break;
+        }
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    // Table à moitié pleine: une table plus grande a pu arriver depuis le début du bloc
+    if (m_padCount >= tableSize / 2) {
+        return adoptTables() ? findPad(padKey, create) : nullptr;
+    }
+
+    // Fin de sondage: le pad est absent, l'insérer dans la première case disponible
+    for (int i = 0; !removed && i < tableSize; ++i) {
+        PadSlot &slot = m_pads[(start + i) & mask];
+        if (slot.padKey == EmptyKey) {
+            removed = &slot;
+        }
+    }
+    if (!removed) {
+        return nullptr;
+    }
+
+    removed->padKey = padKey;
+    removed->hasPending = false;
+    removed->gain = 1.0f;
+    m_padCount++;
+    return removed;
+}
+
+bool AudioMixer::adoptTables()
+{
+    bool adopted = false;
+    QVector<PadSlot> table;
+    while (m_tables.pop(table)) {
+        if (table.size() <= m_pads.size()) {
+            m_retiredTables.push(std::move(table));
+            continue;
+        }
+
+        // Réinsérer les pads présents; les cases libérées disparaissent au passage
+        const int mask = int(table.size()) - 1;
+        for (PadSlot &slot : m_pads) {
+            if (slot.padKey == EmptyKey || slot.padKey == RemovedKey) {
+                continue;
+            }
+            int index = int(qHash(slot.padKey) & uint(mask));
+            while (table[index].padKey != EmptyKey) {
+                index = (index + 1) & mask;
+            }
+            table[index] = std::move(slot);
+        }
+
+        std::swap(m_pads, table);
+        m_retiredTables.push(std::move(table));
+        adopted = true;
+    }
+    return adopted;
+}
+
+AudioMixer::Voice &AudioMixer::allocateVoice(quintptr padKey)
+{
+    const StealPolicy policy = m_stealPolicy.load(std::memory_order_relaxed);
+
+    // Meilleure victime selon la politique choisie
+    auto isBetterVictim = [policy](const Voice &candidate, const Voice *current) {
+        if (!current) {
+            return true;
+        }
+        return policy == StealQuietest ? candidate.level < current->level
+                                       : candidate.startedAt < current->startedAt;
+    };
+
+    int padVoices = 0;
+    Voice *padVictim = nullptr;
+    Voice *freeVoice = nullptr;
+    Voice *globalVictim = nullptr;
+
+    for (Voice &voice : m_voices) {
+        if (!voice.sample) {
+            if (!freeVoice) {
+                freeVoice = &voice;
+            }
+            continue;
+        }
+        if (voice.padKey == padKey) {
+            padVoices++;
+            if (isBetterVictim(voice, padVictim)) {
+                padVictim = &voice;
+            }
+        }
+        if (isBetterVictim(voice, globalVictim)) {
+            globalVictim = &voice;
+        }
+    }
+
+    // Polyphonie du pad atteinte: remplacer une de ses propres voix
+    if (padVictim && padVoices >= m_maxPolyphony.load(std::memory_order_relaxed)) {
+        return *padVictim;
+    }
+
+    if (freeVoice) {
+        return *freeVoice;
+    }
+
+    // Plus aucune voix libre: en voler une, en signalant la fin de son pad si nécessaire
+    if (globalVictim->padKey != padKey) {
+        releaseVoice(*globalVictim);
+    }
+    return *globalVictim;
+}
+
+void AudioMixer::releaseVoice(Voice &voice)
+{
+    const quintptr padKey = voice.padKey;
+    releaseStream(voice);
+    retireSample(voice.sample);
+    voice.padKey = 0;
+
+    for (const Voice &other : m_voices) {
+        if (other.sample && other.padKey == padKey) {
+            return;
+        }
+    }
+
+    // Le pad n'a plus aucune voix active ni aucun départ à venir
+    if (!hasScheduled(padKey)) {
+        m_finished.push(padKey);
+    }
+}
+
+void AudioMixer::claimStream(Voice &voice)
+{
+    for (AudioStream &stream : m_streams) {
+        if (!stream.claim(voice.sample)) {
+            continue;
+        }
+        if (!m_streamRequests.push(&stream)) {
+            std::shared_ptr<const AudioSample> head;
+            stream.recycle(head);
+            retireSample(head);
+            break;
+        }
+        voice.stream = &stream;
+        return;
+    }
+
+    // Aucun flux libre: la voix s'arrêtera à la fin de la tête
+    m_streamsUnavailable.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioMixer::releaseStream(Voice &voice)
+{
+    if (!voice.stream) {
+        return;
+    }
+
+    AudioStream *stream = voice.stream;
+    voice.stream = nullptr;
+
+    // Décodage en cours: son thread recyclera le flux ; sinon le recycler ici
+    if (stream->cancel()) {
+        return;
+    }
+    std::shared_ptr<const AudioSample> head;
+    stream->recycle(head);
+    retireSample(head);
+}
+
+void AudioMixer::retireSample(std::shared_ptr<const AudioSample> &sample)
+{
+    if (!sample) {
+        return;
+    }
+
+    // File pleine: libérer ici plutôt que de perdre la référence
+    if (!m_released.push(std::move(sample))) {
+        sample.reset();
+    }
+}
@@ -0,0 +1,484 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QIODevice>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "audiosample.h"
+#include "mixkernels.h"
+#include "lockfreering.h"
+#include "latencymonitor.h"
+#include "audiostream.h"
+
+/**
+ * @brief Source audio en mode "pull" qui mixe toutes les voix actives
+ *
+ * Le QAudioSink de l'AudioEngine lit ce périphérique chaque fois que sa mémoire tampon
+ * se vide ; readData() additionne alors les voix actives directement dans le tampon
+ * de sortie. Les voix sont préallouées (MaxVoices) : aucun son ne passe par un lecteur
+ * multimédia et un pad inactif ne coûte rien au mixeur.
+ *
+ * Chaque pad est associé à son son décodé et à son gain de normalisation par bindPad(),
+ * dans une table préallouée du thread audio. La table est agrandie avant d'être pleine :
+ * la nouvelle est allouée hors du thread audio (reservePads()), qui se contente d'y
+ * déplacer les pads puis de rendre l'ancienne par takeReleased(). Un déclenchement n'est donc qu'une petite
+ * commande (pad, gain, trame de départ) déposée dans une LockFreeRing : ni verrou, ni
+ * allocation, ni signal Qt entre le clic et le thread audio, qui applique les commandes
+ * au début de chaque bloc. Un pad déclenché avant d'être associé garde son
+ * déclenchement en attente et est signalé par takeMissing().
+ *
+ * Chaque déclenchement d'un pad polyphonique occupe sa propre voix, dans la limite de
+ * maxPolyphony() voix par pad. Lorsque cette limite est atteinte, ou que toutes les
+ * voix sont occupées, une voix existante est volée selon la politique choisie : la
+ * plus ancienne, ou la plus discrète (niveau crête du dernier bloc mixé).
+ *
+ * L'addition des voix (gain et panoramique compris) et l'écrêtage doux du bus passent
+ * par les noyaux vectoriels de MixKernels, choisis selon le processeur.
+ *
+ * Un son long n'a que son début en mémoire (AudioSample::isStreamed()) : sa voix réserve
+ * l'un des MaxStreams AudioStream préalloués, signalé par takeStreamRequest() pour qu'un
+ * thread de décodage le remplisse, et enchaîne sur ce tampon à la fin de la tête.
+ * Un bloc où le tampon n'a pas assez de données est complété de silence et compté
+ * (streamStats()).
+ *
+ * Un déclenchement dont la trame de départ tombe après la période en cours attend dans
+ * une file ordonnée par trame (tas préalloué de MaxScheduled commandes), sans occuper de
+ * voix ni relancer celles du pad. Il est appliqué au début de la période qui contient sa
+ * trame, et sa voix démarre exactement à cette trame dans le bloc : des déclenchements
+ * enchaînés ou planifiés par le réseau tombent à l'échantillon près, sans être arrondis
+ * au début d'une période. Stop() et unbindPad() annulent les départs programmés du pad.
+ * Un groupe de pads (triggerGroup()) passe en une seule commande : son départ est fixé
+ * une fois, et chaque membre est placé à son décalage par le même mécanisme.
+ *
+ * Un déclenchement horodaté (inputTime) produit une LatencySample lorsque sa première
+ * trame est écrite, relevée par takeLatency().
+ *
+ * Chaque rappel de la sortie est mixé par périodes (setOutputTiming()) : les commandes
+ * sont appliquées au début de chaque période, si bien qu'un déclenchement attend au plus
+ * une période quelle que soit la quantité demandée par le périphérique. Les rappels sont
+ * chronométrés pour compter les manques et les dépassements (outputStats()). Chaque
+ * rappel date aussi la sortie, ce qui permet de viser l'instant où une trame sera
+ * entendue (frameAt()) pour démarrer un son à une heure précise.
+ *
+ * Le thread audio ne libère jamais un son lui-même : les références abandonnées sont
+ * rendues par takeReleased() au thread qui relève les fins de lecture.
+ */
+class AudioMixer : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    static const int MaxVoices = 128;   ///< Nombre maximal de voix simultanées
+    static const int InitialPads = 1024; ///< Pads acceptés avant le premier agrandissement de la table
+    static const int MaxCommands = 256; ///< Nombre maximal de commandes en attente
+    static const int MaxStreams = 16;   ///< Nombre maximal de voix lues en continu
+    static const int MaxScheduled = 256; ///< Nombre maximal de déclenchements programmés en attente
+    static const int MaxGroupMembers = 8; ///< Nombre maximal de pads d'un groupe (triggerGroup())
+
+    /**
+     * @brief Compteurs de la lecture en continu
+     */
+    struct StreamStats {
+        quint64 underruns;      // Blocs où une voix a manqué de données
+        quint64 unavailable;    // Voix limitées à la tête, faute de flux libre
+    };
+
+    /**
+     * @brief Choix de la voix à interrompre lorsqu'il n'en reste plus de libre
+     */
+    enum StealPolicy {
+        StealOldest,    ///< Voix démarrée le plus tôt
+        StealQuietest   ///< Voix dont le niveau récent est le plus faible
+    };
+
+    /**
+     * @brief Pad d'un groupe déclenché d'un seul bloc (triggerGroup())
+     */
+    struct GroupMember {
+        quintptr padKey = 0;    ///< Pad déclenché
+        bool restart = false;   ///< Relancer la voix existante du pad
+        float gain = 1.0f;      ///< Gain linéaire de la voix
+        qint64 offset = 0;      ///< Décalage après le départ du groupe (trames)
+    };
+
+    /**
+     * @brief Constructeur
+     * @param channels Nombre de canaux de sortie
+     * @param parent Objet parent
+     */
+    explicit AudioMixer(int channels, QObject *parent = nullptr);
+
+    /**
+     * @brief Associe un pad au son qu'il joue
+     * @details Un déclenchement en attente pour ce pad démarre aussitôt ; avec un son nul,
+     *          il est abandonné et la fin du pad est signalée.
+     * @param padKey Identifiant du pad
+     * @param sample Son décodé au format de sortie, ou nullptr si le décodage a échoué
+     * @param gain Gain de normalisation appliqué à toutes les voix du pad
+     * @return false si la file de commandes est pleine
+     */
+    bool bindPad(quintptr padKey, std::shared_ptr<const AudioSample> sample, float gain = 1.0f);
+
+    /**
+     * @brief Prépare la table des pads à en recevoir au moins un nombre donné
+     * @details La table est allouée ici, hors du thread audio, qui l'adopte au bloc suivant.
+     *          Sa capacité double à chaque agrandissement. À appeler avant d'associer ou de
+     *          déclencher ces pads, depuis un seul thread à la fois.
+     * @param pads Nombre de pads
+     */
+    void reservePads(int pads);
+
+    /**
+     * @brief Change le gain de normalisation d'un pad pour ses prochaines voix
+     * @param padKey Identifiant du pad
+     * @param gain Gain linéaire
+     * @return false si la file de commandes est pleine
+     */
+    bool setPadGain(quintptr padKey, float gain);
+
+    /**
+     * @brief Oublie l'association d'un pad ; ses voix en cours terminent leur lecture
+     * @param padKey Identifiant du pad
+     * @return false si la file de commandes est pleine
+     */
+    bool unbindPad(quintptr padKey);
+
+    /**
+     * @brief Démarre la lecture du son d'un pad
+     * @param padKey Identifiant du pad qui déclenche le son
+     * @param restart Si true, une voix déjà active pour ce pad est relancée au début ;
+     *                sinon le son est superposé dans une nouvelle voix
+     * @param gain Gain linéaire de la voix
+     * @param pan Panoramique, de -1 (gauche) à 1 (droite)
+     * @param startFrame Trame de sortie (framePosition()) à laquelle démarrer ; 0 pour
+     *                   démarrer dès le prochain bloc. Une trame déjà mixée est rattrapée :
+     *                   la voix démarre à la position où elle en serait, et n'est pas jouée
+     *                   si le son serait déjà fini
+     * @param inputTime Réception de l'action utilisateur (LatencyMonitor::now()), 0 si non mesuré
+     * @return false si la file de commandes est pleine
+     */
+    bool trigger(quintptr padKey, bool restart, float gain = 1.0f, float pan = 0.0f, qint64 startFrame = 0,
+                 qint64 inputTime = 0);
+
+    /**
+     * @brief Démarre plusieurs pads en une seule commande
+     * @details Le départ du groupe est fixé une fois par le thread audio, puis chaque membre est
+     *          placé à son décalage exact : les voix ne peuvent pas se retrouver dans des blocs
+     *          différents comme des déclenchements séparés.
+     * @param members Pads du groupe
+     * @param count Nombre de pads (au plus MaxGroupMembers)
+     * @param startFrame Trame de sortie du départ du groupe ; 0 pour le prochain bloc
+     * @param inputTime Réception de l'action utilisateur (LatencyMonitor::now()), 0 si non mesuré
+     * @return false si le groupe est trop grand ou si la file de commandes est pleine
+     */
+    bool triggerGroup(const GroupMember *members, int count, qint64 startFrame = 0, qint64 inputTime = 0);
+
+    /**
+     * @brief Arrête toutes les voix d'un pad
+     * @param padKey Identifiant du pad
+     * @return false si la file de commandes est pleine
+     */
+    bool stop(quintptr padKey);
+
+    /**
+     * @brief Définit le nombre maximal de voix simultanées d'un même pad
+     * @param voices Nombre de voix (entre 1 et MaxVoices)
+     */
+    void setMaxPolyphony(int voices);
+
+    /**
+     * @brief Obtient le nombre maximal de voix simultanées d'un même pad
+     */
+    int maxPolyphony() const { return m_maxPolyphony.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Définit la politique de vol de voix
+     * @param policy Voix à interrompre en priorité
+     */
+    void setStealPolicy(StealPolicy policy);
+
+    /**
+     * @brief Obtient la politique de vol de voix
+     */
+    StealPolicy stealPolicy() const { return m_stealPolicy.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Obtient le nombre de trames déjà produites depuis l'ouverture
+     * @return Position de la sortie, en trames
+     */
+    qint64 framePosition() const { return m_framePosition.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Obtient la trame de sortie entendue à un instant donné
+     * @details Estimée au dernier rappel, où le tampon du périphérique vient d'être rempli :
+     *          sa dernière trame sera entendue une durée de tampon plus tard.
+     * @param time Instant (LatencyMonitor::now())
+     * @return Trame à passer à trigger(), 0 tant que la sortie n'a produit aucun rappel
+     */
+    qint64 frameAt(qint64 time) const;
+
+    /**
+     * @brief Obtient la durée du tampon du périphérique, entre le mixage et l'écoute
+     * @return Durée en ns, 0 si inconnue
+     */
+    qint64 outputLatency() const { return m_bufferDuration.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Récupère les pads dont la dernière voix s'est terminée depuis l'appel précédent
+     * @details Un seul thread doit relever les fins de lecture.
+     * @param padKeys Liste recevant les identifiants des pads
+     */
+    void takeFinished(QVector<quintptr> &padKeys);
+
+    /**
+     * @brief Récupère les pads déclenchés alors qu'aucun son ne leur était associé
+     * @details Même thread que takeFinished().
+     * @param padKeys Liste recevant les identifiants des pads
+     */
+    void takeMissing(QVector<quintptr> &padKeys);
+
+    /**
+     * @brief Récupère une mesure de latence d'un déclenchement
+     * @details Même thread que takeFinished().
+     * @param sample Reçoit la mesure
+     * @return false s'il n'y a plus de mesure
+     */
+    bool takeLatency(LatencySample &sample) { return m_latencies.pop(sample); }
+
+    /**
+     * @brief Récupère un flux réservé par une voix, à décoder
+     * @details Même thread que takeFinished(). Le flux doit être démarré (AudioStream::start())
+     *          puis rempli par un thread de décodage.
+     * @param stream Reçoit le flux
+     * @return false s'il n'y a plus de flux à décoder
+     */
+    bool takeStreamRequest(AudioStream *&stream) { return m_streamRequests.pop(stream); }
+
+    /**
+     * @brief Obtient les compteurs de la lecture en continu
+     */
+    StreamStats streamStats() const;
+
+    /**
+     * @brief Définit la taille du tampon du périphérique et la période de mixage
+     * @param bufferFrames Tampon du périphérique, en trames
+     * @param periodFrames Trames mixées entre deux prises en compte des commandes
+     * @param sampleRate Fréquence de sortie
+     */
+    void setOutputTiming(qint64 bufferFrames, qint64 periodFrames, int sampleRate);
+
+    /**
+     * @brief Obtient les compteurs des rappels de la sortie, cumulés depuis la construction
+     */
+    OutputStats outputStats() const;
+
+    /**
+     * @brief Libère les sons et les tables de pads abandonnés par le thread audio
+     * @details Même thread que takeFinished().
+     */
+    void takeReleased();
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    static const int MaxTables = 32;                // Tables de pads en transit (puissance de deux)
+    static const quintptr EmptyKey = 0;             // Case jamais utilisée
+    static const quintptr RemovedKey = ~quintptr(0); // Case libérée
+
+    /**
+     * @brief Commande transmise au thread audio
+     */
+    struct Command {
+        enum Type {
+            Trigger,    // Déclencher le son du pad
+            Stop,       // Arrêter les voix du pad
+            Bind,       // Associer un son au pad
+            Unbind,     // Oublier le pad
+            Gain,       // Changer le gain de normalisation du pad
+            Group       // Déclencher plusieurs pads au même départ
+        };
+
+        Type type = Trigger;                        // Nature de la commande
+        quintptr padKey = 0;                        // Pad concerné
+        bool restart = false;                       // Relancer la voix existante du pad
+        float gain = 1.0f;                          // Gain de la voix (du pad pour Bind et Gain)
+        float pan = 0.0f;                           // Panoramique de la voix
+        qint64 startFrame = 0;                      // Trame de sortie du départ
+        qint64 inputTime = 0;                       // Réception de l'action utilisateur
+        qint64 dispatchTime = 0;                    // Prise en compte par le thread audio
+        std::shared_ptr<const AudioSample> sample;  // Son associé (Bind uniquement)
+        int memberCount = 0;                        // Pads du groupe (Group uniquement)
+        GroupMember members[MaxGroupMembers];       // Membres du groupe
+    };
+
+    /**
+     * @brief Pad connu du thread audio
+     */
+    struct PadSlot {
+        quintptr padKey = EmptyKey;                 // Pad (ou EmptyKey / RemovedKey)
+        std::shared_ptr<const AudioSample> sample;  // Son du pad (nul tant qu'il n'est pas décodé)
+        float gain = 1.0f;                          // Gain de normalisation du pad
+        bool hasPending = false;                    // Déclenchement en attente du son
+        Command pending;                            // Déclenchement en attente
+    };
+
+    /**
+     * @brief Voix du mixeur: lecture en cours d'un son
+     */
+    struct Voice {
+        std::shared_ptr<const AudioSample> sample;  // Son joué (nul si la voix est libre)
+        quintptr padKey;                            // Pad qui a déclenché la voix
+        qint64 position;                            // Prochaine trame à lire
+        qint64 delay;                               // Trames de silence avant le départ
+        qint64 skip;                                // Trames du flux à sauter sans les mixer (rattrapage)
+        qint64 endFrame;                            // Trame de sortie où la voix s'arrête (0: fin du son)
+        quint64 startedAt;                          // Ordre de démarrage, pour voler la plus ancienne
+        float level;                                // Niveau crête du dernier bloc mixé
+        float gainLeft;                             // Gain appliqué au canal gauche
+        float gainRight;                            // Gain appliqué au canal droit
+        qint64 inputTime;                           // Réception de l'action utilisateur (0 si non mesuré)
+        qint64 dispatchTime;                        // Prise en compte par le thread audio
+        AudioStream *stream;                        // Suite du son lue en continu (nullptr: son entier)
+    };
+
+    int m_channels;                 // Nombre de canaux de sortie
+    QVector<Voice> m_voices;        // Voix préallouées (accédées par le seul thread audio)
+    QVector<PadSlot> m_pads;        // Table des pads (accédée par le seul thread audio), deux cases par pad
+    int m_padCount;                 // Pads présents dans la table
+    int m_reservedPads;             // Capacité de la dernière table préparée (thread de reservePads())
+    qint64 m_blockStart;            // Position de sortie du bloc en cours (thread audio)
+    quint64 m_startCounter;         // Compteur de démarrages de voix (thread audio)
+    LockFreeRing<Command, MaxCommands> m_commands;                          // Commandes vers le thread audio
+    LockFreeRing<quintptr, MaxCommands> m_finished;                         // Pads terminés
+    LockFreeRing<quintptr, MaxCommands> m_missing;                          // Pads déclenchés sans son
+    LockFreeRing<std::shared_ptr<const AudioSample>, MaxCommands> m_released; // Sons abandonnés
+    LockFreeRing<QVector<PadSlot>, MaxTables> m_tables;                     // Tables agrandies vers le thread audio
+    LockFreeRing<QVector<PadSlot>, MaxTables> m_retiredTables;              // Tables remplacées, à libérer
+    LockFreeRing<LatencySample, MaxCommands> m_latencies;                   // Mesures de latence
+    LockFreeRing<AudioStream*, MaxCommands> m_streamRequests;               // Flux à décoder
+    AudioStream m_streams[MaxStreams];          // Flux préalloués des voix lues en continu
+    std::atomic<quint64> m_streamUnderruns;     // Blocs où une voix a manqué de données
+    std::atomic<quint64> m_streamsUnavailable;  // Voix sans flux libre
+    std::atomic<qint64> m_framePosition;        // Trames produites depuis l'ouverture
+    std::atomic<qint64> m_periodFrames;         // Trames par période (0: tout le rappel d'un coup)
+    std::atomic<qint64> m_bufferDuration;       // Durée du tampon du périphérique (ns, 0: inconnue)
+    std::atomic<bool> m_timingChanged;          // Sortie rouverte: ne pas compter l'attente comme un manque
+    std::atomic<int> m_sampleRate;              // Fréquence de sortie (0: inconnue)
+    std::atomic<qint64> m_originTime;           // Instant où la trame 0 aurait été entendue (ns, 0: inconnu)
+    qint64 m_lastCallback;                      // Début du rappel précédent (thread audio)
+    std::atomic<quint64> m_callbacks;           // Rappels de la sortie
+    std::atomic<quint64> m_outputUnderruns;     // Tampon du périphérique vidé entre deux rappels
+    std::atomic<quint64> m_callbackOverruns;    // Rappels plus longs que la durée des trames produites
+    std::atomic<qint64> m_maxCallback;          // Rappel le plus long (ns)
+    std::atomic<int> m_maxPolyphony;            // Voix maximales par pad
+    std::atomic<StealPolicy> m_stealPolicy;     // Politique de vol de voix
+    Command m_scheduled[MaxScheduled];          // Départs programmés, tas ordonné par trame (thread audio)
+    int m_scheduledCount;                       // Départs programmés en attente (thread audio)
+    const MixKernels::Table &m_kernels;         // Noyaux de mixage du processeur
+
+    /**
+     * @brief Applique les commandes en attente et les départs programmés de la période (thread audio)
+     * @param frames Nombre de trames de la période qui commence en m_blockStart
+     */
+    void applyCommands(qint64 frames);
+
+    /**
+     * @brief Applique un déclenchement dont le départ tombe dans la période en cours (thread audio)
+     * @param command Déclenchement
+     */
+    void applyTrigger(const Command &command);
+
+    /**
+     * @brief Range un déclenchement dans la file des départs programmés (thread audio)
+     * @param command Déclenchement dont le départ tombe après la période en cours
+     * @return false si la file est pleine
+     */
+    bool schedule(Command &command);
+
+    /**
+     * @brief Annule les départs programmés d'un pad (thread audio)
+     * @param padKey Pad concerné
+     * @return true si au moins un départ a été annulé
+     */
+    bool cancelScheduled(quintptr padKey);
+
+    /**
+     * @brief Indique si un pad a des départs programmés (thread audio)
+     * @param padKey Pad concerné
+     */
+    bool hasScheduled(quintptr padKey) const;
+
+    /**
+     * @brief Mixe une période dans le tampon de sortie (thread audio)
+     * @param output Tampon de sortie entrelacé
+     * @param frames Nombre de trames
+     */
+    void mixPeriod(float *output, qint64 frames);
+
+    /**
+     * @brief Démarre une voix pour un déclenchement (thread audio)
+     * @param command Déclenchement
+     * @param pad Pad déclenché, dont le son est associé
+     */
+    void startVoice(const Command &command, const PadSlot &pad);
+
+    /**
+     * @brief Arrête toutes les voix d'un pad sans signaler sa fin (thread audio)
+     * @param padKey Pad concerné
+     */
+    void stopVoices(quintptr padKey);
+
+    /**
+     * @brief Cherche un pad dans la table (thread audio)
+     * @param padKey Pad recherché
+     * @param create Si true, le pad est ajouté s'il est absent
+     * @return Case du pad, ou nullptr s'il est absent (ou si la table est pleine)
+     */
+    PadSlot *findPad(quintptr padKey, bool create);
+
+    /**
+     * @brief Adopte les tables agrandies par reservePads() (thread audio)
+     * @details Les pads sont déplacés sans allocation ; l'ancienne table part vers takeReleased().
+     * @return true si la table a été remplacée
+     */
+    bool adoptTables();
+
+    /**
+     * @brief Choisit la voix qui jouera un nouveau déclenchement (thread audio)
+     * @param padKey Pad déclenché
+     * @return Voix libre ou volée
+     */
+    Voice &allocateVoice(quintptr padKey);
+
+    /**
+     * @brief Libère une voix et signale la fin du pad s'il n'a plus de voix active (thread audio)
+     * @param voice Voix à libérer
+     */
+    void releaseVoice(Voice &voice);
+
+    /**
+     * @brief Réserve un flux pour une voix qui joue un son lu en continu (thread audio)
+     * @param voice Voix qui vient de démarrer
+     */
+    void claimStream(Voice &voice);
+
+    /**
+     * @brief Abandonne le flux d'une voix qui s'arrête (thread audio)
+     * @param voice Voix concernée
+     */
+    void releaseStream(Voice &voice);
+
+    /**
+     * @brief Confie un son abandonné au thread de relève plutôt que de le libérer ici (thread audio)
+     * @param sample Référence abandonnée
+     */
+    void retireSample(std::shared_ptr<const AudioSample> &sample);
+};
+
+#endif // AUDIOMIXER_H
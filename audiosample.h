@@ -0,0 +1,94 @@
+#ifndef AUDIOSAMPLE_H
+#define AUDIOSAMPLE_H
+
+#include <QVector>
+#include <QString>
+#include <memory>
+
+class MappedWav;
+
+/**
+ * @brief Son entièrement décodé en PCM, prêt à être mixé
+ *
+ * Les échantillons sont entrelacés, en mono ou en stéréo. Les sons en cache sont à la
+ * fréquence de sortie de l'AudioEngine et en entiers 16 bits (moitié moins de mémoire
+ * que des flottants) ; les noyaux du mixeur (MixKernels) lisent directement l'un ou
+ * l'autre format. Une fois publié, un
+ * AudioSample n'est plus modifié : il est partagé entre les pads et les voix du mixeur
+ * via std::shared_ptr<const AudioSample>.
+ *
+ * Pour un fichier long, l'AudioSample ne contient que le début du son et streamPath
+ * désigne le fichier dont la suite est lue en continu (AudioStream).
+ *
+ * Un fichier WAV déjà au format de mixage n'est pas copié : ses échantillons sont lus
+ * sur place dans la projection en mémoire du fichier (mapping), partagée avec le cache
+ * de pages du système. Les échantillons se lisent donc par samplesAt() plutôt que
+ * directement dans data ou pcm16.
+ */
+struct AudioSample
+{
+    QVector<float> data;    // Échantillons flottants entrelacés
+    QVector<qint16> pcm16;  // Échantillons 16 bits entrelacés (si data est vide)
+    int channels = 2;       // Nombre de canaux (1 ou 2)
+    int sampleRate = 48000; // Fréquence d'échantillonnage (Hz)
+    QString streamPath;     // Fichier dont la suite est lue en continu (vide: son entier)
+
+    std::shared_ptr<const MappedWav> mapping;   // Fichier projeté qui porte les échantillons (sinon nul)
+    const void *mappedData = nullptr;           // Premier échantillon dans la projection
+    qint64 mappedFrames = 0;                    // Trames disponibles dans la projection
+    bool mappedInt16 = true;                    // Échantillons projetés en 16 bits (sinon flottants)
+
+    /**
+     * @brief Indique si le son se poursuit au-delà de ses trames en mémoire
+     */
+    bool isStreamed() const { return !streamPath.isEmpty(); }
+
+    /**
+     * @brief Indique si les échantillons sont stockés en entiers 16 bits
+     */
+    bool isInt16() const { return mapping ? mappedInt16 : data.isEmpty() && !pcm16.isEmpty(); }
+
+    /**
+     * @brief Obtient le nombre de trames (un échantillon par canal)
+     * @return Nombre de trames
+     */
+    qint64 frameCount() const
+    {
+        if (channels <= 0) {
+            return 0;
+        }
+        if (mapping) {
+            return mappedFrames;
+        }
+        return (isInt16() ? pcm16.size() : data.size()) / channels;
+    }
+
+    /**
+     * @brief Obtient les échantillons à partir d'une trame, quel que soit leur stockage
+     * @param frame Trame de départ
+     * @return Échantillons entrelacés, en 16 bits si isInt16(), sinon en flottants
+     */
+    const void *samplesAt(qint64 frame) const
+    {
+        const qint64 offset = frame * channels;
+        if (mapping) {
+            return mappedInt16 ? static_cast<const void*>(static_cast<const qint16*>(mappedData) + offset)
+                               : static_cast<const void*>(static_cast<const float*>(mappedData) + offset);
+        }
+        return isInt16() ? static_cast<const void*>(pcm16.constData() + offset)
+                         : static_cast<const void*>(data.constData() + offset);
+    }
+
+    /**
+     * @brief Obtient la mémoire occupée par les échantillons
+     * @details Les pages d'un fichier projeté appartiennent au cache du système et ne sont
+     *          pas comptées.
+     * @return Taille en octets
+     */
+    qint64 memoryUsage() const
+    {
+        return qint64(data.size()) * qint64(sizeof(float)) + qint64(pcm16.size()) * qint64(sizeof(qint16));
+    }
+};
+
+#endif // AUDIOSAMPLE_H
@@ -0,0 +1,93 @@
+#include "audiostream.h"
+#include <algorithm>
+
+AudioStream::AudioStream()
+    : m_buffer(BufferFrames * 2, 0)
+    , m_channels(2)
+    , m_state(Idle)
+    , m_readFrames(0)
+    , m_writeFrames(0)
+    , m_underruns(0)
+{
+}
+
+bool AudioStream::claim(const std::shared_ptr<const AudioSample> &head)
+{
+    // Seul le thread audio quitte l'état Idle: une lecture suffit
+    if (state() != Idle) {
+        return false;
+    }
+
+    m_head = head;
+    m_channels = head->channels;
+    m_underruns.store(0, std::memory_order_relaxed);
+    m_state.store(Requested, std::memory_order_release);
+    return true;
+}
+
+const qint16 *AudioStream::readPointer(qint64 &frames) const
+{
+    const qint64 read = m_readFrames.load(std::memory_order_relaxed);
+    const qint64 available = m_writeFrames.load(std::memory_order_acquire) - read;
+
+    // S'arrêter au bout du tampon: la suite est lue au prochain appel
+    frames = std::min({ frames, available, BufferFrames - (read & Mask) });
+    return m_buffer.constData() + (read & Mask) * m_channels;
+}
+
+void AudioStream::consume(qint64 frames)
+{
+    m_readFrames.store(m_readFrames.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+}
+
+bool AudioStream::atEnd() const
+{
+    return state() == Finished
+           && m_readFrames.load(std::memory_order_relaxed) == m_writeFrames.load(std::memory_order_acquire);
+}
+
+bool AudioStream::cancel()
+{
+    State expected = Requested;
+    if (m_state.compare_exchange_strong(expected, Cancelled, std::memory_order_acq_rel)) {
+        return true;
+    }
+    expected = Running;
+    return m_state.compare_exchange_strong(expected, Cancelled, std::memory_order_acq_rel);
+}
+
+bool AudioStream::start()
+{
+    State expected = Requested;
+    return m_state.compare_exchange_strong(expected, Running, std::memory_order_acq_rel);
+}
+
+qint64 AudioStream::write(const qint16 *samples, qint64 frames)
+{
+    const qint64 written = m_writeFrames.load(std::memory_order_relaxed);
+    const qint64 free = BufferFrames - (written - m_readFrames.load(std::memory_order_acquire));
+    frames = std::min(frames, free);
+
+    // Copie en deux parties si l'écriture fait le tour du tampon
+    const qint64 first = std::min(frames, BufferFrames - (written & Mask));
+    std::copy_n(samples, first * m_channels, m_buffer.data() + (written & Mask) * m_channels);
+    std::copy_n(samples + first * m_channels, (frames - first) * m_channels, m_buffer.data());
+
+    m_writeFrames.store(written + frames, std::memory_order_release);
+    return frames;
+}
+
+bool AudioStream::finish()
+{
+    State expected = Running;
+    return m_state.compare_exchange_strong(expected, Finished, std::memory_order_acq_rel);
+}
+
+void AudioStream::recycle(std::shared_ptr<const AudioSample> &head)
+{
+    head = std::move(m_head);
+    m_head.reset();
+    m_readFrames.store(0, std::memory_order_relaxed);
+    m_writeFrames.store(0, std::memory_order_relaxed);
+    m_state.store(Idle, std::memory_order_release);
+}
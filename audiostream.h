@@ -0,0 +1,149 @@
+#ifndef AUDIOSTREAM_H
+#define AUDIOSTREAM_H
+
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "audiosample.h"
+
+/**
+ * @brief Tampon circulaire d'une voix lue en continu
+ *
+ * Un son long n'est pas décodé entièrement : seul son début (la « tête ») est en
+ * mémoire, ce qui permet un départ immédiat. La suite est décodée par un thread de
+ * lecture en continu pendant que la voix joue, et déposée dans ce tampon de taille
+ * fixe que le thread audio vide. La mémoire occupée ne dépend donc pas de la durée du
+ * fichier.
+ *
+ * Le tampon a un seul écrivain (le thread de décodage) et un seul lecteur (le thread
+ * audio) : les positions de lecture et d'écriture suffisent à le synchroniser, sans
+ * verrou. Le cycle de vie suit l'état du flux :
+ * - Idle : libre, le mixeur peut le réserver (claim()) ;
+ * - Requested : réservé par une voix, en attente d'un thread de décodage ;
+ * - Running : le thread de décodage remplit le tampon (start()) ;
+ * - Finished : le fichier est entièrement décodé, le tampon se vide ;
+ * - Cancelled : la voix s'est arrêtée avant la fin du décodage.
+ *
+ * Le flux est remis à Idle (recycle()) par le dernier des deux côtés à le quitter :
+ * le mixeur s'il était terminé, le thread de décodage s'il a été annulé.
+ */
+class AudioStream
+{
+public:
+    static const int BufferFrames = 65536;  ///< Capacité du tampon (trames), puissance de deux
+
+    /**
+     * @brief État du flux
+     */
+    enum State {
+        Idle,       ///< Libre
+        Requested,  ///< Réservé par une voix
+        Running,    ///< En cours de décodage
+        Finished,   ///< Décodage terminé
+        Cancelled   ///< Voix arrêtée avant la fin du décodage
+    };
+
+    AudioStream();
+
+    AudioStream(const AudioStream &) = delete;
+    AudioStream &operator=(const AudioStream &) = delete;
+
+    /**
+     * @brief Obtient l'état du flux
+     */
+    State state() const { return m_state.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Obtient la tête du son (et le chemin du fichier à lire en continu)
+     * @details Valide entre claim() et recycle().
+     */
+    const std::shared_ptr<const AudioSample> &head() const { return m_head; }
+
+    /**
+     * @brief Obtient le nombre de fois où la voix a manqué de données
+     */
+    quint64 underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Réserve un flux libre pour une voix (thread audio)
+     * @param head Tête du son, dont le décodage continue après la dernière trame
+     * @return false si le flux n'est pas libre
+     */
+    bool claim(const std::shared_ptr<const AudioSample> &head);
+
+    /**
+     * @brief Obtient les trames lisibles d'un seul tenant (thread audio)
+     * @param frames En entrée, nombre de trames souhaitées ; en sortie, trames disponibles
+     * @return Échantillons 16 bits entrelacés, au nombre de canaux de la tête
+     */
+    const qint16 *readPointer(qint64 &frames) const;
+
+    /**
+     * @brief Libère des trames lues (thread audio)
+     * @param frames Nombre de trames, au plus celles données par readPointer()
+     */
+    void consume(qint64 frames);
+
+    /**
+     * @brief Compte un bloc où la voix a manqué de données (thread audio)
+     */
+    void countUnderrun() { m_underruns.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief Indique si le fichier est décodé et le tampon vide (thread audio)
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Abandonne le flux à l'arrêt de sa voix (thread audio)
+     * @return true si le thread de décodage le recyclera ; false si le décodage est
+     *         terminé et que l'appelant doit le recycler
+     */
+    bool cancel();
+
+    /**
+     * @brief Commence le décodage (thread de décodage)
+     * @return false si la voix s'est arrêtée entre-temps ; l'appelant doit alors le recycler
+     */
+    bool start();
+
+    /**
+     * @brief Indique si la voix s'est arrêtée (thread de décodage)
+     */
+    bool isCancelled() const { return state() == Cancelled; }
+
+    /**
+     * @brief Ajoute des trames décodées, dans la limite de la place libre (thread de décodage)
+     * @param samples Échantillons 16 bits entrelacés, au nombre de canaux de la tête
+     * @param frames Nombre de trames
+     * @return Nombre de trames écrites
+     */
+    qint64 write(const qint16 *samples, qint64 frames);
+
+    /**
+     * @brief Signale la fin du décodage (thread de décodage)
+     * @return true si la voix joue encore ; false si elle s'est arrêtée et que l'appelant
+     *         doit recycler le flux
+     */
+    bool finish();
+
+    /**
+     * @brief Remet le flux à l'état libre
+     * @details Appelé par un seul côté, lorsque l'autre ne l'utilise plus.
+     * @param head Reçoit la tête du son, que l'appelant libère hors du thread audio
+     */
+    void recycle(std::shared_ptr<const AudioSample> &head);
+
+private:
+    static const qint64 Mask = BufferFrames - 1;
+
+    QVector<qint16> m_buffer;                   // Échantillons, deux canaux réservés par trame
+    int m_channels;                             // Canaux de la tête (1 ou 2)
+    std::shared_ptr<const AudioSample> m_head;  // Tête du son joué
+    std::atomic<State> m_state;                 // Étape du cycle de vie
+    std::atomic<qint64> m_readFrames;           // Trames lues depuis la réservation
+    std::atomic<qint64> m_writeFrames;          // Trames écrites depuis la réservation
+    std::atomic<quint64> m_underruns;           // Blocs où la voix a manqué de données
+};
+
+#endif // AUDIOSTREAM_H
@@ -1,4 +1,7 @@
 #include "board.h"
+#include "assetstore.h"
+#include "audioengine.h"
+#include "latencymonitor.h"
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QMessageBox>
@@ -6,16 +9,43 @@
 #include <QAction>
 #include <QDebug>
 #include <QDateTime>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
 
 Board::Board(const QString &title, QWidget *parent)
     : QWidget(parent)
     , m_title(title)
-    , m_gridLayout(nullptr)
-    , m_contentWidget(nullptr)
-    , m_scrollArea(nullptr)
+    , m_model(nullptr)
+    , m_delegate(nullptr)
+    , m_view(nullptr)
     , m_addButton(nullptr)
+    , m_shortcuts(nullptr)
+    , m_sharedPlayback(false)
 {
     setupUi();
+
+    // Raccourcis des pads, actifs quel que soit le widget qui a le focus
+    m_shortcuts = new ShortcutDispatcher(this);
+    connect(m_shortcuts, &ShortcutDispatcher::conflictDetected, this, &Board::shortcutConflict);
+
+    // Imports lancés par importSound(), terminés sur le thread du stockage
+    connect(AssetStore::instance(), &AssetStore::fileImported, this, &Board::handleFileImported,
+            Qt::QueuedConnection);
+    
+    // Une seule connexion pour tous les pads: la fin de lecture éteint le pad concerné
+    connect(AudioEngine::instance(), &AudioEngine::padStopped, this, [this](quintptr padKey) {
+        for (SoundPad *pad : m_soundPads) {
+            if (reinterpret_cast<quintptr>(pad) == padKey) {
+                pad->showStopped();
+                break;
+            }
+        }
+    });
 }
 
 Board::~Board()
@@ -42,6 +72,7 @@ void Board::importSound()
     
     for (const QString &filePath : filePaths) {
         if (!filePath.isEmpty()) {
+            // Le pad joue le fichier choisi en attendant sa copie dans le stockage local
             SoundPad *pad = addSoundPad();
             pad->setFilePath(filePath);
             
@@ -50,6 +81,10 @@ void Board::importSound()
             pad->setTitle(fileInfo.baseName());
             
             emit soundPadAdded(pad);
+            
+            // Hachage et copie en arrière-plan: un son déjà importé n'est ni rehaché ni recopié
+            m_pendingImports.insert(filePath, pad);
+            AssetStore::instance()->importFileAsync(filePath);
         }
     }
 }
@@ -59,16 +94,12 @@ SoundPad* Board::addSoundPad()
     // Création d'un nouveau SoundPad
     SoundPad *pad = new SoundPad(tr("Nouveau pad"), "", "", false, QKeySequence(), this);
     
-    // Ajout à la liste
+    // Ajout à la liste et à la vue
     m_soundPads.append(pad);
+    m_model->appendPad(pad);
     
-    // Réorganisation de la grille
-    reorganizeGrid();
-    
-    // Connecter le signal de modification
-    connect(pad, &SoundPad::soundPadModified, this, [this, pad]() {
-        emit soundPadModified(pad);
-    });
+    // Connecter les signaux de modification
+    connectSoundPad(pad);
     
     // Configurer immédiatement le pad
     pad->editMetadata();
@@ -116,16 +147,12 @@ bool Board::addSoundPadFromRemote(SoundPad* pad)
     // Définir le parent du pad comme étant ce board
     pad->setParent(this);
     
-    // Connecter le signal de modification
-    connect(pad, &SoundPad::soundPadModified, this, [this, pad]() {
-        emit soundPadModified(pad);
-    });
+    // Connecter les signaux de modification
+    connectSoundPad(pad);
     
-    // Ajout à la liste
+    // Ajout à la liste et à la vue
     m_soundPads.append(pad);
-    
-    // Réorganisation de la grille
-    reorganizeGrid();
+    m_model->appendPad(pad);
     
     qDebug() << "SoundPad ajouté avec succès depuis le réseau:" << pad->objectName();
     
@@ -141,17 +168,177 @@ void Board::removeSoundPad(SoundPad* pad)
         // Signal de suppression
         emit soundPadRemoved(pad);
         
-        // Retrait de la liste
+        // Retrait de la liste, de la vue et de ses raccourcis
         m_soundPads.removeOne(pad);
+        m_model->removePad(pad);
+        m_shortcuts->removePad(pad);
         
         // Supprimer l'objet
         pad->deleteLater();
+    }
+}
+
+void Board::handleFileImported(const QString &filePath, const QString &hash)
+{
+    const QList<SoundPad*> pads = m_pendingImports.values(filePath);
+    m_pendingImports.remove(filePath);
+    if (pads.isEmpty()) {
+        return;
+    }
+    if (hash.isEmpty()) {
+        qDebug() << "AVERTISSEMENT: Import impossible, le pad garde le fichier d'origine:" << filePath;
+        return;
+    }
+    
+    const QString storedPath = AssetStore::instance()->filePath(hash);
+    for (SoundPad *pad : pads) {
+        // Pad supprimé ou dont le son a été changé entre-temps
+        if (!m_soundPads.contains(pad) || pad->getFilePath() != filePath) {
+            continue;
+        }
+        pad->setFilePath(storedPath);
+        emit soundPadModified(pad);
+    }
+}
+
+void Board::connectSoundPad(SoundPad *pad)
+{
+    connect(pad, &SoundPad::soundPadModified, this, [this, pad]() {
+        emit soundPadModified(pad);
+    });
+    connect(pad, &SoundPad::shortcutChanged, m_shortcuts, &ShortcutDispatcher::updatePad);
+    m_shortcuts->updatePad(pad);
+    
+    pad->setSharedPlayback(m_sharedPlayback);
+    connect(pad, &SoundPad::playRequested, this, &Board::soundPadPlayRequested);
+    connect(pad, &SoundPad::macroPlayed, this, &Board::playMacro);
+    connect(pad, &SoundPad::macroEditRequested, this, &Board::editMacro);
+}
+
+void Board::setSharedPlayback(bool shared)
+{
+    m_sharedPlayback = shared;
+    for (SoundPad *pad : m_soundPads) {
+        pad->setSharedPlayback(shared);
+    }
+}
+
+void Board::playMacro(SoundPad *macro, qint64 time, qint64 inputTime)
+{
+    QVector<AudioEngine::GroupMember> members;
+    QVector<SoundPad*> pads;
+    
+    for (const SoundPad::MacroMember &entry : macro->getMacro()) {
+        SoundPad *pad = getSoundPadById(entry.padId);
+        if (!pad || pad->getFilePath().isEmpty() || pad->isMacro()) {
+            qDebug() << "AVERTISSEMENT: Membre de macro ignoré:" << entry.padId;
+            continue;
+        }
         
-        // Réorganisation de la grille
-        reorganizeGrid();
+        AudioEngine::GroupMember member;
+        member.padKey = reinterpret_cast<quintptr>(pad);
+        member.restart = !pad->getCanDuplicatePlay();
+        member.gain = float(entry.gain);
+        member.offset = entry.offset;
+        members.append(member);
+        pads.append(pad);
+    }
+    
+    if (members.isEmpty()) {
+        return;
+    }
+    
+    // Un seul déclenchement pour tout le groupe : les décalages partent du même échantillon
+    AudioEngine::instance()->playGroup(members, time, inputTime);
+    for (SoundPad *pad : pads) {
+        pad->showPlaying();
     }
 }
 
+void Board::editMacro(SoundPad *macro)
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Macro de %1").arg(macro->getTitle()));
+    
+    QVBoxLayout layout(&dialog);
+    
+    // Une ligne par pad pouvant faire partie de la macro
+    QTableWidget table(&dialog);
+    table.setColumnCount(3);
+    table.setHorizontalHeaderLabels({tr("Pad"), tr("Décalage (ms)"), tr("Gain")});
+    table.horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table.verticalHeader()->hide();
+    
+    QVector<SoundPad::MacroMember> current = macro->getMacro();
+    QVector<SoundPad*> candidates;
+    for (SoundPad *pad : m_soundPads) {
+        if (pad != macro && !pad->isMacro()) {
+            candidates.append(pad);
+        }
+    }
+    table.setRowCount(candidates.size());
+    
+    for (int row = 0; row < candidates.size(); ++row) {
+        SoundPad *pad = candidates[row];
+        SoundPad::MacroMember member;
+        bool selected = false;
+        for (const SoundPad::MacroMember &entry : current) {
+            if (entry.padId == pad->objectName()) {
+                member = entry;
+                selected = true;
+                break;
+            }
+        }
+        
+        QTableWidgetItem *item = new QTableWidgetItem(pad->getTitle());
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+        item->setCheckState(selected ? Qt::Checked : Qt::Unchecked);
+        table.setItem(row, 0, item);
+        
+        QSpinBox *offsetEdit = new QSpinBox(&table);
+        offsetEdit->setRange(0, 10000);
+        offsetEdit->setValue(member.offset);
+        table.setCellWidget(row, 1, offsetEdit);
+        
+        QDoubleSpinBox *gainEdit = new QDoubleSpinBox(&table);
+        gainEdit->setRange(0.0, 2.0);
+        gainEdit->setSingleStep(0.05);
+        gainEdit->setValue(member.gain);
+        table.setCellWidget(row, 2, gainEdit);
+    }
+    layout.addWidget(&table);
+    
+    QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(&buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(&buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout.addWidget(&buttons);
+    
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    
+    QVector<SoundPad::MacroMember> members;
+    for (int row = 0; row < candidates.size(); ++row) {
+        if (table.item(row, 0)->checkState() != Qt::Checked) {
+            continue;
+        }
+        SoundPad::MacroMember member;
+        member.padId = candidates[row]->objectName();
+        member.offset = static_cast<QSpinBox*>(table.cellWidget(row, 1))->value();
+        member.gain = static_cast<QDoubleSpinBox*>(table.cellWidget(row, 2))->value();
+        members.append(member);
+    }
+    
+    if (members.size() > AudioMixer::MaxGroupMembers) {
+        QMessageBox::warning(this, tr("Avertissement"),
+                             tr("Une macro ne peut jouer que %1 pads.").arg(int(AudioMixer::MaxGroupMembers)));
+        members.resize(AudioMixer::MaxGroupMembers);
+    }
+    
+    macro->setMacro(members);
+    emit soundPadModified(macro);
+}
+
 void Board::setupUi()
 {
     // Configuration du layout principal
@@ -159,98 +346,85 @@ void Board::setupUi()
     mainLayout->setContentsMargins(10, 10, 10, 10);
     mainLayout->setSpacing(10);
     
-    // Zone de défilement pour les SoundPads
-    m_scrollArea = new QScrollArea(this);
-    m_scrollArea->setWidgetResizable(true);
-    m_scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    m_scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    // Vue des SoundPads: une grille qui suit la largeur du tableau
+    m_model = new PadModel(this);
+    m_delegate = new PadDelegate(this);
     
-    // Widget contenant la grille de SoundPads
-    m_contentWidget = new QWidget(m_scrollArea);
-    m_gridLayout = new QGridLayout(m_contentWidget);
-    m_gridLayout->setContentsMargins(10, 10, 10, 10);
-    m_gridLayout->setSpacing(10);
+    m_view = new QListView(this);
+    m_view->setFlow(QListView::LeftToRight);
+    m_view->setWrapping(true);
+    m_view->setResizeMode(QListView::Adjust);
+    m_view->setUniformItemSizes(true);
+    m_view->setSpacing(5);
+    m_view->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_view->setSelectionMode(QAbstractItemView::NoSelection);
+    m_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_view->setFocusPolicy(Qt::NoFocus);
+    m_view->setDragDropMode(QAbstractItemView::DropOnly);
+    m_view->setDropIndicatorShown(true);
+    m_view->viewport()->setAttribute(Qt::WA_Hover);
+    m_view->setItemDelegate(m_delegate);
+    m_view->setModel(m_model);
     
-    m_scrollArea->setWidget(m_contentWidget);
+    // Un pad est retiré après la fin du clic qui l'a demandé
+    connect(m_delegate, &PadDelegate::padClicked, this, [](SoundPad *pad) {
+        pad->play(LatencyMonitor::now());
+    });
+    connect(m_delegate, &PadDelegate::removeClicked, this, &Board::removeSoundPad, Qt::QueuedConnection);
+    connect(m_delegate, &PadDelegate::thumbnailReady, m_model, &PadModel::imageReady);
     
     // Bouton d'ajout de SoundPad
     m_addButton = new QPushButton(tr("+ Ajouter un pad"), this);
     connect(m_addButton, &QPushButton::clicked, this, &Board::addSoundPad);
     
     // Organisation des éléments
-    mainLayout->addWidget(m_scrollArea);
+    mainLayout->addWidget(m_view);
     mainLayout->addWidget(m_addButton);
     
-    // Configuration du menu contextuel
+    // Configuration des menus contextuels: celui du pad visé, ou celui du tableau
+    m_view->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_view, &QWidget::customContextMenuRequested, this, [this](const QPoint &pos) {
+        const QPoint globalPos = m_view->viewport()->mapToGlobal(pos);
+        if (SoundPad *pad = m_model->padAt(m_view->indexAt(pos))) {
+            pad->showContextMenu(globalPos);
+        } else {
+            showContextMenu(globalPos);
+        }
+    });
+    
     setContextMenuPolicy(Qt::CustomContextMenu);
     connect(this, &QWidget::customContextMenuRequested, this, [this](const QPoint &pos) {
-        QMenu contextMenu(tr("Menu"), this);
-        
-        QAction addPadAction(tr("Ajouter un pad"), this);
-        QAction importSoundAction(tr("Importer des sons"), this);
-        QAction editTitleAction(tr("Modifier le titre"), this);
-        
-        connect(&addPadAction, &QAction::triggered, this, &Board::addSoundPad);
-        connect(&importSoundAction, &QAction::triggered, this, &Board::importSound);
-        connect(&editTitleAction, &QAction::triggered, this, [this]() {
-            bool ok;
-            QString newTitle = QInputDialog::getText(this, 
-                tr("Modifier le titre"), 
-                tr("Nouveau titre:"), 
-                QLineEdit::Normal, 
-                m_title, 
-                &ok);
-            
-            if (ok && !newTitle.isEmpty()) {
-                setTitle(newTitle);
-            }
-        });
-        
-        contextMenu.addAction(&addPadAction);
-        contextMenu.addAction(&importSoundAction);
-        contextMenu.addAction(&editTitleAction);
-        
-        contextMenu.exec(mapToGlobal(pos));
+        showContextMenu(mapToGlobal(pos));
     });
 }
 
-void Board::reorganizeGrid()
+void Board::showContextMenu(const QPoint &globalPos)
 {
-    // Effacer le layout existant
-    QLayoutItem *child;
-    while ((child = m_gridLayout->takeAt(0)) != nullptr) {
-        delete child;
-    }
+    QMenu contextMenu(tr("Menu"), this);
     
-    // Nombre de colonnes (ajuster selon vos préférences)
-    const int columns = 4;
+    QAction addPadAction(tr("Ajouter un pad"), this);
+    QAction importSoundAction(tr("Importer des sons"), this);
+    QAction editTitleAction(tr("Modifier le titre"), this);
     
-    // Ajouter les SoundPads à la grille
-    for (int i = 0; i < m_soundPads.size(); ++i) {
-        int row = i / columns;
-        int col = i % columns;
-        
-        // Création d'un widget pour contenir le SoundPad et son bouton de suppression
-        QWidget *container = new QWidget(m_contentWidget);
-        QVBoxLayout *containerLayout = new QVBoxLayout(container);
-        containerLayout->setContentsMargins(2, 2, 2, 2);
-        containerLayout->setSpacing(2);
-        
-        // Bouton de suppression
-        QPushButton *removeButton = new QPushButton(tr("×"), container);
-        removeButton->setMaximumSize(20, 20);
-        removeButton->setToolTip(tr("Supprimer ce pad"));
-        connect(removeButton, &QPushButton::clicked, this, [this, i]() {
-            if (i < m_soundPads.size()) {
-                removeSoundPad(m_soundPads[i]);
-            }
-        });
-        
-        // Ajout des éléments au container
-        containerLayout->addWidget(removeButton, 0, Qt::AlignRight);
-        containerLayout->addWidget(m_soundPads[i]);
+    connect(&addPadAction, &QAction::triggered, this, &Board::addSoundPad);
+    connect(&importSoundAction, &QAction::triggered, this, &Board::importSound);
+    connect(&editTitleAction, &QAction::triggered, this, [this]() {
+        bool ok;
+        QString newTitle = QInputDialog::getText(this, 
+            tr("Modifier le titre"), 
+            tr("Nouveau titre:"), 
+            QLineEdit::Normal, 
+            m_title, 
+            &ok);
         
-        // Ajout du container à la grille
-        m_gridLayout->addWidget(container, row, col);
-    }
+        if (ok && !newTitle.isEmpty()) {
+            setTitle(newTitle);
+        }
+    });
+    
+    contextMenu.addAction(&addPadAction);
+    contextMenu.addAction(&importSoundAction);
+    contextMenu.addAction(&editTitleAction);
+    
+    contextMenu.exec(globalPos);
 }
@@ -4,13 +4,24 @@
 #include <QWidget>
 #include <QVector>
 #include <QString>
-#include <QGridLayout>
+#include <QMultiHash>
 #include <QPushButton>
-#include <QScrollArea>
+#include <QListView>
 #include "soundpad.h"
+#include "shortcutdispatcher.h"
+#include "padmodel.h"
+#include "paddelegate.h"
 
 /**
  * @brief Classe représentant un tableau de SoundPads
+ *
+ * Les raccourcis clavier des pads sont traités par un ShortcutDispatcher propre au
+ * tableau : ils fonctionnent tant que le tableau est visible, quel que soit le widget
+ * qui a le focus.
+ *
+ * Les pads sont affichés par une seule vue (QListView) sur un PadModel, peinte par un
+ * PadDelegate : seules les cases visibles sont dessinées, si bien que le défilement et la
+ * mémoire ne dépendent pas du nombre de pads.
  */
 class Board : public QWidget
 {
@@ -45,15 +56,17 @@ public:
     
     /**
      * @brief Met à jour l'affichage des SoundPads
-     * Cette méthode publique permet de réorganiser l'affichage des SoundPads
+     * Cette méthode publique permet de redessiner les SoundPads visibles
      */
-    void updateDisplay() { reorganizeGrid(); }
+    void updateDisplay() { m_view->viewport()->update(); }
     SoundPad* getSoundPadById(const QString &padId);
 
 
 public slots:
     /**
-     * @brief Importe un son et crée un nouveau SoundPad
+     * @brief Importe des sons et crée un SoundPad pour chacun
+     * @details Chaque pad joue d'abord le fichier choisi ; il passe à la copie du stockage
+     *          dès que celle-ci est prête, sans bloquer l'interface pendant l'import.
      */
     void importSound();
     
@@ -75,6 +88,27 @@ public slots:
      * @param pad SoundPad à supprimer
      */
     void removeSoundPad(SoundPad* pad);
+    
+    /**
+     * @brief Confie les déclenchements des pads à la room qui partage ce tableau
+     * @param shared Si true, un pad déclenché émet soundPadPlayRequested() au lieu de jouer
+     */
+    void setSharedPlayback(bool shared);
+    
+    /**
+     * @brief Joue ensemble les membres d'une macro
+     * @param macro Pad macro déclenché
+     * @param time Instant où les membres doivent être entendus (LatencyMonitor::now()), 0 pour tout de suite
+     * @param inputTime Réception du clic ou de la touche, 0 si non mesuré
+     * @details Les membres introuvables, sans son ou eux-mêmes macros sont ignorés.
+     */
+    void playMacro(SoundPad *macro, qint64 time, qint64 inputTime);
+    
+    /**
+     * @brief Ouvre la configuration des membres d'une macro
+     * @param macro Pad à configurer
+     */
+    void editMacro(SoundPad *macro);
 
 signals:
     /**
@@ -101,13 +135,31 @@ signals:
      */
     void soundPadModified(SoundPad *pad);
 
+    /**
+     * @brief Signal émis lorsqu'un pad est déclenché localement et que la lecture est partagée
+     * @param pad SoundPad déclenché
+     * @param inputTime Réception du clic ou de la touche (LatencyMonitor::now())
+     */
+    void soundPadPlayRequested(SoundPad *pad, qint64 inputTime);
+
+    /**
+     * @brief Signal émis lorsqu'un pad reçoit un raccourci déjà utilisé dans le tableau
+     * @param pad Pad dont le raccourci est inactif
+     * @param owner Pad qui utilise déjà le raccourci
+     * @param shortcut Raccourci en conflit
+     */
+    void shortcutConflict(SoundPad *pad, SoundPad *owner, const QKeySequence &shortcut);
+
 private:
     QString m_title;                  // Titre du tableau
     QVector<SoundPad*> m_soundPads;   // Liste des SoundPads
-    QGridLayout *m_gridLayout;        // Layout pour organiser les SoundPads
-    QWidget *m_contentWidget;         // Widget contenant la grille
-    QScrollArea *m_scrollArea;        // Zone de défilement
+    PadModel *m_model;                // Pads affichés par la vue
+    PadDelegate *m_delegate;          // Dessin et clics des pads
+    QListView *m_view;                // Vue des SoundPads, seules les cases visibles sont dessinées
     QPushButton *m_addButton;         // Bouton pour ajouter un SoundPad
+    ShortcutDispatcher *m_shortcuts;  // Raccourcis clavier des pads
+    bool m_sharedPlayback;            // Déclenchements confiés à la room
+    QMultiHash<QString, SoundPad*> m_pendingImports; // Pads en attente de leur fichier importé, par chemin d'origine
 
     /**
      * @brief Configure l'interface utilisateur
@@ -115,9 +167,23 @@ private:
     void setupUi();
     
     /**
-     * @brief Réorganise les SoundPads dans la grille
+     * @brief Bascule sur la copie du stockage les pads qui attendaient un fichier importé
+     * @param filePath Chemin d'origine du fichier
+     * @param hash Empreinte du fichier, ou une chaîne vide si l'import a échoué
+     */
+    void handleFileImported(const QString &filePath, const QString &hash);
+
+    /**
+     * @brief Branche un pad ajouté au tableau (modifications et raccourci)
+     * @param pad SoundPad ajouté
+     */
+    void connectSoundPad(SoundPad *pad);
+
+    /**
+     * @brief Ouvre le menu contextuel du tableau
+     * @param globalPos Position du menu à l'écran
      */
-    void reorganizeGrid();
+    void showContextMenu(const QPoint &globalPos);
 };
 
 #endif // BOARD_H
@@ -0,0 +1,75 @@
+#include "chunkeddecoder.h"
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QUrl>
+
+ChunkedDecoder::Result ChunkedDecoder::decode(const QString &filePath, const BufferHandler &handler,
+                                              const std::atomic<bool> *stop, QString *errorString)
+{
+    auto stopping = [stop]() {
+        return stop && stop->load(std::memory_order_relaxed);
+    };
+
+    if (stopping()) {
+        return Stopped;
+    }
+
+    QAudioDecoder decoder;
+    decoder.setSource(QUrl::fromLocalFile(filePath));
+
+    QEventLoop loop;
+    bool done = false;
+    Result result = Finished;
+
+    auto finish = [&](Result finished) {
+        if (done) {
+            return;
+        }
+        done = true;
+        result = finished;
+        if (finished != Finished) {
+            decoder.stop();
+        }
+        loop.quit();
+    };
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&]() {
+        const QAudioBuffer buffer = decoder.read();
+        if (done) {
+            return;
+        }
+        if (stopping() || !handler(buffer)) {
+            finish(Stopped);
+        }
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&]() {
+        finish(Finished);
+    });
+    QObject::connect(&decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), &loop,
+                     [&](QAudioDecoder::Error error) {
+        Q_UNUSED(error);
+        if (errorString) {
+            *errorString = decoder.errorString();
+        }
+        finish(Failed);
+    });
+
+    // Relever aussi le drapeau entre deux tampons, si le décodeur tarde à en fournir
+    QTimer poll;
+    if (stop) {
+        QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+            if (stopping()) {
+                finish(Stopped);
+            }
+        });
+        poll.start(StopPollInterval);
+    }
+
+    decoder.start();
+    if (!done) {
+        loop.exec();
+    }
+    return result;
+}
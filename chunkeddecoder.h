@@ -0,0 +1,51 @@
+#ifndef CHUNKEDDECODER_H
+#define CHUNKEDDECODER_H
+
+#include <QString>
+#include <atomic>
+#include <functional>
+
+class QAudioBuffer;
+
+/**
+ * @brief Décodage d'un fichier audio tampon par tampon, interruptible
+ *
+ * Le fichier est décodé par un QAudioDecoder dans une boucle d'événements locale, sur le
+ * thread appelant : chaque tampon est remis à l'appelant dès qu'il est prêt, sans que le
+ * fichier entier soit gardé en mémoire. Le décodage s'arrête dès que l'appelant refuse un
+ * tampon ou qu'un drapeau d'arrêt est levé, ce qui permet à l'application de se fermer
+ * sans attendre la fin d'un long fichier.
+ */
+class ChunkedDecoder
+{
+public:
+    static const int StopPollInterval = 50; ///< Intervalle de relève du drapeau d'arrêt sans tampon (ms)
+
+    /**
+     * @brief Issue d'un décodage
+     */
+    enum Result {
+        Finished,   ///< Fichier décodé jusqu'au bout
+        Stopped,    ///< Interrompu par l'appelant ou par le drapeau d'arrêt
+        Failed      ///< Erreur du décodeur
+    };
+
+    /**
+     * @brief Reçoit chaque tampon décodé
+     * @return false pour interrompre le décodage
+     */
+    using BufferHandler = std::function<bool(const QAudioBuffer &buffer)>;
+
+    /**
+     * @brief Décode un fichier et remet ses tampons à l'appelant
+     * @param filePath Chemin du fichier audio
+     * @param handler Appelé pour chaque tampon, au format natif du fichier
+     * @param stop Drapeau d'arrêt relevé entre les tampons (nullptr si aucun)
+     * @param errorString Reçoit le message du décodeur en cas d'échec (facultatif)
+     * @return Issue du décodage
+     */
+    static Result decode(const QString &filePath, const BufferHandler &handler,
+                         const std::atomic<bool> *stop = nullptr, QString *errorString = nullptr);
+};
+
+#endif // CHUNKEDDECODER_H
@@ -0,0 +1,47 @@
+#include "clocksync.h"
+#include <cmath>
+#include <utility>
+
+ClockSync::ClockSync()
+    : m_next(0)
+    , m_offset(0)
+    , m_delay(0)
+    , m_jitter(0)
+{
+    m_samples.reserve(Window);
+}
+
+void ClockSync::addSample(qint64 t0, qint64 t1, qint64 t2, qint64 t3)
+{
+    Sample sample;
+    sample.offset = ((t1 - t0) + (t2 - t3)) / 2;
+    sample.delay = qMax<qint64>(0, (t3 - t0) - (t2 - t1));
+
+    if (m_samples.size() < Window) {
+        m_samples.append(sample);
+    } else {
+        m_samples[m_next] = sample;
+        m_next = (m_next + 1) % Window;
+    }
+    update();
+}
+
+void ClockSync::update()
+{
+    // L'échange le plus rapide est le moins déformé par les files d'attente
+    const Sample *best = &m_samples.first();
+    for (const Sample &sample : std::as_const(m_samples)) {
+        if (sample.delay < best->delay) {
+            best = &sample;
+        }
+    }
+    m_offset = best->offset;
+    m_delay = best->delay;
+
+    double variance = 0.0;
+    for (const Sample &sample : std::as_const(m_samples)) {
+        const double deviation = double(sample.offset - m_offset);
+        variance += deviation * deviation;
+    }
+    m_jitter = qint64(std::sqrt(variance / m_samples.size()));
+}
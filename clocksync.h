@@ -0,0 +1,97 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * @brief Estimation de l'écart entre l'horloge locale et celle d'un pair
+ *
+ * Chaque échange 'clock_ping' / 'clock_pong' fournit quatre instants, comme en NTP :
+ * t0 (envoi local), t1 (réception chez le pair), t2 (réponse du pair) et t3 (réception
+ * locale). On en déduit l'écart ((t1 - t0) + (t2 - t3)) / 2 et le délai aller-retour
+ * (t3 - t0) - (t2 - t1).
+ *
+ * Parmi les Window derniers échanges, l'écart retenu est celui de l'échange au plus
+ * petit délai : c'est le moins perturbé par les files d'attente, qui allongent un seul
+ * sens du trajet et faussent donc l'écart. La gigue est l'écart type des écarts de la
+ * fenêtre autour de cette estimation.
+ *
+ * Toutes les durées sont en microsecondes.
+ */
+class ClockSync
+{
+public:
+    static const int Window = 8;    ///< Échanges conservés pour l'estimation
+
+    /**
+     * @brief Constructeur d'une estimation vide
+     */
+    ClockSync();
+
+    /**
+     * @brief Ajoute un échange ping/pong
+     * @param t0 Envoi du ping (horloge locale)
+     * @param t1 Réception du ping (horloge du pair)
+     * @param t2 Envoi du pong (horloge du pair)
+     * @param t3 Réception du pong (horloge locale)
+     */
+    void addSample(qint64 t0, qint64 t1, qint64 t2, qint64 t3);
+
+    /**
+     * @brief Indique si au moins un échange a été mesuré
+     */
+    bool isSynchronized() const { return !m_samples.isEmpty(); }
+
+    /**
+     * @brief Obtient l'écart estimé
+     * @return Horloge du pair moins horloge locale
+     */
+    qint64 offset() const { return m_offset; }
+
+    /**
+     * @brief Obtient le délai aller-retour de l'échange retenu
+     */
+    qint64 delay() const { return m_delay; }
+
+    /**
+     * @brief Obtient la gigue des écarts mesurés
+     */
+    qint64 jitter() const { return m_jitter; }
+
+    /**
+     * @brief Convertit un instant local dans l'horloge du pair
+     * @param localTime Instant local
+     * @return Instant correspondant chez le pair
+     */
+    qint64 toRemote(qint64 localTime) const { return localTime + m_offset; }
+
+    /**
+     * @brief Convertit un instant de l'horloge du pair en instant local
+     * @param remoteTime Instant chez le pair
+     * @return Instant local correspondant
+     */
+    qint64 toLocal(qint64 remoteTime) const { return remoteTime - m_offset; }
+
+private:
+    /**
+     * @brief Résultat d'un échange
+     */
+    struct Sample {
+        qint64 offset;  // Écart mesuré
+        qint64 delay;   // Délai aller-retour
+    };
+
+    QVector<Sample> m_samples;  // Derniers échanges, au plus Window
+    int m_next;                 // Prochain échange remplacé une fois la fenêtre pleine
+    qint64 m_offset;            // Écart retenu
+    qint64 m_delay;             // Délai de l'échange retenu
+    qint64 m_jitter;            // Gigue des écarts
+
+    /**
+     * @brief Recalcule l'estimation à partir de la fenêtre
+     */
+    void update();
+};
+
+#endif // CLOCKSYNC_H
@@ -0,0 +1,196 @@
+#include "latencymonitor.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QDebug>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(BucketCount, 0)
+    , m_count(0)
+    , m_sum(0)
+    , m_max(0)
+{
+}
+
+void LatencyHistogram::record(qint64 microseconds)
+{
+    microseconds = qMax<qint64>(0, microseconds);
+    m_buckets[bucketFor(microseconds)]++;
+    m_count++;
+    m_sum += microseconds;
+    m_max = qMax(m_max, microseconds);
+}
+
+qint64 LatencyHistogram::percentile(double percentile) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(percentile / 100.0 * double(m_count))));
+    quint64 cumulated = 0;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        cumulated += m_buckets[bucket];
+        if (cumulated >= rank) {
+            // La borne de la classe ne dépasse jamais la plus grande mesure
+            return qMin(upperBound(bucket), m_max);
+        }
+    }
+    return m_max;
+}
+
+int LatencyHistogram::bucketFor(qint64 microseconds)
+{
+    if (microseconds < LinearBuckets) {
+        return int(microseconds);
+    }
+
+    // Octave (bit de poids fort) puis les 4 bits suivants comme subdivision
+    const int octave = 63 - int(qCountLeadingZeroBits(quint64(microseconds)));
+    const int sub = int((microseconds >> (octave - 4)) & (SubBuckets - 1));
+    return qMin(BucketCount - 1, LinearBuckets + (octave - 6) * SubBuckets + sub);
+}
+
+qint64 LatencyHistogram::upperBound(int bucket)
+{
+    if (bucket < LinearBuckets) {
+        return bucket;
+    }
+
+    const int octave = (bucket - LinearBuckets) / SubBuckets + 6;
+    const int sub = (bucket - LinearBuckets) % SubBuckets;
+    return ((qint64(SubBuckets + sub + 1)) << (octave - 4)) - 1;
+}
+
+LatencyMonitor *LatencyMonitor::instance()
+{
+    static LatencyMonitor *monitor = new LatencyMonitor();
+    return monitor;
+}
+
+LatencyMonitor::LatencyMonitor()
+    : m_outputBufferLatency(0)
+    , m_outputPeriod(0)
+{
+}
+
+qint64 LatencyMonitor::now()
+{
+    // steady_clock ne dépend ni de l'heure système ni d'un objet Qt: utilisable sur le thread audio
+    const auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return qMax<qint64>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void LatencyMonitor::record(const LatencySample &sample)
+{
+    if (sample.inputTime <= 0 || sample.dispatchTime < sample.inputTime || sample.outputTime < sample.dispatchTime) {
+        return;
+    }
+
+    const qint64 queue = (sample.dispatchTime - sample.inputTime) / 1000;
+    const qint64 render = (sample.outputTime - sample.dispatchTime) / 1000;
+    const qint64 total = (sample.outputTime - sample.inputTime) / 1000;
+
+    QMutexLocker locker(&m_mutex);
+    for (Stages *stages : { &m_global, &m_pads[sample.padKey] }) {
+        stages->queue.record(queue);
+        stages->render.record(render);
+        stages->total.record(total);
+    }
+}
+
+void LatencyMonitor::setOutputTiming(qint64 bufferMicroseconds, qint64 periodMicroseconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputBufferLatency = bufferMicroseconds;
+    m_outputPeriod = periodMicroseconds;
+}
+
+void LatencyMonitor::setOutputStats(const OutputStats &stats)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputStats = stats;
+}
+
+void LatencyMonitor::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_global = Stages();
+    m_pads.clear();
+
+    // Les compteurs du mixeur sont cumulés: repartir de leur valeur actuelle
+    m_outputBaseline = m_outputStats;
+}
+
+QString LatencyMonitor::report(const QHash<quintptr, QString> &padNames) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString text;
+    text += QString("Latence des déclenchements (%1)\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate));
+    text += QString("Tampon de sortie: %1 ms, à ajouter au total (périodes de %2 ms)\n")
+                .arg(m_outputBufferLatency / 1000.0, 0, 'f', 1).arg(m_outputPeriod / 1000.0, 0, 'f', 2);
+    text += QString("Rappels de la sortie: %1, manques: %2, dépassements: %3, plus long depuis l'ouverture: %4 ms\n\n")
+                .arg(m_outputStats.callbacks - m_outputBaseline.callbacks)
+                .arg(m_outputStats.underruns - m_outputBaseline.underruns)
+                .arg(m_outputStats.overruns - m_outputBaseline.overruns)
+                .arg(m_outputStats.maxCallback / 1.0e6, 0, 'f', 2);
+    appendStages(text, "Tous les pads", m_global);
+
+    // Pads les plus déclenchés en premier
+    QList<quintptr> keys = m_pads.keys();
+    std::sort(keys.begin(), keys.end(), [this](quintptr a, quintptr b) {
+        return m_pads[a].total.count() > m_pads[b].total.count();
+    });
+
+    for (quintptr key : keys) {
+        const QString name = padNames.value(key, QString("pad supprimé (0x%1)").arg(key, 0, 16));
+        text += "\n";
+        appendStages(text, name, m_pads[key]);
+    }
+
+    return text;
+}
+
+bool LatencyMonitor::dump(const QString &filePath, const QHash<quintptr, QString> &padNames) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        qDebug() << "ERREUR: Impossible d'écrire le rapport de latence:" << filePath << file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream << report(padNames);
+    qDebug() << "Rapport de latence écrit:" << filePath;
+    return true;
+}
+
+void LatencyMonitor::appendStages(QString &text, const QString &title, const Stages &stages)
+{
+    text += QString("%1 (%2 déclenchements)\n").arg(title).arg(stages.total.count());
+    text += QString("  %1 %2 %3 %4 %5 %6\n")
+                .arg("(ms)", -8).arg("p50", 9).arg("p95", 9).arg("p99", 9).arg("max", 9).arg("moyenne", 9);
+
+    const QList<QPair<QString, const LatencyHistogram*>> rows = {
+        { "file", &stages.queue },
+        { "rendu", &stages.render },
+        { "total", &stages.total }
+    };
+    for (const auto &row : rows) {
+        const LatencyHistogram &histogram = *row.second;
+        auto ms = [](double microseconds) { return QString::number(microseconds / 1000.0, 'f', 2); };
+        text += QString("  %1 %2 %3 %4 %5 %6\n")
+                    .arg(row.first, -8)
+                    .arg(ms(histogram.percentile(50)), 9)
+                    .arg(ms(histogram.percentile(95)), 9)
+                    .arg(ms(histogram.percentile(99)), 9)
+                    .arg(ms(histogram.max()), 9)
+                    .arg(ms(histogram.mean()), 9);
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+/**
+ * @brief Mesure d'un déclenchement, de l'entrée utilisateur au tampon de sortie
+ *
+ * Les trois instants sont donnés par LatencyMonitor::now().
+ */
+struct LatencySample
+{
+    quintptr padKey = 0;        // Pad déclenché
+    qint64 inputTime = 0;       // Réception du clic ou de la touche (thread de l'interface)
+    qint64 dispatchTime = 0;    // Prise en compte par le thread audio
+    qint64 outputTime = 0;      // Écriture de la première trame dans le tampon de sortie
+};
+
+/**
+ * @brief Compteurs des rappels de la sortie audio, relevés par le mixeur
+ *
+ * Un manque est compté lorsque deux rappels sont plus espacés que la durée du tampon
+ * du périphérique : celui-ci s'est forcément vidé entre-temps. Un dépassement est un
+ * rappel dont le mixage a duré plus longtemps que le son qu'il a produit.
+ */
+struct OutputStats
+{
+    quint64 callbacks = 0;      // Rappels de la sortie
+    quint64 underruns = 0;      // Tampon du périphérique vidé entre deux rappels
+    quint64 overruns = 0;       // Rappels plus longs que le son produit
+    qint64 maxCallback = 0;     // Rappel le plus long (ns)
+};
+
+/**
+ * @brief Histogramme de durées à résolution relative constante
+ *
+ * Les durées sont comptées en microsecondes : exactement jusqu'à 64 µs, puis dans 16
+ * classes par octave (environ 4 % de résolution). La mémoire est fixe quel que soit le
+ * nombre de mesures.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    /**
+     * @brief Ajoute une mesure
+     * @param microseconds Durée mesurée
+     */
+    void record(qint64 microseconds);
+
+    /**
+     * @brief Obtient un centile
+     * @param percentile Centile souhaité, entre 0 et 100
+     * @return Borne supérieure de la classe du centile (µs), 0 sans mesure
+     */
+    qint64 percentile(double percentile) const;
+
+    quint64 count() const { return m_count; }
+    qint64 max() const { return m_max; }
+    double mean() const { return m_count > 0 ? double(m_sum) / double(m_count) : 0.0; }
+
+private:
+    static const int LinearBuckets = 64;    // Classes d'une microseconde
+    static const int SubBuckets = 16;       // Classes par octave au-delà
+    static const int BucketCount = LinearBuckets + 30 * SubBuckets;
+
+    QVector<quint32> m_buckets;     // Nombre de mesures par classe
+    quint64 m_count;                // Nombre de mesures
+    qint64 m_sum;                   // Somme des mesures (µs)
+    qint64 m_max;                   // Plus grande mesure (µs)
+
+    static int bucketFor(qint64 microseconds);
+    static qint64 upperBound(int bucket);
+};
+
+/**
+ * @brief Statistiques de latence des déclenchements, globales et par pad
+ *
+ * Chaque mesure est découpée en trois durées :
+ * - file : de l'entrée utilisateur à la prise en compte par le thread audio ;
+ * - rendu : de la prise en compte à l'écriture de la première trame ;
+ * - total : de l'entrée utilisateur à l'écriture de la première trame.
+ *
+ * La latence du périphérique (durée du tampon de sortie) s'y ajoute et figure dans le
+ * rapport, avec les manques et dépassements des rappels de la sortie. Les mesures sont
+ * relevées par l'AudioEngine ; toutes les méthodes peuvent être appelées depuis
+ * n'importe quel thread.
+ */
+class LatencyMonitor
+{
+public:
+    /**
+     * @brief Obtient l'instance partagée par toute l'application
+     * @return Instance unique
+     */
+    static LatencyMonitor *instance();
+
+    /**
+     * @brief Horloge monotone commune à tous les threads
+     * @return Instant courant (ns), jamais nul
+     */
+    static qint64 now();
+
+    /**
+     * @brief Ajoute une mesure complète
+     * @param sample Mesure transmise par le mixeur
+     */
+    void record(const LatencySample &sample);
+
+    /**
+     * @brief Définit la configuration de la sortie audio, pour le rapport
+     * @param bufferMicroseconds Durée du tampon du périphérique
+     * @param periodMicroseconds Durée d'une période de mixage
+     */
+    void setOutputTiming(qint64 bufferMicroseconds, qint64 periodMicroseconds);
+
+    /**
+     * @brief Met à jour les compteurs de la sortie audio, pour le rapport
+     * @param stats Compteurs cumulés du mixeur
+     */
+    void setOutputStats(const OutputStats &stats);
+
+    /**
+     * @brief Efface toutes les mesures
+     */
+    void reset();
+
+    /**
+     * @brief Produit un rapport texte (centiles p50/p95/p99 et maximum)
+     * @param padNames Noms des pads à afficher, par identifiant
+     * @return Rapport lisible
+     */
+    QString report(const QHash<quintptr, QString> &padNames = QHash<quintptr, QString>()) const;
+
+    /**
+     * @brief Écrit le rapport dans un fichier
+     * @param filePath Chemin du fichier
+     * @param padNames Noms des pads à afficher, par identifiant
+     * @return true si le fichier a été écrit
+     */
+    bool dump(const QString &filePath, const QHash<quintptr, QString> &padNames = QHash<quintptr, QString>()) const;
+
+private:
+    LatencyMonitor();
+
+    /**
+     * @brief Histogrammes d'un ensemble de déclenchements
+     */
+    struct Stages {
+        LatencyHistogram queue;     // Entrée -> thread audio
+        LatencyHistogram render;    // Thread audio -> première trame écrite
+        LatencyHistogram total;     // Entrée -> première trame écrite
+    };
+
+    Stages m_global;                        // Tous les pads
+    QHash<quintptr, Stages> m_pads;         // Par pad
+    qint64 m_outputBufferLatency;           // Durée du tampon de sortie (µs)
+    qint64 m_outputPeriod;                  // Durée d'une période de mixage (µs)
+    OutputStats m_outputStats;              // Derniers compteurs de la sortie
+    OutputStats m_outputBaseline;           // Compteurs lors de la dernière remise à zéro
+    mutable QMutex m_mutex;                 // Protège les statistiques
+
+    static void appendStages(QString &text, const QString &title, const Stages &stages);
+};
+
+#endif // LATENCYMONITOR_H
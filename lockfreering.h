@@ -0,0 +1,117 @@
+#ifndef LOCKFREERING_H
+#define LOCKFREERING_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief File circulaire bornée sans verrou, à plusieurs producteurs et un consommateur
+ *
+ * Chaque case porte un numéro de séquence qui indique si elle est libre pour le tour
+ * courant du producteur ou prête pour le consommateur (file bornée de D. Vyukov).
+ * Un producteur réserve une case par une seule opération compare-and-swap, répétée
+ * uniquement si un autre producteur l'a devancé ; le consommateur ne boucle jamais.
+ * Aucune méthode n'alloue de mémoire ni ne prend de verrou : la file peut être vidée
+ * depuis le thread audio.
+ *
+ * Avec un seul producteur, la réservation réussit toujours du premier coup et la file
+ * se comporte comme une file SPSC.
+ *
+ * @tparam T Type des éléments (déplacé dans la file puis hors de la file)
+ * @tparam Capacity Nombre de cases, puissance de deux
+ */
+template <typename T, int Capacity>
+class LockFreeRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity doit être une puissance de deux");
+
+public:
+    LockFreeRing()
+        : m_head(0)
+        , m_tail(0)
+    {
+        for (int i = 0; i < Capacity; ++i) {
+            m_cells[i].sequence.store(quint64(i), std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeRing(const LockFreeRing &) = delete;
+    LockFreeRing &operator=(const LockFreeRing &) = delete;
+
+    /**
+     * @brief Ajoute un élément (n'importe quel thread)
+     * @param value Élément à déplacer dans la file
+     * @return false si la file est pleine ; l'élément n'est alors pas modifié
+     */
+    bool push(T &&value)
+    {
+        quint64 position = m_tail.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[position & Mask];
+            const quint64 sequence = cell->sequence.load(std::memory_order_acquire);
+            const qint64 difference = qint64(sequence) - qint64(position);
+            if (difference == 0) {
+                // Case libre pour ce tour: la réserver
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false; // Le consommateur n'a pas encore libéré cette case
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Ajoute une copie d'un élément (n'importe quel thread)
+     * @param value Élément à copier
+     * @return false si la file est pleine
+     */
+    bool push(const T &value)
+    {
+        T copy = value;
+        return push(std::move(copy));
+    }
+
+    /**
+     * @brief Retire le plus ancien élément (thread consommateur uniquement)
+     * @param value Reçoit l'élément
+     * @return false si la file est vide
+     */
+    bool pop(T &value)
+    {
+        const quint64 position = m_head.load(std::memory_order_relaxed);
+        Cell &cell = m_cells[position & Mask];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        value = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(position + Capacity, std::memory_order_release);
+        m_head.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    static const quint64 Mask = Capacity - 1;
+
+    struct Cell {
+        std::atomic<quint64> sequence;  // Tour attendu pour cette case
+        T value;                        // Élément stocké
+    };
+
+    alignas(64) std::atomic<quint64> m_head;    // Prochaine case lue (consommateur)
+    alignas(64) std::atomic<quint64> m_tail;    // Prochaine case réservée (producteurs)
+    alignas(64) std::array<Cell, Capacity> m_cells; // Cases de la file
+};
+
+#endif // LOCKFREERING_H
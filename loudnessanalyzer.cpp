@@ -0,0 +1,278 @@
+#include "loudnessanalyzer.h"
+#include "loudnessmeter.h"
+#include "assetstore.h"
+#include "audioengine.h"
+#include "chunkeddecoder.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QAudioBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+LoudnessAnalyzer *LoudnessAnalyzer::instance()
+{
+    static LoudnessAnalyzer *analyzer = new LoudnessAnalyzer();
+    return analyzer;
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer(QObject *parent)
+    : QObject(parent)
+    , m_pool(nullptr)
+    , m_saveScheduled(false)
+    , m_stopping(false)
+{
+    qRegisterMetaType<LoudnessAnalyzer::Result>();
+
+    // À côté du dossier du stockage: un fichier .json dans ce dossier serait pris pour un son
+    const QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataPath);
+    m_indexPath = dataPath + "/loudness.json";
+    loadIndex();
+
+    // Un seul thread de faible priorité: l'analyse ne doit jamais ralentir l'import ni la lecture
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(1);
+    m_pool->setThreadPriority(QThread::LowestPriority);
+
+    // Analyser les sons dès leur arrivée dans le stockage
+    connect(AssetStore::instance(), &AssetStore::assetAdded, this, [this](const QString &hash) {
+        const QString path = AssetStore::instance()->filePath(hash);
+        const QString suffix = QFileInfo(path).suffix();
+        if (suffix == "mp3" || suffix == "wav" || suffix == "ogg") {
+            analyze(path);
+        }
+    });
+
+    // Abandonner les analyses en attente et interrompre celle en cours: la fermeture
+    // n'attend que la fin du tampon en train d'être mesuré
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        m_stopping = true;
+        m_pool->clear();
+        m_pool->waitForDone();
+    });
+}
+
+bool LoudnessAnalyzer::lookup(const QString &filePath, Result &result) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QString hash = knownHashLocked(filePath);
+    auto it = m_results.constFind(hash);
+    if (hash.isEmpty() || it == m_results.constEnd()) {
+        return false;
+    }
+    result = *it;
+    return true;
+}
+
+void LoudnessAnalyzer::analyze(const QString &filePath)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        const QString hash = knownHashLocked(filePath);
+        if ((!hash.isEmpty() && m_results.contains(hash)) || m_pending.contains(filePath)) {
+            return;
+        }
+        m_pending.insert(filePath);
+    }
+
+    m_pool->start([this, filePath]() {
+        process(filePath);
+    });
+}
+
+void LoudnessAnalyzer::process(const QString &filePath)
+{
+    // Empreinte du contenu: nom du fichier dans le stockage, sinon calculée une fois par version du fichier
+    const QFileInfo fileInfo(filePath);
+    QString hash;
+    {
+        QMutexLocker locker(&m_mutex);
+        hash = knownHashLocked(filePath);
+    }
+    if (hash.isEmpty()) {
+        hash = AssetStore::hashFile(filePath);
+        if (hash.isEmpty()) {
+            QMutexLocker locker(&m_mutex);
+            m_pending.remove(filePath);
+            return;
+        }
+        QMutexLocker locker(&m_mutex);
+        m_paths.insert(fileInfo.canonicalFilePath(),
+                       { fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch(), hash });
+    }
+
+    // Même contenu déjà mesuré sous un autre chemin
+    Result result;
+    bool known = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_results.constFind(hash);
+        if (it != m_results.constEnd()) {
+            result = *it;
+            known = true;
+        }
+    }
+
+    if (!known) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!measure(filePath, m_stopping, result)) {
+            QMutexLocker locker(&m_mutex);
+            m_pending.remove(filePath);
+            return;
+        }
+        qDebug() << "Sonie mesurée:" << filePath << result.integratedLoudness << "LUFS, crête"
+                 << result.truePeak << "dBTP en" << timer.elapsed() << "ms";
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_results.insert(hash, result);
+        m_pending.remove(filePath);
+        if (!m_saveScheduled) {
+            m_saveScheduled = true;
+            QMetaObject::invokeMethod(this, &LoudnessAnalyzer::saveIndex, Qt::QueuedConnection);
+        }
+    }
+
+    emit analyzed(filePath, result);
+}
+
+bool LoudnessAnalyzer::measure(const QString &filePath, const std::atomic<bool> &stopping, Result &result)
+{
+    AudioSample chunk;
+    std::unique_ptr<LoudnessMeter> meter;
+
+    // Chaque tampon est mesuré puis oublié: la mémoire ne dépend pas de la durée du fichier
+    QString error;
+    const ChunkedDecoder::Result decoded = ChunkedDecoder::decode(filePath, [&](const QAudioBuffer &buffer) {
+        chunk.data.clear();
+        chunk.pcm16.clear();
+        chunk.channels = 0;
+        AudioEngine::appendBuffer(chunk, buffer);
+        if (chunk.channels > 0) {
+            if (!meter) {
+                meter.reset(new LoudnessMeter(chunk.sampleRate, chunk.channels));
+            }
+            meter->process(chunk);
+        }
+        return true;
+    }, &stopping, &error);
+
+    if (decoded == ChunkedDecoder::Failed) {
+        qDebug() << "ERREUR: Analyse de sonie impossible" << filePath << ":" << error;
+        return false;
+    }
+    if (decoded == ChunkedDecoder::Stopped) {
+        qDebug() << "Analyse de sonie interrompue:" << filePath;
+        return false;
+    }
+
+    result.integratedLoudness = meter ? meter->integratedLoudness() : -std::numeric_limits<double>::infinity();
+    result.truePeak = meter ? meter->truePeak() : -std::numeric_limits<double>::infinity();
+    return true;
+}
+
+QString LoudnessAnalyzer::knownHashLocked(const QString &filePath) const
+{
+    const QString storedHash = AssetStore::instance()->hashForStoredPath(filePath);
+    if (!storedHash.isEmpty()) {
+        return storedHash;
+    }
+
+    // Fichier hors du stockage: l'empreinte mémorisée ne vaut que s'il n'a pas changé
+    const QFileInfo fileInfo(filePath);
+    auto it = m_paths.constFind(fileInfo.canonicalFilePath());
+    if (it == m_paths.constEnd() || it->size != fileInfo.size()
+        || it->modified != fileInfo.lastModified().toMSecsSinceEpoch()) {
+        return QString();
+    }
+    return it->hash;
+}
+
+void LoudnessAnalyzer::loadIndex()
+{
+    QFile file(m_indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+
+    // Un fichier silencieux est enregistré sans valeur
+    const double silent = -std::numeric_limits<double>::infinity();
+    const QJsonObject results = index["results"].toObject();
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        const QJsonObject entry = it.value().toObject();
+        m_results.insert(it.key(), { entry["integrated"].toDouble(silent), entry["true_peak"].toDouble(silent) });
+    }
+
+    const QJsonObject paths = index["paths"].toObject();
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        const QJsonObject path = it.value().toObject();
+        m_paths.insert(it.key(), { path["size"].toInteger(), path["modified"].toInteger(), path["hash"].toString() });
+    }
+
+    qDebug() << "Index de sonie:" << m_results.size() << "fichiers mesurés";
+}
+
+void LoudnessAnalyzer::saveIndex()
+{
+    QJsonObject results;
+    QJsonObject paths;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_saveScheduled = false;
+
+        for (auto it = m_results.constBegin(); it != m_results.constEnd(); ++it) {
+            QJsonObject entry;
+            if (std::isfinite(it->integratedLoudness)) {
+                entry["integrated"] = it->integratedLoudness;
+            }
+            if (std::isfinite(it->truePeak)) {
+                entry["true_peak"] = it->truePeak;
+            }
+            results[it.key()] = entry;
+        }
+
+        for (auto it = m_paths.constBegin(); it != m_paths.constEnd(); ++it) {
+            QJsonObject path;
+            path["size"] = it->size;
+            path["modified"] = it->modified;
+            path["hash"] = it->hash;
+            paths[it.key()] = path;
+        }
+    }
+
+    QJsonObject index;
+    index["version"] = 1;
+    index["results"] = results;
+    index["paths"] = paths;
+
+    // Écrire dans un fichier temporaire pour ne jamais laisser un index tronqué
+    QFile file(m_indexPath + ".tmp");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "ERREUR: Impossible d'écrire l'index de sonie:" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    file.close();
+
+    QFile::remove(m_indexPath);
+    QFile::rename(file.fileName(), m_indexPath);
+}
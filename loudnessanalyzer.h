@@ -0,0 +1,132 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <atomic>
+
+class QThreadPool;
+
+/**
+ * @brief Analyse de sonie des fichiers audio, en arrière-plan et mémorisée
+ *
+ * Chaque fichier audio est décodé par morceaux sur un thread de faible priorité et
+ * mesuré par un LoudnessMeter (sonie intégrée EBU R128 et crête vraie). Les mesures
+ * sont conservées dans "loudness.json", à côté du stockage des fichiers, et indexées
+ * par l'empreinte du contenu : un fichier n'est analysé qu'une fois, quel que soit
+ * son chemin, et une room rejointe à nouveau ne relance aucune analyse.
+ *
+ * Les fichiers ajoutés à l'AssetStore sont analysés dès leur arrivée ; un fichier
+ * situé hors du stockage l'est à la demande (analyze()), son empreinte étant
+ * mémorisée tant qu'il n'est pas modifié. Ni l'import ni la lecture n'attendent
+ * l'analyse : le résultat est publié par analyzed(). À la fermeture, l'analyse en cours
+ * est interrompue et le fichier sera mesuré de nouveau à la prochaine session.
+ *
+ * Toutes les méthodes peuvent être appelées depuis n'importe quel thread.
+ */
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Mesures d'un fichier
+     */
+    struct Result {
+        double integratedLoudness;  // Sonie intégrée (LUFS), -infini pour un fichier silencieux
+        double truePeak;            // Crête vraie (dBTP), -infini pour un fichier silencieux
+    };
+
+    /**
+     * @brief Obtient l'instance partagée par toute l'application
+     * @return Instance unique
+     */
+    static LoudnessAnalyzer *instance();
+
+    /**
+     * @brief Cherche les mesures déjà connues d'un fichier, sans lire son contenu
+     * @param filePath Chemin du fichier
+     * @param result Reçoit les mesures
+     * @return false si le fichier n'a pas encore été analysé
+     */
+    bool lookup(const QString &filePath, Result &result) const;
+
+    /**
+     * @brief Lance l'analyse d'un fichier en arrière-plan s'il n'est pas déjà mesuré
+     * @param filePath Chemin du fichier
+     */
+    void analyze(const QString &filePath);
+
+signals:
+    /**
+     * @brief Signal émis lorsqu'un fichier vient d'être mesuré (thread d'analyse)
+     * @param filePath Chemin du fichier, tel que donné à analyze()
+     * @param result Mesures
+     */
+    void analyzed(const QString &filePath, const LoudnessAnalyzer::Result &result);
+
+private slots:
+    /**
+     * @brief Écrit l'index des mesures sur le disque
+     */
+    void saveIndex();
+
+private:
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit LoudnessAnalyzer(QObject *parent = nullptr);
+
+    /**
+     * @brief Empreinte déjà calculée pour un fichier hors du stockage
+     */
+    struct PathEntry {
+        qint64 size;            // Taille du fichier lors du calcul
+        qint64 modified;        // Date de modification lors du calcul (ms)
+        QString hash;           // Empreinte calculée
+    };
+
+    QString m_indexPath;                    // Chemin de "loudness.json"
+    QHash<QString, Result> m_results;       // Mesures par empreinte
+    QHash<QString, PathEntry> m_paths;      // Empreintes des fichiers hors du stockage, par chemin
+    QSet<QString> m_pending;                // Fichiers en attente d'analyse
+    QThreadPool *m_pool;                    // Thread d'analyse
+    bool m_saveScheduled;                   // Sauvegarde de l'index déjà demandée
+    std::atomic<bool> m_stopping;           // Fermeture en cours: interrompre l'analyse
+    mutable QMutex m_mutex;                 // Protège les mesures et les empreintes
+
+    /**
+     * @brief Charge l'index de la session précédente
+     */
+    void loadIndex();
+
+    /**
+     * @brief Retrouve l'empreinte d'un fichier sans lire son contenu (verrou tenu)
+     * @param filePath Chemin du fichier
+     * @return Empreinte, ou une chaîne vide si elle n'est pas encore connue
+     */
+    QString knownHashLocked(const QString &filePath) const;
+
+    /**
+     * @brief Analyse un fichier (thread d'analyse)
+     * @param filePath Chemin du fichier
+     */
+    void process(const QString &filePath);
+
+    /**
+     * @brief Décode un fichier par morceaux et le mesure (thread d'analyse)
+     * @param filePath Chemin du fichier
+     * @param stopping Drapeau d'arrêt, levé à la fermeture
+     * @param result Reçoit les mesures
+     * @return false si le fichier n'a pas pu être décodé ou si l'analyse a été interrompue
+     */
+    static bool measure(const QString &filePath, const std::atomic<bool> &stopping, Result &result);
+};
+
+Q_DECLARE_METATYPE(LoudnessAnalyzer::Result)
+
+#endif // LOUDNESSANALYZER_H
@@ -0,0 +1,200 @@
+#include "loudnessmeter.h"
+#include <QtMath>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double AbsoluteGate = -70.0;      // Seuil absolu (LUFS)
+const double RelativeGate = -10.0;      // Seuil relatif (LU sous la moyenne)
+
+// Sonie d'une énergie moyenne pondérée K (BS.1770)
+double loudnessOf(double energy)
+{
+    return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : -std::numeric_limits<double>::infinity();
+}
+
+} // namespace
+
+double LoudnessMeter::Biquad::process(int channel, double x)
+{
+    const double y = b0 * x + z1[channel];
+    z1[channel] = b1 * x - a1 * y + z2[channel];
+    z2[channel] = b2 * x - a2 * y;
+    return y;
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_channels(qBound(1, channels, 2))
+    , m_subBlockFrames(qMax(1, sampleRate / 10))
+    , m_subBlockPosition(0)
+    , m_subBlockEnergy(0.0)
+    , m_recentEnergy{ 0.0, 0.0, 0.0 }
+    , m_recentCount(0)
+    , m_totalEnergy(0.0)
+    , m_totalFrames(0)
+    , m_oversampling(sampleRate < 96000 ? 4 : (sampleRate < 192000 ? 2 : 1))
+    , m_historyPosition(0)
+    , m_peak(0.0f)
+{
+    // Pondération K pour une fréquence quelconque (coefficients de BS.1770 recalculés)
+    {
+        const double f0 = 1681.974450955533;
+        const double gain = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(M_PI * f0 / sampleRate);
+        const double vh = std::pow(10.0, gain / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        m_shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        m_shelf.b1 = 2.0 * (k * k - vh) / a0;
+        m_shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        m_shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        m_shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(M_PI * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+        m_highPass.b0 = 1.0;
+        m_highPass.b1 = -2.0;
+        m_highPass.b2 = 1.0;
+        m_highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        m_highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    designInterpolation();
+}
+
+void LoudnessMeter::designInterpolation()
+{
+    const int length = m_oversampling * InterpolationTaps;
+    const double center = (length - 1) / 2.0;
+    m_interpolation.resize(length);
+
+    // Sinus cardinal coupé à la fréquence de Nyquist d'origine, fenêtré par Hann, rangé phase par phase
+    for (int phase = 0; phase < m_oversampling; ++phase) {
+        double sum = 0.0;
+        for (int k = 0; k < InterpolationTaps; ++k) {
+            const int n = phase + k * m_oversampling;
+            const double t = (n - center) / m_oversampling;
+            const double sinc = qFuzzyIsNull(t) ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+            const double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * (n + 0.5) / length);
+            m_interpolation[phase * InterpolationTaps + k] = float(sinc * window);
+            sum += sinc * window;
+        }
+        for (int k = 0; k < InterpolationTaps; ++k) {
+            m_interpolation[phase * InterpolationTaps + k] = float(m_interpolation[phase * InterpolationTaps + k] / sum);
+        }
+    }
+
+    for (int channel = 0; channel < m_channels; ++channel) {
+        m_history[channel].fill(0.0f, InterpolationTaps);
+    }
+}
+
+void LoudnessMeter::process(const AudioSample &chunk)
+{
+    const qint64 frames = chunk.frameCount();
+    const int chunkChannels = chunk.channels;
+    const bool int16 = chunk.isInt16();
+    const void *samples = chunk.samplesAt(0);
+
+    float values[2];
+    for (qint64 frame = 0; frame < frames; ++frame) {
+        for (int channel = 0; channel < m_channels; ++channel) {
+            const qint64 index = frame * chunkChannels + qMin(channel, chunkChannels - 1);
+            values[channel] = int16 ? float(static_cast<const qint16*>(samples)[index]) / 32768.0f
+                                    : static_cast<const float*>(samples)[index];
+        }
+        processFrame(values);
+    }
+}
+
+void LoudnessMeter::processFrame(const float *values)
+{
+    double energy = 0.0;
+    for (int channel = 0; channel < m_channels; ++channel) {
+        const double weighted = m_highPass.process(channel, m_shelf.process(channel, values[channel]));
+        energy += weighted * weighted;
+
+        // Crête vraie: échantillon lui-même et valeurs interpolées autour de lui
+        QVector<float> &history = m_history[channel];
+        history[m_historyPosition] = values[channel];
+        m_peak = qMax(m_peak, std::fabs(values[channel]));
+        for (int phase = 0; m_oversampling > 1 && phase < m_oversampling; ++phase) {
+            const float *coefficients = m_interpolation.constData() + phase * InterpolationTaps;
+            float interpolated = 0.0f;
+            for (int k = 0; k < InterpolationTaps; ++k) {
+                interpolated += coefficients[k] * history[(m_historyPosition - k + InterpolationTaps) % InterpolationTaps];
+            }
+            m_peak = qMax(m_peak, std::fabs(interpolated));
+        }
+    }
+    m_historyPosition = (m_historyPosition + 1) % InterpolationTaps;
+
+    // Un son mono est joué sur les deux canaux du mixeur
+    if (m_channels == 1) {
+        energy *= 2.0;
+    }
+    m_totalEnergy += energy;
+    m_totalFrames++;
+
+    // Sous-bloc de 100 ms complet: un bloc de 400 ms se termine avec lui
+    m_subBlockEnergy += energy;
+    if (++m_subBlockPosition < m_subBlockFrames) {
+        return;
+    }
+
+    const double subBlock = m_subBlockEnergy / double(m_subBlockFrames);
+    if (m_recentCount == 3) {
+        m_blocks.append((m_recentEnergy[0] + m_recentEnergy[1] + m_recentEnergy[2] + subBlock) / 4.0);
+        m_recentEnergy[0] = m_recentEnergy[1];
+        m_recentEnergy[1] = m_recentEnergy[2];
+        m_recentEnergy[2] = subBlock;
+    } else {
+        m_recentEnergy[m_recentCount++] = subBlock;
+    }
+    m_subBlockEnergy = 0.0;
+    m_subBlockPosition = 0;
+}
+
+double LoudnessMeter::integratedLoudness() const
+{
+    // Son plus court qu'un bloc: mesuré d'un seul tenant, sans seuil
+    if (m_blocks.isEmpty()) {
+        return m_totalFrames > 0 ? loudnessOf(m_totalEnergy / double(m_totalFrames))
+                                 : -std::numeric_limits<double>::infinity();
+    }
+
+    // Seuil absolu, puis seuil relatif à la moyenne des blocs retenus
+    double sum = 0.0;
+    int count = 0;
+    for (double block : m_blocks) {
+        if (loudnessOf(block) > AbsoluteGate) {
+            sum += block;
+            count++;
+        }
+    }
+    if (count == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    const double relativeGate = loudnessOf(sum / count) + RelativeGate;
+    sum = 0.0;
+    count = 0;
+    for (double block : m_blocks) {
+        const double loudness = loudnessOf(block);
+        if (loudness > AbsoluteGate && loudness > relativeGate) {
+            sum += block;
+            count++;
+        }
+    }
+    return loudnessOf(sum / count);
+}
+
+double LoudnessMeter::truePeak() const
+{
+    return m_peak > 0.0f ? 20.0 * std::log10(double(m_peak)) : -std::numeric_limits<double>::infinity();
+}
@@ -0,0 +1,95 @@
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+#include "audiosample.h"
+
+/**
+ * @brief Mesure de sonie intégrée et de crête vraie (ITU-R BS.1770 / EBU R128)
+ *
+ * Les échantillons passent par la pondération K (filtre en plateau puis passe-haut),
+ * puis l'énergie est relevée par blocs de 400 ms qui se chevauchent de 75 %. La sonie
+ * intégrée est la moyenne des blocs retenus par le seuil absolu (-70 LUFS) puis par
+ * le seuil relatif (10 LU sous la moyenne). Un son plus court qu'un bloc est mesuré
+ * sur toute sa durée.
+ *
+ * La crête vraie est cherchée sur le signal suréchantillonné (x4 sous 96 kHz) par un
+ * filtre d'interpolation polyphase.
+ *
+ * Un son mono est mesuré tel que le mixeur le joue, sur les deux canaux. Les
+ * échantillons sont fournis par morceaux : la mémoire ne dépend pas de la durée du son
+ * (hormis un nombre par bloc de 100 ms).
+ */
+class LoudnessMeter
+{
+public:
+    /**
+     * @brief Constructeur
+     * @param sampleRate Fréquence des échantillons (Hz)
+     * @param channels Nombre de canaux (1 ou 2)
+     */
+    LoudnessMeter(int sampleRate, int channels);
+
+    /**
+     * @brief Ajoute les trames suivantes du son
+     * @param chunk Trames au nombre de canaux du compteur, en 16 bits ou en flottants
+     */
+    void process(const AudioSample &chunk);
+
+    /**
+     * @brief Obtient la sonie intégrée
+     * @return Sonie en LUFS, ou -infini pour un son silencieux
+     */
+    double integratedLoudness() const;
+
+    /**
+     * @brief Obtient la crête vraie
+     * @return Crête en dBTP, ou -infini pour un son silencieux
+     */
+    double truePeak() const;
+
+private:
+    static const int InterpolationTaps = 12;    // Coefficients par phase du filtre de crête vraie
+
+    /**
+     * @brief Filtre biquadratique (forme directe II transposée)
+     */
+    struct Biquad {
+        double b0, b1, b2, a1, a2;  // Coefficients normalisés
+        double z1[2] = { 0, 0 };    // État, par canal
+        double z2[2] = { 0, 0 };
+
+        double process(int channel, double x);
+    };
+
+    int m_channels;                     // Nombre de canaux mesurés
+    Biquad m_shelf;                     // Pondération K, premier étage
+    Biquad m_highPass;                  // Pondération K, second étage
+    qint64 m_subBlockFrames;            // Trames par sous-bloc de 100 ms
+    qint64 m_subBlockPosition;          // Trames déjà dans le sous-bloc courant
+    double m_subBlockEnergy;            // Somme des carrés du sous-bloc courant
+    double m_recentEnergy[3];           // Énergie moyenne des trois sous-blocs précédents
+    int m_recentCount;                  // Sous-blocs précédents disponibles (au plus 3)
+    QVector<double> m_blocks;           // Énergie moyenne de chaque bloc de 400 ms
+    double m_totalEnergy;               // Somme des carrés de tout le son
+    qint64 m_totalFrames;               // Trames mesurées
+
+    int m_oversampling;                 // Facteur de suréchantillonnage
+    QVector<float> m_interpolation;     // Coefficients d'interpolation, phase par phase
+    QVector<float> m_history[2];        // Derniers échantillons de chaque canal
+    int m_historyPosition;              // Prochaine case écrite dans m_history
+    float m_peak;                       // Crête (valeur absolue) relevée
+
+    /**
+     * @brief Calcule le filtre d'interpolation de la crête vraie
+     */
+    void designInterpolation();
+
+    /**
+     * @brief Ajoute un échantillon pondéré et relève sa crête vraie
+     * @param values Échantillon de chaque canal, entre -1 et 1
+     */
+    void processFrame(const float *values);
+};
+
+#endif // LOUDNESSMETER_H
@@ -1,9 +1,17 @@
 #include "mainwindow.h"
+#include "mixkernels.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // Mesure des noyaux de mixage, sans ouvrir l'interface
+    if (a.arguments().contains("--mix-benchmark")) {
+        MixKernels::runBenchmark();
+        return 0;
+    }
+
     MainWindow *w = new MainWindow();
     w->show();
     return a.exec();
@@ -1,11 +1,19 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "roomdialog.h"
+#include "assetstore.h"
+#include "audioengine.h"
+#include "latencymonitor.h"
 
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QCloseEvent>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPlainTextEdit>
+#include <QVBoxLayout>
+#include <QFontDatabase>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -35,10 +43,18 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_user, &User::nameChanged, this, [this](const QString &newName) {
         setWindowTitle(tr("SoundPad App - %1").arg(newName));
     });
+    
+    // Taille configurée et interface prête: le stockage peut évincer ses fichiers inutilisés
+    AssetStore::instance()->enableEviction();
 }
 
 MainWindow::~MainWindow()
 {
+    // Les pads existent encore: le rapport peut nommer chacun d'eux
+    if (!m_latencyReportPath.isEmpty()) {
+        LatencyMonitor::instance()->dump(m_latencyReportPath, latencyPadNames());
+    }
+    
     delete ui;
     delete m_user;
     
@@ -262,6 +278,62 @@ void MainWindow::configureUser()
            "Votre nom actuel est : %1").arg(m_user->getName()));
 }
 
+void MainWindow::showLatencyReport()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Latence des déclenchements"));
+    dialog.resize(640, 480);
+    
+    QPlainTextEdit *reportEdit = new QPlainTextEdit(&dialog);
+    reportEdit->setReadOnly(true);
+    reportEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+    QPushButton *refreshButton = buttons->addButton(tr("Actualiser"), QDialogButtonBox::ActionRole);
+    QPushButton *saveButton = buttons->addButton(tr("Enregistrer..."), QDialogButtonBox::ActionRole);
+    QPushButton *resetButton = buttons->addButton(tr("Réinitialiser"), QDialogButtonBox::ResetRole);
+    
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(reportEdit);
+    layout->addWidget(buttons);
+    
+    auto refresh = [this, reportEdit]() {
+        reportEdit->setPlainText(LatencyMonitor::instance()->report(latencyPadNames()));
+    };
+    refresh();
+    
+    connect(refreshButton, &QPushButton::clicked, &dialog, refresh);
+    connect(saveButton, &QPushButton::clicked, &dialog, [this, &dialog]() {
+        const QString filePath = QFileDialog::getSaveFileName(&dialog, tr("Enregistrer le rapport"),
+            "latence.txt", tr("Fichiers texte (*.txt)"));
+        if (!filePath.isEmpty() && !LatencyMonitor::instance()->dump(filePath, latencyPadNames())) {
+            QMessageBox::warning(&dialog, tr("Erreur"), tr("Impossible d'écrire le rapport."));
+        }
+    });
+    connect(resetButton, &QPushButton::clicked, &dialog, [refresh]() {
+        LatencyMonitor::instance()->reset();
+        refresh();
+    });
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    
+    dialog.exec();
+}
+
+QHash<quintptr, QString> MainWindow::latencyPadNames() const
+{
+    QHash<quintptr, QString> names;
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        Board *board = qobject_cast<Board*>(m_tabWidget->widget(i));
+        if (!board) {
+            continue;
+        }
+        for (SoundPad *pad : board->getSoundPads()) {
+            names.insert(reinterpret_cast<quintptr>(pad), QString("%1 / %2").arg(board->getTitle(), pad->getTitle()));
+        }
+    }
+    return names;
+}
+
 void MainWindow::setupUi()
 {
     // Configuration de la taille de la fenêtre
@@ -416,6 +488,9 @@ void MainWindow::setupMenus()
     
     QAction *userSettingsAction = settingsMenu->addAction(tr("&Configuration utilisateur"));
     connect(userSettingsAction, &QAction::triggered, this, &MainWindow::configureUser);
+    
+    QAction *latencyAction = settingsMenu->addAction(tr("&Latences..."));
+    connect(latencyAction, &QAction::triggered, this, &MainWindow::showLatencyReport);
 }
 
 void MainWindow::initUser()
@@ -424,6 +499,39 @@ void MainWindow::initUser()
     // Le constructeur attribue maintenant automatiquement un nom aléatoire
     m_user = new User();
     
+    // Taille maximale du stockage local des sons et images (en Mo)
+    const qint64 maxAssetMegabytes = m_user->getSetting("asset_cache_max_mb",
+        AssetStore::DefaultMaxSize / (1024 * 1024)).toLongLong();
+    AssetStore::instance()->setMaxSize(maxAssetMegabytes * 1024 * 1024);
+    
+    // Polyphonie des pads à lecture multiple et voix interrompue lorsqu'elle est atteinte
+    AudioEngine *engine = AudioEngine::instance();
+    engine->setMaxPolyphony(m_user->getSetting("max_polyphony", 8).toInt());
+    engine->setStealPolicy(m_user->getSetting("voice_steal_policy", "oldest").toString() == "quietest"
+                           ? AudioMixer::StealQuietest : AudioMixer::StealOldest);
+    
+    // Mémoire maximale des sons décodés (en Mo)
+    const qint64 sampleCacheMegabytes = m_user->getSetting("sample_cache_max_mb",
+        SampleCache::DefaultBudget / (1024 * 1024)).toLongLong();
+    engine->setSampleCacheBudget(sampleCacheMegabytes * 1024 * 1024);
+    
+    // Fichiers lus en continu au-delà de cette taille (en Mo, 0: jamais) et durée décodée d'avance
+    const qint64 streamingMegabytes = m_user->getSetting("streaming_threshold_mb",
+        AudioEngine::DefaultStreamingThreshold / (1024 * 1024)).toLongLong();
+    engine->setStreamingThreshold(streamingMegabytes * 1024 * 1024);
+    engine->setStreamingHead(m_user->getSetting("streaming_head_ms", AudioEngine::DefaultStreamingHead).toInt());
+    
+    // Tampon de la sortie audio (en ms) et nombre de périodes de mixage par tampon
+    engine->setOutputConfig(m_user->getSetting("output_buffer_ms", AudioEngine::DefaultOutputBuffer).toDouble(),
+        m_user->getSetting("output_periods", AudioEngine::DefaultOutputPeriods).toInt());
+    
+    // Normalisation de la sonie des pads et sonie visée (en LUFS)
+    engine->setLoudnessNormalization(m_user->getSetting("loudness_normalization", true).toBool(),
+        m_user->getSetting("loudness_target_lufs", AudioEngine::DefaultLoudnessTarget).toDouble());
+    
+    // Fichier recevant le rapport de latence à la fermeture (vide: aucun)
+    m_latencyReportPath = m_user->getSetting("latency_report_path", QString()).toString();
+    
     // Aucune demande de nom n'est nécessaire car le constructeur User gère cela
     // et attribue un nom aléatoire de personnage d'anime
     
@@ -456,7 +564,7 @@ void MainWindow::connectBoardSignals(Board *board, Room *room)
         
         // Générer un ID pour ce pad s'il n'en a pas déjà un
         if (pad->objectName().isEmpty()) {
-            QString padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
+            QString padId = SoundPad::createId();
             pad->setObjectName(padId);
             qDebug() << "ID généré pour le pad:" << padId;
         }
@@ -476,7 +584,7 @@ void MainWindow::connectBoardSignals(Board *board, Room *room)
         // Vérifier que le pad a un ID avant la notification
         if (pad->objectName().isEmpty()) {
             qDebug() << "ERREUR: pad sans ID dans le signal soundPadRemoved";
-            QString padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
+            QString padId = SoundPad::createId();
             pad->setObjectName(padId);
             qDebug() << "ID généré pour le pad avant suppression:" << padId;
         }
@@ -499,7 +607,7 @@ void MainWindow::connectBoardSignals(Board *board, Room *room)
         
         // Vérifier que le pad a un ID avant la notification
         if (pad->objectName().isEmpty()) {
-            QString padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
+            QString padId = SoundPad::createId();
             pad->setObjectName(padId);
             qDebug() << "ID généré pour le pad avant modification:" << padId;
         }
@@ -508,6 +616,12 @@ void MainWindow::connectBoardSignals(Board *board, Room *room)
         room->notifySoundPadModified(board, pad);
     });
     
+    // Signaler les raccourcis déjà utilisés par un autre pad du tableau
+    connect(board, &Board::shortcutConflict, this, [this](SoundPad *pad, SoundPad *owner, const QKeySequence &shortcut) {
+        statusBar()->showMessage(tr("Raccourci %1 déjà utilisé par « %2 » : inactif pour « %3 »")
+                                     .arg(shortcut.toString(), owner->getTitle(), pad->getTitle()), 5000);
+    });
+    
     // Connecter les signaux de la room pour mettre à jour l'interface utilisateur
     connect(room, &Room::soundpadAdded, this, [this](Board *board, SoundPad *pad) {
         // Mettre à jour l'interface utilisateur si nécessaire
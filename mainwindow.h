@@ -85,6 +85,11 @@ private slots:
      * @brief Configure les options de l'utilisateur
      */
     void configureUser();
+    
+    /**
+     * @brief Affiche les statistiques de latence des déclenchements
+     */
+    void showLatencyReport();
 
 private:
     Ui::MainWindow *ui;
@@ -96,6 +101,7 @@ private:
     QDockWidget *m_usersDock;           // Dock pour la liste des utilisateurs
     QListWidget *m_usersListWidget;     // Liste des utilisateurs connectés
     QPushButton *m_inviteButton;        // Bouton d'invitation
+    QString m_latencyReportPath;        // Rapport de latence écrit à la fermeture (vide: aucun)
     
     /**
      * @brief Configure l'interface utilisateur
@@ -118,6 +124,12 @@ private:
      * @param room Room à laquelle connecter le board
      */
     void connectBoardSignals(Board *board, Room *room);
+    
+    /**
+     * @brief Associe l'identifiant audio de chaque pad des tableaux ouverts à son titre
+     * @return Noms des pads pour le rapport de latence
+     */
+    QHash<quintptr, QString> latencyPadNames() const;
 
 };
 #endif // MAINWINDOW_H
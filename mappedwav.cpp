@@ -0,0 +1,170 @@
+#include "mappedwav.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSysInfo>
+#include <QtEndian>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+QHash<QString, std::weak_ptr<MappedWav>> MappedWav::s_mappings;
+QMutex MappedWav::s_mutex;
+
+std::shared_ptr<AudioSample> MappedWav::load(const QString &filePath, int sampleRate)
+{
+    // Les échantillons d'un WAV sont en petit-boutiste: lus sur place uniquement si le processeur l'est aussi
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian || QFileInfo(filePath).suffix().toLower() != "wav") {
+        return nullptr;
+    }
+
+    const QString key = QFileInfo(filePath).canonicalFilePath();
+    QMutexLocker locker(&s_mutex);
+
+    // Fichier déjà projeté pour un autre son encore en vie
+    std::shared_ptr<MappedWav> mapping = s_mappings.value(key).lock();
+    if (mapping) {
+        return isMixable(mapping->m_format, sampleRate) ? makeSample(mapping) : nullptr;
+    }
+
+    mapping.reset(new MappedWav(key));
+    if (!mapping->m_file.open(QIODevice::ReadOnly) || !parseHeader(mapping->m_file, mapping->m_format)) {
+        return nullptr;
+    }
+    if (!isMixable(mapping->m_format, sampleRate)) {
+        return nullptr;
+    }
+    if (!mapping->map()) {
+        qDebug() << "AVERTISSEMENT: Projection impossible, le fichier sera décodé:" << filePath
+                 << mapping->m_file.errorString();
+        return nullptr;
+    }
+
+    // Oublier au passage les projections qui ne sont plus utilisées
+    for (auto it = s_mappings.begin(); it != s_mappings.end();) {
+        it = it->expired() ? s_mappings.erase(it) : it + 1;
+    }
+    s_mappings.insert(key, mapping);
+    qDebug() << "Fichier WAV projeté en mémoire:" << filePath << "(" << mapping->m_format.dataSize << "octets)";
+    return makeSample(mapping);
+}
+
+MappedWav::MappedWav(const QString &filePath)
+    : m_file(filePath)
+    , m_data(nullptr)
+{
+}
+
+MappedWav::~MappedWav()
+{
+    if (m_data) {
+        m_file.unmap(m_data);
+    }
+}
+
+bool MappedWav::parseHeader(QFile &file, Format &format)
+{
+    const QByteArray riff = file.read(12);
+    if (riff.size() < 12 || !riff.startsWith("RIFF") || riff.mid(8, 4) != "WAVE") {
+        return false;
+    }
+
+    // Parcourir les blocs jusqu'à « data », en relevant « fmt » au passage
+    bool hasFormat = false;
+    qint64 position = 12;
+    while (position + 8 <= file.size()) {
+        file.seek(position);
+        const QByteArray header = file.read(8);
+        if (header.size() < 8) {
+            return false;
+        }
+        const QByteArray id = header.left(4);
+        const qint64 size = qFromLittleEndian<quint32>(header.constData() + 4);
+        const qint64 body = position + 8;
+
+        if (id == "fmt ") {
+            const QByteArray fmt = file.read(qMin<qint64>(size, 40));
+            if (fmt.size() < 16) {
+                return false;
+            }
+            const char *data = fmt.constData();
+            format.audioFormat = qFromLittleEndian<quint16>(data);
+            format.channels = qFromLittleEndian<quint16>(data + 2);
+            format.sampleRate = int(qFromLittleEndian<quint32>(data + 4));
+            format.blockAlign = qFromLittleEndian<quint16>(data + 12);
+            format.bitsPerSample = qFromLittleEndian<quint16>(data + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE: le vrai format est au début du sous-format
+            if (format.audioFormat == 0xFFFE && fmt.size() >= 26) {
+                format.audioFormat = qFromLittleEndian<quint16>(data + 24);
+            }
+            hasFormat = true;
+        } else if (id == "data") {
+            if (!hasFormat) {
+                return false;
+            }
+            // Taille souvent fausse (0 ou 0xFFFFFFFF) dans les fichiers enregistrés en direct
+            format.dataOffset = body;
+            format.dataSize = size == 0 || body + size > file.size() ? file.size() - body : size;
+            return format.dataSize > 0;
+        }
+
+        // Les blocs sont alignés sur deux octets
+        position = body + size + (size & 1);
+    }
+
+    return false;
+}
+
+bool MappedWav::isMixable(const Format &format, int sampleRate)
+{
+    const bool int16 = format.audioFormat == 1 && format.bitsPerSample == 16;
+    const bool float32 = format.audioFormat == 3 && format.bitsPerSample == 32;
+    const int sampleBytes = format.bitsPerSample / 8;
+
+    // Les échantillons doivent être alignés pour être lus directement par les noyaux du mixeur
+    return (int16 || float32) && (format.channels == 1 || format.channels == 2)
+           && format.sampleRate == sampleRate && format.blockAlign == format.channels * sampleBytes
+           && format.dataOffset % sampleBytes == 0;
+}
+
+bool MappedWav::map()
+{
+    m_data = m_file.map(m_format.dataOffset, m_format.dataSize);
+    if (!m_data) {
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    // madvise attend une adresse alignée sur une page
+    const quintptr pageSize = quintptr(sysconf(_SC_PAGESIZE));
+    const quintptr start = reinterpret_cast<quintptr>(m_data) & ~(pageSize - 1);
+    const size_t length = size_t(reinterpret_cast<quintptr>(m_data) + quintptr(m_format.dataSize) - start);
+    madvise(reinterpret_cast<void*>(start), length, MADV_SEQUENTIAL);
+    madvise(reinterpret_cast<void*>(start), length, MADV_WILLNEED);
+#endif
+
+    // Amener la première seconde en mémoire ici plutôt que sur le thread audio
+    const qint64 firstSecond = qMin<qint64>(m_format.dataSize, qint64(m_format.sampleRate) * m_format.blockAlign);
+    volatile uchar touched = 0;
+    for (qint64 offset = 0; offset < firstSecond; offset += 4096) {
+        touched = touched + m_data[offset];
+    }
+    Q_UNUSED(touched);
+
+    return true;
+}
+
+std::shared_ptr<AudioSample> MappedWav::makeSample(const std::shared_ptr<const MappedWav> &mapping)
+{
+    auto sample = std::make_shared<AudioSample>();
+    sample->channels = mapping->m_format.channels;
+    sample->sampleRate = mapping->m_format.sampleRate;
+    sample->mapping = mapping;
+    sample->mappedData = mapping->m_data;
+    sample->mappedFrames = mapping->m_format.dataSize / mapping->m_format.blockAlign;
+    sample->mappedInt16 = mapping->m_format.audioFormat == 1;
+    return sample;
+}
@@ -0,0 +1,95 @@
+#ifndef MAPPEDWAV_H
+#define MAPPEDWAV_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <memory>
+#include "audiosample.h"
+
+/**
+ * @brief Fichier WAV projeté en mémoire, mixé sans décodage ni copie
+ *
+ * L'en-tête RIFF est lu une fois ; si les échantillons sont déjà dans un format que
+ * le mixeur lit directement (PCM 16 bits ou flottants 32 bits, mono ou stéréo, à la
+ * fréquence de sortie), le bloc « data » est projeté en mémoire et l'AudioSample
+ * retourné pointe dans la projection. Les pages sont alors partagées avec le cache du
+ * système plutôt que copiées dans le tas de l'application.
+ *
+ * Le noyau est prévenu de la lecture prochaine du fichier (madvise) et la première
+ * seconde est lue aussitôt, sur le thread de chargement, pour que le thread audio ne
+ * soit pas retardé par des défauts de page au départ du son.
+ *
+ * Deux pads qui jouent le même fichier partagent la même projection, tant qu'un son
+ * la référence encore.
+ */
+class MappedWav
+{
+public:
+    /**
+     * @brief Projette un fichier WAV lisible sans conversion
+     * @param filePath Chemin du fichier
+     * @param sampleRate Fréquence de sortie du mixeur (Hz)
+     * @return Son lu sur place, ou nullptr si le fichier doit être décodé normalement
+     */
+    static std::shared_ptr<AudioSample> load(const QString &filePath, int sampleRate);
+
+    ~MappedWav();
+
+    MappedWav(const MappedWav &) = delete;
+    MappedWav &operator=(const MappedWav &) = delete;
+
+private:
+    /**
+     * @brief Description des échantillons lue dans l'en-tête RIFF
+     */
+    struct Format {
+        int audioFormat = 0;        // 1: PCM entier, 3: flottants IEEE
+        int channels = 0;           // Nombre de canaux
+        int sampleRate = 0;         // Fréquence (Hz)
+        int bitsPerSample = 0;      // Taille d'un échantillon (bits)
+        int blockAlign = 0;         // Taille d'une trame (octets)
+        qint64 dataOffset = 0;      // Position du bloc « data » dans le fichier
+        qint64 dataSize = 0;        // Taille du bloc « data » (octets)
+    };
+
+    explicit MappedWav(const QString &filePath);
+
+    QFile m_file;                   // Fichier projeté (la projection vit autant que lui)
+    uchar *m_data;                  // Début du bloc « data » projeté
+    Format m_format;                // Disposition des échantillons
+
+    static QHash<QString, std::weak_ptr<MappedWav>> s_mappings;    // Projections encore utilisées
+    static QMutex s_mutex;                                          // Protège s_mappings
+
+    /**
+     * @brief Lit l'en-tête RIFF et repère les blocs « fmt » et « data »
+     * @param file Fichier ouvert en lecture
+     * @param format Reçoit la description des échantillons
+     * @return false si le fichier n'est pas un WAV valide
+     */
+    static bool parseHeader(QFile &file, Format &format);
+
+    /**
+     * @brief Indique si le mixeur peut lire les échantillons sans conversion
+     * @param format Description des échantillons
+     * @param sampleRate Fréquence de sortie
+     */
+    static bool isMixable(const Format &format, int sampleRate);
+
+    /**
+     * @brief Projette le bloc « data » et prépare sa lecture
+     * @return false si la projection a échoué
+     */
+    bool map();
+
+    /**
+     * @brief Construit un son qui lit les échantillons dans une projection
+     * @param mapping Projection partagée
+     * @return Son prêt à être mixé
+     */
+    static std::shared_ptr<AudioSample> makeSample(const std::shared_ptr<const MappedWav> &mapping);
+};
+
+#endif // MAPPEDWAV_H
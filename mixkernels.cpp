@@ -0,0 +1,567 @@
+#include "mixkernels.h"
+#include <QVector>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIXKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Les noyaux vectoriels sont compilés pour leur jeu d'instructions, indépendamment des options globales
+#if defined(MIXKERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MIXKERNELS_TARGET_SSE2 __attribute__((target("sse2")))
+#define MIXKERNELS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define MIXKERNELS_TARGET_SSE2
+#define MIXKERNELS_TARGET_AVX2
+#endif
+
+namespace {
+
+const float Int16Scale = 1.0f / 32768.0f;   // Conversion int16 -> [-1, 1[
+const float ClipKnee = 0.75f;               // Seuil au-dessous duquel l'écrêtage est transparent
+
+// ---------------------------------------------------------------------------
+// Version scalaire (référence et traitement des dernières trames)
+// ---------------------------------------------------------------------------
+
+template <typename Sample>
+inline float toFloat(Sample value)
+{
+    if constexpr (std::is_same_v<Sample, qint16>) {
+        return float(value) * Int16Scale;
+    } else {
+        return value;
+    }
+}
+
+template <typename Sample, int Channels>
+float mixScalar(float *output, const void *input, qint64 frames, float gainLeft, float gainRight)
+{
+    const Sample *in = static_cast<const Sample*>(input);
+    float peak = 0.0f;
+
+    for (qint64 frame = 0; frame < frames; ++frame) {
+        const float left = toFloat(in[frame * Channels]);
+        const float right = Channels == 2 ? toFloat(in[frame * Channels + 1]) : left;
+        output[frame * 2] += left * gainLeft;
+        output[frame * 2 + 1] += right * gainRight;
+        peak = std::max(peak, std::max(std::fabs(left), std::fabs(right)));
+    }
+
+    return peak;
+}
+
+// Transparent jusqu'au seuil, puis courbe u / (1 + u) qui tend vers 1 avec une pente continue
+void softClipScalar(float *buffer, qint64 samples)
+{
+    for (qint64 i = 0; i < samples; ++i) {
+        const float magnitude = std::fabs(buffer[i]);
+        if (magnitude <= ClipKnee) {
+            continue;
+        }
+        const float over = (magnitude - ClipKnee) / (1.0f - ClipKnee);
+        const float clipped = ClipKnee + (1.0f - ClipKnee) * over / (1.0f + over);
+        buffer[i] = std::copysign(clipped, buffer[i]);
+    }
+}
+
+float dotScalar(const float *a, const float *b, qint64 count)
+{
+    float sum = 0.0f;
+    for (qint64 i = 0; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+template <typename Sample>
+void rangeScalar(const void *input, qint64 samples, float &minimum, float &maximum)
+{
+    const Sample *in = static_cast<const Sample*>(input);
+    for (qint64 i = 0; i < samples; ++i) {
+        const float value = toFloat(in[i]);
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+}
+
+const MixKernels::Table ScalarTable = {
+    "scalaire",
+    { { mixScalar<float, 1>, mixScalar<float, 2> }, { mixScalar<qint16, 1>, mixScalar<qint16, 2> } },
+    softClipScalar,
+    dotScalar,
+    { rangeScalar<float>, rangeScalar<qint16> }
+};
+
+#ifdef MIXKERNELS_X86
+
+// ---------------------------------------------------------------------------
+// SSE2: 4 trames par itération
+// ---------------------------------------------------------------------------
+
+// Charge 4 trames de la source sous forme de deux vecteurs stéréo (G D G D)
+template <typename Sample, int Channels>
+MIXKERNELS_TARGET_SSE2 inline void loadFramesSse2(const Sample *in, __m128 &first, __m128 &second)
+{
+    if constexpr (std::is_same_v<Sample, float>) {
+        if constexpr (Channels == 2) {
+            first = _mm_loadu_ps(in);
+            second = _mm_loadu_ps(in + 4);
+        } else {
+            const __m128 mono = _mm_loadu_ps(in);
+            first = _mm_unpacklo_ps(mono, mono);
+            second = _mm_unpackhi_ps(mono, mono);
+        }
+    } else {
+        const __m128 scale = _mm_set1_ps(Int16Scale);
+        __m128i values;
+        if constexpr (Channels == 2) {
+            values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        } else {
+            const __m128i mono = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+            values = _mm_unpacklo_epi16(mono, mono);
+        }
+        // Extension de signe 16 -> 32 bits
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+        first = _mm_mul_ps(_mm_cvtepi32_ps(low), scale);
+        second = _mm_mul_ps(_mm_cvtepi32_ps(high), scale);
+    }
+}
+
+template <typename Sample, int Channels>
+MIXKERNELS_TARGET_SSE2 float mixSse2(float *output, const void *input, qint64 frames, float gainLeft, float gainRight)
+{
+    const Sample *in = static_cast<const Sample*>(input);
+    const __m128 gains = _mm_setr_ps(gainLeft, gainRight, gainLeft, gainRight);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peak = _mm_setzero_ps();
+
+    qint64 frame = 0;
+    for (; frame + 4 <= frames; frame += 4) {
+        __m128 first;
+        __m128 second;
+        loadFramesSse2<Sample, Channels>(in + frame * Channels, first, second);
+
+        float *out = output + frame * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(first, gains)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(second, gains)));
+
+        peak = _mm_max_ps(peak, _mm_max_ps(_mm_and_ps(first, absMask), _mm_and_ps(second, absMask)));
+    }
+
+    alignas(16) float peaks[4];
+    _mm_store_ps(peaks, peak);
+    const float vectorPeak = std::max(std::max(peaks[0], peaks[1]), std::max(peaks[2], peaks[3]));
+
+    // Dernières trames
+    const float tailPeak = mixScalar<Sample, Channels>(output + frame * 2, in + frame * Channels,
+                                                       frames - frame, gainLeft, gainRight);
+    return std::max(vectorPeak, tailPeak);
+}
+
+MIXKERNELS_TARGET_SSE2 void softClipSse2(float *buffer, qint64 samples)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 knee = _mm_set1_ps(ClipKnee);
+    const __m128 range = _mm_set1_ps(1.0f - ClipKnee);
+    const __m128 inverseRange = _mm_set1_ps(1.0f / (1.0f - ClipKnee));
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    qint64 i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 value = _mm_loadu_ps(buffer + i);
+        const __m128 magnitude = _mm_and_ps(value, absMask);
+        const __m128 sign = _mm_andnot_ps(absMask, value);
+        const __m128 over = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(magnitude, knee), _mm_setzero_ps()), inverseRange);
+        const __m128 clipped = _mm_add_ps(_mm_min_ps(magnitude, knee),
+                                          _mm_mul_ps(range, _mm_div_ps(over, _mm_add_ps(one, over))));
+        _mm_storeu_ps(buffer + i, _mm_or_ps(clipped, sign));
+    }
+
+    softClipScalar(buffer + i, samples - i);
+}
+
+MIXKERNELS_TARGET_SSE2 float dotSse2(const float *a, const float *b, qint64 count)
+{
+    // Deux accumulateurs pour masquer la latence de l'addition
+    __m128 first = _mm_setzero_ps();
+    __m128 second = _mm_setzero_ps();
+
+    qint64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        first = _mm_add_ps(first, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        second = _mm_add_ps(second, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, _mm_add_ps(first, second));
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]) + dotScalar(a + i, b + i, count - i);
+}
+
+// Les entiers 16 bits sont comparés tels quels, 8 par instruction, et convertis une seule fois à la fin
+template <typename Sample>
+MIXKERNELS_TARGET_SSE2 void rangeSse2(const void *input, qint64 samples, float &minimum, float &maximum)
+{
+    const Sample *in = static_cast<const Sample*>(input);
+    qint64 i = 0;
+
+    if constexpr (std::is_same_v<Sample, float>) {
+        __m128 low = _mm_set1_ps(minimum);
+        __m128 high = _mm_set1_ps(maximum);
+        for (; i + 4 <= samples; i += 4) {
+            const __m128 values = _mm_loadu_ps(in + i);
+            low = _mm_min_ps(low, values);
+            high = _mm_max_ps(high, values);
+        }
+
+        alignas(16) float lows[4];
+        alignas(16) float highs[4];
+        _mm_store_ps(lows, low);
+        _mm_store_ps(highs, high);
+        minimum = *std::min_element(lows, lows + 4);
+        maximum = *std::max_element(highs, highs + 4);
+    } else {
+        __m128i low = _mm_set1_epi16(32767);
+        __m128i high = _mm_set1_epi16(-32768);
+        for (; i + 8 <= samples; i += 8) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            low = _mm_min_epi16(low, values);
+            high = _mm_max_epi16(high, values);
+        }
+
+        alignas(16) qint16 lows[8];
+        alignas(16) qint16 highs[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lows), low);
+        _mm_store_si128(reinterpret_cast<__m128i*>(highs), high);
+        if (i > 0) {
+            minimum = std::min(minimum, toFloat(*std::min_element(lows, lows + 8)));
+            maximum = std::max(maximum, toFloat(*std::max_element(highs, highs + 8)));
+        }
+    }
+
+    // Derniers échantillons
+    rangeScalar<Sample>(in + i, samples - i, minimum, maximum);
+}
+
+const MixKernels::Table Sse2Table = {
+    "SSE2",
+    { { mixSse2<float, 1>, mixSse2<float, 2> }, { mixSse2<qint16, 1>, mixSse2<qint16, 2> } },
+    softClipSse2,
+    dotSse2,
+    { rangeSse2<float>, rangeSse2<qint16> }
+};
+
+// ---------------------------------------------------------------------------
+// AVX2: 8 trames par itération
+// ---------------------------------------------------------------------------
+
+// Charge 8 trames de la source sous forme de deux vecteurs stéréo (G D G D G D G D)
+template <typename Sample, int Channels>
+MIXKERNELS_TARGET_AVX2 inline void loadFramesAvx2(const Sample *in, __m256 &first, __m256 &second)
+{
+    if constexpr (Channels == 2) {
+        if constexpr (std::is_same_v<Sample, float>) {
+            first = _mm256_loadu_ps(in);
+            second = _mm256_loadu_ps(in + 8);
+        } else {
+            const __m256 scale = _mm256_set1_ps(Int16Scale);
+            const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8));
+            first = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(low)), scale);
+            second = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(high)), scale);
+        }
+    } else {
+        __m256 mono;
+        if constexpr (std::is_same_v<Sample, float>) {
+            mono = _mm256_loadu_ps(in);
+        } else {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            mono = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(values)), _mm256_set1_ps(Int16Scale));
+        }
+        // Dupliquer chaque échantillon mono sur les deux canaux
+        first = _mm256_permutevar8x32_ps(mono, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+        second = _mm256_permutevar8x32_ps(mono, _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7));
+    }
+}
+
+template <typename Sample, int Channels>
+MIXKERNELS_TARGET_AVX2 float mixAvx2(float *output, const void *input, qint64 frames, float gainLeft, float gainRight)
+{
+    const Sample *in = static_cast<const Sample*>(input);
+    const __m256 gains = _mm256_setr_ps(gainLeft, gainRight, gainLeft, gainRight,
+                                        gainLeft, gainRight, gainLeft, gainRight);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peak = _mm256_setzero_ps();
+
+    qint64 frame = 0;
+    for (; frame + 8 <= frames; frame += 8) {
+        __m256 first;
+        __m256 second;
+        loadFramesAvx2<Sample, Channels>(in + frame * Channels, first, second);
+
+        float *out = output + frame * 2;
+        _mm256_storeu_ps(out, _mm256_fmadd_ps(first, gains, _mm256_loadu_ps(out)));
+        _mm256_storeu_ps(out + 8, _mm256_fmadd_ps(second, gains, _mm256_loadu_ps(out + 8)));
+
+        peak = _mm256_max_ps(peak, _mm256_max_ps(_mm256_and_ps(first, absMask), _mm256_and_ps(second, absMask)));
+    }
+
+    alignas(32) float peaks[8];
+    _mm256_store_ps(peaks, peak);
+    const float vectorPeak = *std::max_element(peaks, peaks + 8);
+
+    // Quitter l'état AVX avant le code SSE scalaire, sinon chaque instruction suivante est pénalisée
+    _mm256_zeroupper();
+
+    // Dernières trames
+    const float tailPeak = mixScalar<Sample, Channels>(output + frame * 2, in + frame * Channels,
+                                                       frames - frame, gainLeft, gainRight);
+    return std::max(vectorPeak, tailPeak);
+}
+
+MIXKERNELS_TARGET_AVX2 void softClipAvx2(float *buffer, qint64 samples)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 knee = _mm256_set1_ps(ClipKnee);
+    const __m256 range = _mm256_set1_ps(1.0f - ClipKnee);
+    const __m256 inverseRange = _mm256_set1_ps(1.0f / (1.0f - ClipKnee));
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    qint64 i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m256 value = _mm256_loadu_ps(buffer + i);
+        const __m256 magnitude = _mm256_and_ps(value, absMask);
+        const __m256 sign = _mm256_andnot_ps(absMask, value);
+        const __m256 over = _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(magnitude, knee), _mm256_setzero_ps()),
+                                          inverseRange);
+        const __m256 clipped = _mm256_add_ps(_mm256_min_ps(magnitude, knee),
+                                             _mm256_mul_ps(range, _mm256_div_ps(over, _mm256_add_ps(one, over))));
+        _mm256_storeu_ps(buffer + i, _mm256_or_ps(clipped, sign));
+    }
+
+    _mm256_zeroupper();
+    softClipScalar(buffer + i, samples - i);
+}
+
+MIXKERNELS_TARGET_AVX2 float dotAvx2(const float *a, const float *b, qint64 count)
+{
+    __m256 first = _mm256_setzero_ps();
+    __m256 second = _mm256_setzero_ps();
+
+    qint64 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        first = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), first);
+        second = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), second);
+    }
+
+    alignas(32) float sums[8];
+    _mm256_store_ps(sums, _mm256_add_ps(first, second));
+    _mm256_zeroupper();
+
+    float sum = 0.0f;
+    for (float value : sums) {
+        sum += value;
+    }
+    return sum + dotScalar(a + i, b + i, count - i);
+}
+
+template <typename Sample>
+MIXKERNELS_TARGET_AVX2 void rangeAvx2(const void *input, qint64 samples, float &minimum, float &maximum)
+{
+    const Sample *in = static_cast<const Sample*>(input);
+    qint64 i = 0;
+
+    if constexpr (std::is_same_v<Sample, float>) {
+        __m256 low = _mm256_set1_ps(minimum);
+        __m256 high = _mm256_set1_ps(maximum);
+        for (; i + 8 <= samples; i += 8) {
+            const __m256 values = _mm256_loadu_ps(in + i);
+            low = _mm256_min_ps(low, values);
+            high = _mm256_max_ps(high, values);
+        }
+
+        alignas(32) float lows[8];
+        alignas(32) float highs[8];
+        _mm256_store_ps(lows, low);
+        _mm256_store_ps(highs, high);
+        minimum = *std::min_element(lows, lows + 8);
+        maximum = *std::max_element(highs, highs + 8);
+    } else {
+        __m256i low = _mm256_set1_epi16(32767);
+        __m256i high = _mm256_set1_epi16(-32768);
+        for (; i + 16 <= samples; i += 16) {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            low = _mm256_min_epi16(low, values);
+            high = _mm256_max_epi16(high, values);
+        }
+
+        alignas(32) qint16 lows[16];
+        alignas(32) qint16 highs[16];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lows), low);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(highs), high);
+        if (i > 0) {
+            minimum = std::min(minimum, toFloat(*std::min_element(lows, lows + 16)));
+            maximum = std::max(maximum, toFloat(*std::max_element(highs, highs + 16)));
+        }
+    }
+
+    _mm256_zeroupper();
+    rangeScalar<Sample>(in + i, samples - i, minimum, maximum);
+}
+
+const MixKernels::Table Avx2Table = {
+    "AVX2",
+    { { mixAvx2<float, 1>, mixAvx2<float, 2> }, { mixAvx2<qint16, 1>, mixAvx2<qint16, 2> } },
+    softClipAvx2,
+    dotAvx2,
+    { rangeAvx2<float>, rangeAvx2<qint16> }
+};
+
+// ---------------------------------------------------------------------------
+// Détection du processeur
+// ---------------------------------------------------------------------------
+
+bool cpuSupportsSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true; // Toujours présent en 64 bits
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#endif
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    // AVX2 et FMA annoncés par le processeur, et registres YMM sauvegardés par le système
+    int info[4];
+    __cpuidex(info, 1, 0);
+    const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && fma && (info[1] & (1 << 5));
+#endif
+}
+
+#endif // MIXKERNELS_X86
+
+} // namespace
+
+const MixKernels::Table &MixKernels::scalar()
+{
+    return ScalarTable;
+}
+
+const MixKernels::Table *MixKernels::sse2()
+{
+#ifdef MIXKERNELS_X86
+    static const bool supported = cpuSupportsSse2();
+    return supported ? &Sse2Table : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const MixKernels::Table *MixKernels::avx2()
+{
+#ifdef MIXKERNELS_X86
+    static const bool supported = cpuSupportsAvx2();
+    return supported ? &Avx2Table : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const MixKernels::Table &MixKernels::active()
+{
+    static const Table &table = []() -> const Table & {
+        const Table *best = avx2() ? avx2() : sse2() ? sse2() : &scalar();
+        qDebug() << "Noyaux de mixage:" << best->name;
+        return *best;
+    }();
+    return table;
+}
+
+void MixKernels::runBenchmark()
+{
+    // 64 voix d'une seconde à 48 kHz, réparties entre les quatre formats de source
+    const int voices = 64;
+    const qint64 sourceFrames = 48000;
+    const qint64 blockFrames = 480;           // 10 ms à 48 kHz
+    const int blocks = 2000;
+    const double deadlineNs = 10.0e6;
+
+    QVector<QVector<float>> floatSources(voices / 2);
+    QVector<QVector<qint16>> int16Sources(voices / 2);
+    QRandomGenerator *random = QRandomGenerator::global();
+    for (int v = 0; v < voices / 2; ++v) {
+        const int channels = (v % 2) + 1;
+        floatSources[v].resize(sourceFrames * channels);
+        int16Sources[v].resize(sourceFrames * channels);
+        for (qint64 i = 0; i < sourceFrames * channels; ++i) {
+            floatSources[v][i] = float(random->generateDouble() * 2.0 - 1.0);
+            int16Sources[v][i] = qint16(random->bounded(-32768, 32768));
+        }
+    }
+
+    QVector<float> bus(blockFrames * 2);
+
+    auto measure = [&](const Table &table) {
+        float checksum = 0.0f;
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int block = 0; block < blocks; ++block) {
+            std::fill(bus.begin(), bus.end(), 0.0f);
+            const qint64 position = (block * blockFrames) % (sourceFrames - blockFrames);
+
+            for (int v = 0; v < voices / 2; ++v) {
+                const int channels = (v % 2) + 1;
+                table.mix[0][channels - 1](bus.data(), floatSources[v].constData() + position * channels,
+                                           blockFrames, 0.1f, 0.1f);
+                table.mix[1][channels - 1](bus.data(), int16Sources[v].constData() + position * channels,
+                                           blockFrames, 0.1f, 0.1f);
+            }
+            table.softClip(bus.data(), bus.size());
+            checksum += bus[block % bus.size()];
+        }
+
+        const double nsPerBlock = double(timer.nsecsElapsed()) / blocks;
+        Q_UNUSED(checksum);
+        return nsPerBlock;
+    };
+
+    const double scalarNs = measure(scalar());
+    qDebug().noquote() << QString("Mixage de %1 voix, blocs de %2 trames (échéance 10 ms)")
+                              .arg(voices).arg(blockFrames);
+
+    for (const Table *table : { &scalar(), sse2(), avx2() }) {
+        if (!table) {
+            continue;
+        }
+        const double ns = table == &scalar() ? scalarNs : measure(*table);
+        qDebug().noquote() << QString("  %1: %2 µs par bloc (%3 % de l'échéance), x%4 par rapport au scalaire")
+                                  .arg(table->name, -9)
+                                  .arg(ns / 1000.0, 0, 'f', 1)
+                                  .arg(100.0 * ns / deadlineNs, 0, 'f', 2)
+                                  .arg(scalarNs / ns, 0, 'f', 2);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef MIXKERNELS_H
+#define MIXKERNELS_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Noyaux de calcul du mixeur
+ *
+ * Chaque noyau additionne une voix dans le bus de sortie stéréo en flottants, en
+ * appliquant les gains gauche et droite (gain de la voix et panoramique). Les noyaux
+ * sont générés par templates pour chaque combinaison de source mono/stéréo et
+ * int16/flottant, puis déclinés en versions scalaire, SSE2 et AVX2. La meilleure
+ * version supportée par le processeur est choisie une fois au démarrage.
+ *
+ * Un produit scalaire vectorisé est aussi fourni pour les filtres du Resampler, ainsi
+ * qu'une recherche du minimum et du maximum pour les formes d'onde (WaveformPeaks).
+ */
+namespace MixKernels
+{
+    /**
+     * @brief Additionne une source dans le bus de sortie stéréo
+     * @param output Bus de sortie stéréo entrelacé
+     * @param input Échantillons de la source (float ou qint16, mono ou stéréo entrelacé)
+     * @param frames Nombre de trames à mixer
+     * @param gainLeft Gain appliqué au canal gauche
+     * @param gainRight Gain appliqué au canal droit
+     * @return Niveau crête de la source sur ce bloc (avant gain, entre 0 et 1)
+     */
+    using MixFunction = float (*)(float *output, const void *input, qint64 frames,
+                                  float gainLeft, float gainRight);
+
+    /**
+     * @brief Écrête doucement le bus de sortie dans [-1, 1]
+     * @param buffer Échantillons à traiter en place
+     * @param samples Nombre d'échantillons
+     */
+    using ClipFunction = void (*)(float *buffer, qint64 samples);
+
+    /**
+     * @brief Calcule le produit scalaire de deux vecteurs de flottants
+     * @param a Premier vecteur
+     * @param b Second vecteur
+     * @param count Nombre d'éléments
+     * @return Somme des produits
+     */
+    using DotFunction = float (*)(const float *a, const float *b, qint64 count);
+
+    /**
+     * @brief Élargit une plage de valeurs aux échantillons donnés
+     * @param input Échantillons (float ou qint16), tous canaux confondus
+     * @param samples Nombre d'échantillons
+     * @param minimum Minimum courant, mis à jour (entre -1 et 1)
+     * @param maximum Maximum courant, mis à jour (entre -1 et 1)
+     */
+    using RangeFunction = void (*)(const void *input, qint64 samples, float &minimum, float &maximum);
+
+    /**
+     * @brief Ensemble de noyaux pour un jeu d'instructions
+     */
+    struct Table {
+        const char *name;       // Nom du jeu d'instructions
+        MixFunction mix[2][2];  // Noyaux de mixage, indexés par [source int16][source stéréo]
+        ClipFunction softClip;  // Écrêtage doux du bus
+        DotFunction dot;        // Produit scalaire (filtres de rééchantillonnage)
+        RangeFunction range[2]; // Minimum et maximum (formes d'onde), indexés par [source int16]
+    };
+
+    /**
+     * @brief Obtient les noyaux les plus rapides supportés par le processeur
+     * @return Table choisie au premier appel
+     */
+    const Table &active();
+
+    /**
+     * @brief Obtient les noyaux scalaires de référence
+     */
+    const Table &scalar();
+
+    /**
+     * @brief Obtient les noyaux SSE2
+     * @return Table, ou nullptr si le processeur ne les supporte pas
+     */
+    const Table *sse2();
+
+    /**
+     * @brief Obtient les noyaux AVX2
+     * @return Table, ou nullptr si le processeur ne les supporte pas
+     */
+    const Table *avx2();
+
+    /**
+     * @brief Mesure le coût du mixage de 64 voix avec chaque jeu de noyaux disponible
+     * @details Les résultats (temps par bloc, part de l'échéance audio et gain par rapport
+     *          à la version scalaire) sont écrits dans la sortie de débogage.
+     */
+    void runBenchmark();
+}
+
+#endif // MIXKERNELS_H
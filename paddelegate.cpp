@@ -0,0 +1,232 @@
+#include "paddelegate.h"
+#include "padmodel.h"
+#include "soundpad.h"
+#include "waveformcache.h"
+#include <QApplication>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QStyle>
+#include <QStyleOptionButton>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QThread>
+
+PadDelegate::PadDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_thumbnails(ThumbnailCacheSize)
+    , m_pool(nullptr)
+    , m_pressedRemove(false)
+{
+    // Un seul thread de faible priorité: le défilement ne doit pas attendre les images
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(1);
+    m_pool->setThreadPriority(QThread::LowestPriority);
+}
+
+PadDelegate::~PadDelegate()
+{
+    // Les décodages en cours rappellent le délégué: les terminer avant sa destruction
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+void PadDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    SoundPad *pad = index.data(PadModel::PadRole).value<SoundPad*>();
+    if (!pad) {
+        return;
+    }
+
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    const bool pressed = m_pressed.isValid() && m_pressed == index;
+
+    painter->save();
+
+    // Bouton de suppression
+    QStyleOptionButton removeButton;
+    removeButton.rect = removeRect(option.rect);
+    removeButton.palette = option.palette;
+    removeButton.fontMetrics = option.fontMetrics;
+    removeButton.text = tr("×");
+    removeButton.state = QStyle::State_Enabled
+                         | (pressed && m_pressedRemove ? QStyle::State_Sunken : QStyle::State_Raised);
+    style->drawControl(QStyle::CE_PushButton, &removeButton, painter, widget);
+
+    // Bouton du pad
+    QStyleOptionButton button;
+    button.rect = padRect(option.rect);
+    button.palette = option.palette;
+    button.state = QStyle::State_Enabled | (option.state & QStyle::State_MouseOver)
+                   | (pressed && !m_pressedRemove ? QStyle::State_Sunken : QStyle::State_Raised);
+    style->drawControl(QStyle::CE_PushButton, &button, painter, widget);
+
+    // Indication visuelle que le pad est actif
+    if (pad->isPlaying()) {
+        painter->fillRect(button.rect.adjusted(2, 2, -2, -2), QColor(0, 255, 0, 100));
+    }
+
+    // Image, forme d'onde et titre de haut en bas
+    const QRect content = button.rect.adjusted(6, 6, -6, -6);
+    const int titleHeight = option.fontMetrics.height();
+    const QRect titleRect(content.left(), content.bottom() - titleHeight + 1, content.width(), titleHeight);
+    const QRect waveformRect(content.left(), titleRect.top() - Margin - WaveformHeight, content.width(), WaveformHeight);
+    const QRect imageRect(content.topLeft(), QPoint(content.right(), waveformRect.top() - Margin - 1));
+
+    painter->setPen(option.palette.color(QPalette::ButtonText));
+
+    const QPixmap image = thumbnail(pad->getImagePath(), imageRect.size());
+    if (!image.isNull()) {
+        const QSize size = image.size();
+        const QPoint topLeft(imageRect.left() + (imageRect.width() - size.width()) / 2,
+                             imageRect.top() + (imageRect.height() - size.height()) / 2);
+        painter->drawPixmap(topLeft, image);
+    } else if (!m_pendingThumbnails.contains(pad->getImagePath())) {
+        // Image par défaut si aucune n'est spécifiée
+        painter->drawText(imageRect, Qt::AlignCenter, tr("Aucune image"));
+    }
+
+    drawWaveform(painter, waveformRect, pad->getFilePath());
+
+    const QString title = option.fontMetrics.elidedText(index.data(Qt::DisplayRole).toString(),
+                                                        Qt::ElideRight, titleRect.width());
+    painter->drawText(titleRect, Qt::AlignCenter, title);
+
+    painter->restore();
+}
+
+QSize PadDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(option);
+    Q_UNUSED(index);
+
+    // Toutes les cases ont la même taille: la vue n'interroge jamais les pads
+    return QSize(PadSize + 2 * Margin, RemoveSize + PadSize + 3 * Margin);
+}
+
+bool PadDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
+                              const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+    Q_UNUSED(model);
+
+    const QEvent::Type type = event->type();
+    if (type != QEvent::MouseButtonPress && type != QEvent::MouseButtonDblClick
+        && type != QEvent::MouseButtonRelease) {
+        return false;
+    }
+
+    QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
+    if (mouseEvent->button() != Qt::LeftButton) {
+        return false;
+    }
+
+    const QPoint position = mouseEvent->position().toPoint();
+    const bool onRemove = removeRect(option.rect).contains(position);
+    const bool onPad = padRect(option.rect).contains(position);
+
+    // Comme un bouton: le clic compte s'il est relâché là où il a commencé
+    if (type != QEvent::MouseButtonRelease) {
+        m_pressed = (onRemove || onPad) ? QPersistentModelIndex(index) : QPersistentModelIndex();
+        m_pressedRemove = onRemove;
+        return true;
+    }
+
+    const bool clicked = m_pressed.isValid() && m_pressed == index
+                         && (m_pressedRemove ? onRemove : onPad);
+    const bool remove = m_pressedRemove;
+    m_pressed = QPersistentModelIndex();
+    m_pressedRemove = false;
+
+    if (clicked) {
+        SoundPad *pad = index.data(PadModel::PadRole).value<SoundPad*>();
+        if (remove) {
+            emit removeClicked(pad);
+        } else {
+            emit padClicked(pad);
+        }
+    }
+    return true;
+}
+
+QRect PadDelegate::removeRect(const QRect &cell)
+{
+    return QRect(cell.left() + Margin + PadSize - RemoveSize, cell.top() + Margin, RemoveSize, RemoveSize);
+}
+
+QRect PadDelegate::padRect(const QRect &cell)
+{
+    return QRect(cell.left() + Margin, cell.top() + 2 * Margin + RemoveSize, PadSize, PadSize);
+}
+
+QPixmap PadDelegate::thumbnail(const QString &imagePath, const QSize &size) const
+{
+    if (imagePath.isEmpty() || size.isEmpty()) {
+        return QPixmap();
+    }
+
+    if (QPixmap *cached = m_thumbnails.object(imagePath)) {
+        return *cached;
+    }
+
+    if (m_pendingThumbnails.contains(imagePath)) {
+        return QPixmap();
+    }
+    m_pendingThumbnails.insert(imagePath);
+
+    // Le résultat revient sur le thread de la vue, seul autorisé à créer un QPixmap
+    PadDelegate *delegate = const_cast<PadDelegate*>(this);
+    m_pool->start([delegate, imagePath, size]() {
+        const QImage image = loadThumbnail(imagePath, size);
+        QMetaObject::invokeMethod(delegate, [delegate, imagePath, image]() {
+            delegate->thumbnailLoaded(imagePath, image);
+        }, Qt::QueuedConnection);
+    });
+    return QPixmap();
+}
+
+QImage PadDelegate::loadThumbnail(const QString &imagePath, const QSize &size)
+{
+    // Décoder directement à la taille de la case plutôt que l'image entière
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);
+    const QSize imageSize = reader.size();
+    if (imageSize.isValid()) {
+        reader.setScaledSize(imageSize.scaled(size, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (!image.isNull() && !imageSize.isValid()) {
+        image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image;
+}
+
+void PadDelegate::thumbnailLoaded(const QString &imagePath, const QImage &image)
+{
+    m_pendingThumbnails.remove(imagePath);
+
+    // Une image illisible est aussi gardée, pour ne pas la relire à chaque dessin
+    QPixmap *pixmap = new QPixmap(QPixmap::fromImage(image));
+    const int cost = qMax(1, pixmap->width() * pixmap->height() * 4 / 1024);
+    m_thumbnails.insert(imagePath, pixmap, cost);
+
+    emit thumbnailReady(imagePath);
+}
+
+void PadDelegate::drawWaveform(QPainter *painter, const QRect &rect, const QString &filePath) const
+{
+    // Demande les crêtes en arrière-plan si besoin: seuls les pads visibles les attendent
+    std::shared_ptr<const WaveformPeaks> peaks = WaveformCache::instance()->peaks(filePath);
+    if (!peaks || peaks->isEmpty() || rect.width() <= 0) {
+        return;
+    }
+
+    // Une crête par colonne de pixels: le coût ne dépend que de la largeur du pad
+    peaks->peaks(rect.width(), m_columns);
+
+    const float center = rect.top() + (rect.height() - 1) / 2.0f;
+    const float scale = (rect.height() - 1) / 2.0f / 127.0f;
+    for (int x = 0; x < m_columns.size(); ++x) {
+        painter->drawLine(rect.left() + x, qRound(center - m_columns[x].maximum * scale),
+                          rect.left() + x, qRound(center - m_columns[x].minimum * scale));
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef PADDELEGATE_H
+#define PADDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QPersistentModelIndex>
+#include <QCache>
+#include <QSet>
+#include <QPixmap>
+#include <QImage>
+#include <QVector>
+#include "waveformpeaks.h"
+
+class SoundPad;
+class QThreadPool;
+
+/**
+ * @brief Dessin et zones cliquables d'un pad dans la vue du tableau
+ *
+ * Chaque case reprend l'apparence d'un pad : un bouton avec l'image, la forme d'onde
+ * et le titre, surmonté d'un petit bouton de suppression. Rien n'est créé par pad :
+ * seules les cases visibles sont peintes, et leurs clics sont reconnus par position.
+ *
+ * Les miniatures des images sont décodées directement à la taille de la case, sur un
+ * thread de faible priorité, puis gardées dans un cache de taille bornée : une case
+ * dont l'image n'est pas encore prête est dessinée sans, puis redessinée dès que
+ * thumbnailReady() est émis. Les formes d'onde sont lues dans le WaveformCache à
+ * chaque dessin.
+ */
+class PadDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    static const int PadSize = 150;         ///< Côté du bouton d'un pad (px)
+    static const int RemoveSize = 20;       ///< Côté du bouton de suppression (px)
+    static const int Margin = 2;            ///< Marge autour des éléments d'une case (px)
+    static const int WaveformHeight = 20;   ///< Hauteur de la forme d'onde (px)
+    static const int ThumbnailCacheSize = 32 * 1024; ///< Taille du cache des miniatures (Kio)
+
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit PadDelegate(QObject *parent = nullptr);
+
+    ~PadDelegate();
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+protected:
+    bool editorEvent(QEvent *event, QAbstractItemModel *model,
+                     const QStyleOptionViewItem &option, const QModelIndex &index) override;
+
+signals:
+    /**
+     * @brief Signal émis lorsqu'un pad est cliqué
+     * @param pad SoundPad cliqué
+     */
+    void padClicked(SoundPad *pad);
+
+    /**
+     * @brief Signal émis lorsque le bouton de suppression d'un pad est cliqué
+     * @param pad SoundPad à supprimer
+     */
+    void removeClicked(SoundPad *pad);
+
+    /**
+     * @brief Signal émis lorsque la miniature d'une image vient d'être décodée
+     * @param imagePath Chemin de l'image
+     */
+    void thumbnailReady(const QString &imagePath);
+
+private:
+    mutable QCache<QString, QPixmap> m_thumbnails;       // Miniatures par chemin d'image
+    mutable QSet<QString> m_pendingThumbnails;           // Images en cours de décodage
+    QThreadPool *m_pool;                                 // Thread de décodage des miniatures
+    mutable QVector<WaveformPeaks::Peak> m_columns;      // Crêtes de la forme d'onde en cours de dessin
+    QPersistentModelIndex m_pressed;                     // Case sous le bouton de la souris
+    bool m_pressedRemove;                                // Appui sur le bouton de suppression
+
+    /**
+     * @brief Obtient la zone du bouton de suppression d'une case
+     */
+    static QRect removeRect(const QRect &cell);
+
+    /**
+     * @brief Obtient la zone du bouton du pad d'une case
+     */
+    static QRect padRect(const QRect &cell);
+
+    /**
+     * @brief Obtient la miniature d'une image, et la décode en arrière-plan si besoin
+     * @param imagePath Chemin de l'image
+     * @param size Taille disponible
+     * @return Miniature, nulle si l'image est absente, illisible ou pas encore décodée
+     */
+    QPixmap thumbnail(const QString &imagePath, const QSize &size) const;
+
+    /**
+     * @brief Décode une image directement à la taille demandée (thread de décodage)
+     * @param imagePath Chemin de l'image
+     * @param size Taille disponible
+     * @return Image réduite, nulle si l'image est illisible
+     */
+    static QImage loadThumbnail(const QString &imagePath, const QSize &size);
+
+    /**
+     * @brief Met en cache une miniature décodée et demande le dessin des cases concernées
+     * @param imagePath Chemin de l'image
+     * @param image Image réduite
+     */
+    void thumbnailLoaded(const QString &imagePath, const QImage &image);
+
+    /**
+     * @brief Dessine la forme d'onde d'un son à partir de ses crêtes en cache
+     * @param painter Peintre de la vue
+     * @param rect Zone de la forme d'onde
+     * @param filePath Fichier audio du pad
+     */
+    void drawWaveform(QPainter *painter, const QRect &rect, const QString &filePath) const;
+};
+
+#endif // PADDELEGATE_H
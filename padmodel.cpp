@@ -0,0 +1,144 @@
+#include "padmodel.h"
+#include "soundpad.h"
+#include "waveformcache.h"
+#include <QMimeData>
+#include <QUrl>
+
+PadModel::PadModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    // Une seule connexion pour tout le tableau, quel que soit le nombre de pads
+    connect(WaveformCache::instance(), &WaveformCache::ready, this, &PadModel::waveformReady);
+}
+
+int PadModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_pads.size());
+}
+
+QVariant PadModel::data(const QModelIndex &index, int role) const
+{
+    SoundPad *pad = padAt(index);
+    if (!pad) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return pad->getTitle().isEmpty() ? tr("Sans titre") : pad->getTitle();
+    case Qt::ToolTipRole:
+        return pad->toolTip();
+    case PadRole:
+        return QVariant::fromValue(pad);
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags PadModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsDropEnabled | Qt::ItemNeverHasChildren;
+}
+
+QStringList PadModel::mimeTypes() const
+{
+    return {QStringLiteral("text/uri-list")};
+}
+
+Qt::DropActions PadModel::supportedDropActions() const
+{
+    return Qt::CopyAction | Qt::MoveAction | Qt::LinkAction;
+}
+
+bool PadModel::canDropMimeData(const QMimeData *data, Qt::DropAction action,
+                               int row, int column, const QModelIndex &parent) const
+{
+    Q_UNUSED(action);
+    Q_UNUSED(row);
+    Q_UNUSED(column);
+    Q_UNUSED(parent);
+
+    // Accepté aussi entre deux pads, sans quoi la vue refuserait un glissement entré par un espace
+    return data->hasUrls();
+}
+
+bool PadModel::dropMimeData(const QMimeData *data, Qt::DropAction action,
+                            int row, int column, const QModelIndex &parent)
+{
+    Q_UNUSED(action);
+    Q_UNUSED(row);
+    Q_UNUSED(column);
+
+    // Un fichier n'est importé que s'il est déposé sur un pad
+    if (!data->hasUrls() || !padAt(parent)) {
+        return false;
+    }
+
+    // On ne traite que le premier fichier déposé
+    const QList<QUrl> urls = data->urls();
+    padAt(parent)->importFile(urls.first().toLocalFile());
+    return true;
+}
+
+void PadModel::appendPad(SoundPad *pad)
+{
+    const int row = int(m_pads.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_pads.append(pad);
+    endInsertRows();
+
+    connect(pad, &SoundPad::appearanceChanged, this, &PadModel::padChanged);
+}
+
+void PadModel::removePad(SoundPad *pad)
+{
+    const int row = int(m_pads.indexOf(pad));
+    if (row < 0) {
+        return;
+    }
+
+    disconnect(pad, nullptr, this, nullptr);
+    beginRemoveRows(QModelIndex(), row, row);
+    m_pads.remove(row);
+    endRemoveRows();
+}
+
+SoundPad *PadModel::padAt(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.model() != this || index.row() >= m_pads.size()) {
+        return nullptr;
+    }
+    return m_pads[index.row()];
+}
+
+void PadModel::imageReady(const QString &imagePath)
+{
+    for (int row = 0; row < m_pads.size(); ++row) {
+        if (m_pads[row]->getImagePath() == imagePath) {
+            const QModelIndex changed = index(row);
+            emit dataChanged(changed, changed);
+        }
+    }
+}
+
+void PadModel::padChanged(SoundPad *pad)
+{
+    const int row = int(m_pads.indexOf(pad));
+    if (row >= 0) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed);
+    }
+}
+
+void PadModel::waveformReady(const QString &filePath)
+{
+    for (int row = 0; row < m_pads.size(); ++row) {
+        if (m_pads[row]->getFilePath() == filePath) {
+            const QModelIndex changed = index(row);
+            emit dataChanged(changed, changed);
+        }
+    }
+}
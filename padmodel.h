@@ -0,0 +1,89 @@
+#ifndef PADMODEL_H
+#define PADMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+
+class SoundPad;
+
+/**
+ * @brief Modèle des pads d'un tableau, affichés par une vue unique
+ *
+ * Les pads ne se dessinent pas eux-mêmes : la vue du tableau ne demande que les lignes
+ * visibles et le PadDelegate les peint. Un tableau de plusieurs milliers de pads ne
+ * coûte donc que ce qui tient à l'écran.
+ *
+ * Le modèle se tient à jour des changements d'apparence des pads (appearanceChanged())
+ * et des formes d'onde ou miniatures prêtes, et transmet au pad visé les fichiers déposés sur la vue.
+ */
+class PadModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Rôles propres au modèle
+     */
+    enum Role {
+        PadRole = Qt::UserRole + 1   ///< SoundPad* de la ligne
+    };
+
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit PadModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    QStringList mimeTypes() const override;
+    Qt::DropActions supportedDropActions() const override;
+    bool canDropMimeData(const QMimeData *data, Qt::DropAction action,
+                         int row, int column, const QModelIndex &parent) const override;
+    bool dropMimeData(const QMimeData *data, Qt::DropAction action,
+                      int row, int column, const QModelIndex &parent) override;
+
+    /**
+     * @brief Ajoute un pad à la fin du modèle
+     * @param pad SoundPad ajouté au tableau
+     */
+    void appendPad(SoundPad *pad);
+
+    /**
+     * @brief Retire un pad du modèle
+     * @param pad SoundPad retiré du tableau
+     */
+    void removePad(SoundPad *pad);
+
+    /**
+     * @brief Obtient le pad d'une ligne
+     * @param index Ligne du modèle
+     * @return SoundPad, ou nullptr si la ligne n'existe pas
+     */
+    SoundPad *padAt(const QModelIndex &index) const;
+
+    /**
+     * @brief Redessine les pads dont la miniature d'image vient d'être décodée
+     * @param imagePath Image dont la miniature est prête
+     */
+    void imageReady(const QString &imagePath);
+
+private:
+    QVector<SoundPad*> m_pads;    // Pads dans l'ordre du tableau
+
+    /**
+     * @brief Signale à la vue que l'apparence d'un pad a changé
+     * @param pad SoundPad à redessiner
+     */
+    void padChanged(SoundPad *pad);
+
+    /**
+     * @brief Redessine les pads dont la forme d'onde vient d'être calculée
+     * @param filePath Fichier dont les crêtes sont prêtes
+     */
+    void waveformReady(const QString &filePath);
+};
+
+#endif // PADMODEL_H
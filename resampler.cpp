@@ -0,0 +1,265 @@
+#include "resampler.h"
+#include <QtMath>
+#include <numeric>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double KaiserBeta = 8.6;          // Atténuation d'environ 90 dB hors de la bande passante
+const double Rolloff = 0.92;            // Coupure, en fraction de la fréquence de Nyquist
+const qint64 BlockFrames = 16384;       // Trames de sortie converties par bloc
+
+// Fonction de Bessel modifiée de première espèce d'ordre 0 (série entière)
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = x / 2.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+inline qint16 toInt16(float value)
+{
+    return qint16(qBound(-32768L, lroundf(value * 32768.0f), 32767L));
+}
+
+} // namespace
+
+Resampler::Resampler(int inputRate, int outputRate)
+    : m_outputRate(outputRate)
+    , m_upFactor(1)
+    , m_downFactor(1)
+    , m_phases(1)
+    , m_taps(1)
+    , m_kernels(MixKernels::active())
+{
+    if (inputRate <= 0 || outputRate <= 0 || inputRate == outputRate) {
+        return;
+    }
+
+    const qint64 divisor = std::gcd(qint64(inputRate), qint64(outputRate));
+    m_upFactor = outputRate / divisor;
+    m_downFactor = inputRate / divisor;
+    m_phases = int(qMin<qint64>(m_upFactor, MaxPhases));
+
+    // En réduction, le filtre s'élargit pour garder la même bande de transition
+    const double ratio = qMin(1.0, double(m_upFactor) / double(m_downFactor));
+    m_taps = int(std::ceil(BaseTaps / ratio / 8.0)) * 8;
+
+    designFilter(Rolloff * ratio);
+}
+
+void Resampler::designFilter(double cutoff)
+{
+    const int half = m_taps / 2;
+    m_coefficients.resize(qsizetype(m_phases) * m_taps);
+
+    for (int phase = 0; phase < m_phases; ++phase) {
+        const double fraction = double(phase) / m_phases;
+        float *coefficients = m_coefficients.data() + qsizetype(phase) * m_taps;
+        double sum = 0.0;
+
+        for (int k = 0; k < m_taps; ++k) {
+            // Distance (en trames source) entre la trame k de la fenêtre et la position de sortie
+            const double t = k - half + 1 - fraction;
+            const double x = M_PI * cutoff * t;
+            const double sinc = qFuzzyIsNull(x) ? 1.0 : std::sin(x) / x;
+            const double position = t / half;
+            const double window = std::fabs(position) >= 1.0
+                                      ? 0.0
+                                      : besselI0(KaiserBeta * std::sqrt(1.0 - position * position)) / besselI0(KaiserBeta);
+            const double value = cutoff * sinc * window;
+            coefficients[k] = float(value);
+            sum += value;
+        }
+
+        // Gain unitaire en continu pour chaque phase
+        for (int k = 0; k < m_taps; ++k) {
+            coefficients[k] = float(coefficients[k] / sum);
+        }
+    }
+}
+
+std::shared_ptr<AudioSample> Resampler::process(const AudioSample &source) const
+{
+    auto result = std::make_shared<AudioSample>();
+    result->channels = source.channels;
+    result->sampleRate = m_outputRate;
+
+    const int channels = source.channels;
+    const qint64 frames = source.frameCount();
+    if (frames == 0) {
+        return result;
+    }
+
+    auto inputValue = [&source](qint64 index) {
+        return source.isInt16() ? float(source.pcm16[index]) / 32768.0f : source.data[index];
+    };
+
+    // Même fréquence: seule la conversion en 16 bits reste à faire
+    if (isIdentity()) {
+        if (source.isInt16()) {
+            result->pcm16 = source.pcm16;
+        } else {
+            result->pcm16.resize(source.data.size());
+            for (qsizetype i = 0; i < source.data.size(); ++i) {
+                result->pcm16[i] = toInt16(source.data[i]);
+            }
+        }
+        return result;
+    }
+
+    const qint64 outputFrames = (frames * m_upFactor + m_downFactor - 1) / m_downFactor;
+    result->pcm16.resize(outputFrames * channels);
+
+    // La fenêtre de la trame de sortie n commence à la trame source ip - half + 1, avec
+    // ip = n * M / L ; padding est ce décalage, compté dans la mémoire de travail
+    const qint64 padding = m_taps / 2 - 1;
+    QVector<float> window;
+
+    for (qint64 blockStart = 0; blockStart < outputFrames; blockStart += BlockFrames) {
+        const qint64 blockEnd = qMin(outputFrames, blockStart + BlockFrames);
+        const qint64 firstInput = blockStart * m_downFactor / m_upFactor;
+        const qint64 lastInput = (blockEnd - 1) * m_downFactor / m_upFactor + m_taps;
+        window.resize(lastInput - firstInput);
+
+        for (int channel = 0; channel < channels; ++channel) {
+            // Copier le canal dans une mémoire contiguë, complétée de silence aux extrémités
+            for (qint64 i = 0; i < window.size(); ++i) {
+                const qint64 frame = firstInput + i - padding;
+                window[i] = frame >= 0 && frame < frames ? inputValue(frame * channels + channel) : 0.0f;
+            }
+
+            for (qint64 frame = blockStart; frame < blockEnd; ++frame) {
+                const qint64 position = frame * m_downFactor;
+                const qint64 inputFrame = position / m_upFactor;
+                const qint64 phase = (position % m_upFactor) * m_phases / m_upFactor;
+                const float value = m_kernels.dot(m_coefficients.constData() + phase * m_taps,
+                                                  window.constData() + (inputFrame - firstInput), m_taps);
+                result->pcm16[frame * channels + channel] = toInt16(value);
+            }
+        }
+    }
+
+    return result;
+}
+
+Resampler::Stream::Stream(const Resampler &resampler, int channels)
+    : m_resampler(resampler)
+    , m_channels(qBound(1, channels, 2))
+    , m_historyStart(0)
+    , m_inputFrames(0)
+    , m_outputFrames(0)
+{
+    // Même silence initial que process(): la première fenêtre commence avant le son
+    if (!resampler.isIdentity()) {
+        for (int channel = 0; channel < m_channels; ++channel) {
+            m_history[channel].fill(0.0f, resampler.m_taps / 2 - 1);
+        }
+    }
+}
+
+void Resampler::Stream::push(const AudioSample &chunk, QVector<qint16> &output)
+{
+    const qint64 frames = chunk.frameCount();
+    const int chunkChannels = chunk.channels;
+    if (frames == 0) {
+        return;
+    }
+
+    // Même fréquence: seule la conversion en 16 bits reste à faire
+    if (m_resampler.isIdentity()) {
+        const qsizetype start = output.size();
+        output.resize(start + frames * m_channels);
+        for (qint64 frame = 0; frame < frames; ++frame) {
+            for (int channel = 0; channel < m_channels; ++channel) {
+                const qint64 index = frame * chunkChannels + qMin(channel, chunkChannels - 1);
+                output[start + frame * m_channels + channel] = chunk.isInt16() ? chunk.pcm16[index]
+                                                                               : toInt16(chunk.data[index]);
+            }
+        }
+        m_inputFrames += frames;
+        m_outputFrames += frames;
+        return;
+    }
+
+    for (int channel = 0; channel < m_channels; ++channel) {
+        QVector<float> &history = m_history[channel];
+        const qsizetype start = history.size();
+        history.resize(start + frames);
+        for (qint64 frame = 0; frame < frames; ++frame) {
+            const qint64 index = frame * chunkChannels + qMin(channel, chunkChannels - 1);
+            history[start + frame] = chunk.isInt16() ? float(chunk.pcm16[index]) / 32768.0f : chunk.data[index];
+        }
+    }
+    m_inputFrames += frames;
+
+    produce(std::numeric_limits<qint64>::max(), output);
+}
+
+void Resampler::Stream::finish(QVector<qint16> &output)
+{
+    if (m_resampler.isIdentity()) {
+        return;
+    }
+
+    // Compléter de silence, comme process() au-delà de la fin du son
+    for (int channel = 0; channel < m_channels; ++channel) {
+        m_history[channel].resize(m_history[channel].size() + m_resampler.m_taps, 0.0f);
+    }
+
+    const qint64 total = (m_inputFrames * m_resampler.m_upFactor + m_resampler.m_downFactor - 1)
+                         / m_resampler.m_downFactor;
+    produce(total, output);
+}
+
+void Resampler::Stream::produce(qint64 limit, QVector<qint16> &output)
+{
+    const qint64 up = m_resampler.m_upFactor;
+    const qint64 down = m_resampler.m_downFactor;
+    const int taps = m_resampler.m_taps;
+    const qint64 historyEnd = m_historyStart + m_history[0].size();
+
+    // Trames de sortie dont la fenêtre [n * M / L, n * M / L + taps) est entièrement reçue
+    qint64 end = m_outputFrames;
+    while (end < limit && (end * down) / up + taps <= historyEnd) {
+        end++;
+    }
+    if (end == m_outputFrames) {
+        return;
+    }
+
+    const qsizetype start = output.size();
+    output.resize(start + (end - m_outputFrames) * m_channels);
+
+    for (int channel = 0; channel < m_channels; ++channel) {
+        const float *history = m_history[channel].constData();
+        for (qint64 frame = m_outputFrames; frame < end; ++frame) {
+            const qint64 position = frame * down;
+            const qint64 inputFrame = position / up;
+            const qint64 phase = (position % up) * m_resampler.m_phases / up;
+            const float value = m_resampler.m_kernels.dot(m_resampler.m_coefficients.constData() + phase * taps,
+                                                          history + (inputFrame - m_historyStart), taps);
+            output[start + (frame - m_outputFrames) * m_channels + channel] = toInt16(value);
+        }
+    }
+    m_outputFrames = end;
+
+    // Oublier les trames source dont plus aucune fenêtre n'a besoin
+    const qint64 keepFrom = (m_outputFrames * down) / up;
+    const qint64 drop = qMin<qint64>(keepFrom - m_historyStart, m_history[0].size());
+    if (drop > 0) {
+        for (int channel = 0; channel < m_channels; ++channel) {
+            m_history[channel].remove(0, drop);
+        }
+        m_historyStart += drop;
+    }
+}
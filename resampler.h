@@ -0,0 +1,114 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+#include <memory>
+#include "audiosample.h"
+#include "mixkernels.h"
+
+/**
+ * @brief Convertisseur de fréquence d'échantillonnage polyphase
+ *
+ * Le rapport de conversion est réduit à une fraction L/M (par exemple 160/147 pour
+ * passer de 44,1 kHz à 48 kHz). Un filtre passe-bas en sinus cardinal fenêtré par
+ * Kaiser est calculé une fois, découpé en phases, et chaque trame de sortie se réduit
+ * au produit scalaire d'une phase par une fenêtre de la source (noyau dot de
+ * MixKernels). En réduction de fréquence, la coupure et la longueur du filtre suivent
+ * le rapport afin d'éviter le repliement.
+ *
+ * Au-delà de MaxPhases phases (rapports inhabituels), la position fractionnaire est
+ * arrondie à la phase la plus proche.
+ *
+ * La conversion est faite une seule fois par son, sur un thread de décodage ; un
+ * Resampler n'est pas modifié après sa construction. Les sons lus en continu sont
+ * convertis par morceaux avec un Resampler::Stream, qui produit exactement les mêmes
+ * trames que process() sur le son entier.
+ */
+class Resampler
+{
+public:
+    static const int BaseTaps = 64;         ///< Coefficients par phase sans réduction de fréquence
+    static const int MaxPhases = 1024;      ///< Nombre maximal de phases du filtre
+
+    /**
+     * @brief Constructeur: calcule le banc de filtres
+     * @param inputRate Fréquence de la source (Hz)
+     * @param outputRate Fréquence souhaitée (Hz)
+     */
+    Resampler(int inputRate, int outputRate);
+
+    /**
+     * @brief Indique si les deux fréquences sont identiques
+     */
+    bool isIdentity() const { return m_upFactor == m_downFactor; }
+
+    /**
+     * @brief Convertit un son entier à la fréquence de sortie
+     * @details Le résultat est toujours stocké en entiers 16 bits, le format des sons en cache.
+     *          Le nombre de canaux de la source est conservé.
+     * @param source Son décodé à la fréquence d'entrée
+     * @return Son converti
+     */
+    std::shared_ptr<AudioSample> process(const AudioSample &source) const;
+
+    /**
+     * @brief Conversion par morceaux d'un son décodé au fil de l'eau
+     *
+     * Garde les dernières trames source nécessaires au filtre entre deux appels à push().
+     */
+    class Stream
+    {
+    public:
+        /**
+         * @brief Constructeur
+         * @param resampler Banc de filtres, qui doit survivre au flux
+         * @param channels Nombre de canaux (1 ou 2)
+         */
+        Stream(const Resampler &resampler, int channels);
+
+        /**
+         * @brief Convertit un morceau et ajoute les trames de sortie déjà calculables
+         * @param chunk Trames source suivantes, au nombre de canaux du flux
+         * @param output Échantillons 16 bits entrelacés, complétés par la conversion
+         */
+        void push(const AudioSample &chunk, QVector<qint16> &output);
+
+        /**
+         * @brief Termine le flux et ajoute les dernières trames de sortie
+         * @param output Échantillons 16 bits entrelacés, complétés par la conversion
+         */
+        void finish(QVector<qint16> &output);
+
+    private:
+        const Resampler &m_resampler;   // Banc de filtres
+        int m_channels;                 // Nombre de canaux
+        QVector<float> m_history[2];    // Trames source en attente, par canal
+        qint64 m_historyStart;          // Position de la première trame en attente (silence initial compris)
+        qint64 m_inputFrames;           // Trames source reçues
+        qint64 m_outputFrames;          // Trames de sortie produites
+
+        /**
+         * @brief Calcule les trames de sortie dont la fenêtre est complète
+         * @param limit Nombre total de trames de sortie à ne pas dépasser
+         * @param output Échantillons de sortie
+         */
+        void produce(qint64 limit, QVector<qint16> &output);
+    };
+
+private:
+    int m_outputRate;                   // Fréquence de sortie
+    qint64 m_upFactor;                  // Facteur d'interpolation L
+    qint64 m_downFactor;                // Facteur de décimation M
+    int m_phases;                       // Nombre de phases du filtre
+    int m_taps;                         // Coefficients par phase
+    QVector<float> m_coefficients;      // Coefficients, phase par phase
+    const MixKernels::Table &m_kernels; // Noyaux vectoriels du processeur
+
+    /**
+     * @brief Calcule les coefficients de toutes les phases
+     * @param cutoff Fréquence de coupure relative à la fréquence de Nyquist de la source
+     */
+    void designFilter(double cutoff);
+};
+
+#endif // RESAMPLER_H
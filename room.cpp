@@ -1,11 +1,16 @@
 #include "room.h"
+#include "roomprotocol.h"
+#include "roomtransport.h"
+#include "assetstore.h"
+#include "audioengine.h"
+#include "latencymonitor.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QNetworkInterface>
 #include <QDateTime>
+#include <QFileInfo>
 #include <QThread>
-#include <QTimer>
 #include <QRandomGenerator>
 #include <QStringList>
 #include <QDebug>
@@ -15,10 +20,14 @@ Room::Room(const QString &name, bool isHost, QObject *parent)
     , m_name(name)
     , m_invitationCode("")
     , m_hostUsername("")
-    , m_server(nullptr)
-    , m_clientSocket(nullptr)
+    , m_transport(nullptr)
+    , m_ioThread(nullptr)
+    , m_hostPeer(0)
+    , m_serverRunning(false)
     , m_isHost(isHost)
     , m_port(0)
+    , m_boardRevision(1)
+    , m_snapshotRevision(0)
 {
     qDebug() << "Création d'une nouvelle Room:" << name << "(Hôte:" << (isHost ? "Oui" : "Non") << ")";
     
@@ -35,6 +44,33 @@ Room::Room(const QString &name, bool isHost, QObject *parent)
     // Définir un identifiant fixe pour le board (toujours "1")
     m_board->setObjectName("1");
     qDebug() << "ID fixe attribué au board principal: 1";
+    
+    // Toute modification du board rend l'instantané encodé obsolète
+    connect(m_board, &Board::soundPadAdded, this, &Room::invalidateBoardSnapshot);
+    connect(m_board, &Board::soundPadRemoved, this, &Room::invalidateBoardSnapshot);
+    connect(m_board, &Board::soundPadModified, this, &Room::invalidateBoardSnapshot);
+    connect(m_board, &Board::titleChanged, this, &Room::invalidateBoardSnapshot);
+    
+    // Un pad déclenché est joué au même instant chez tous les participants
+    m_board->setSharedPlayback(true);
+    connect(m_board, &Board::soundPadPlayRequested, this, &Room::notifySoundPadPlayed);
+    
+    // La couche réseau vit sur son propre thread pour ne pas dépendre du travail des widgets
+    m_ioThread = new QThread(this);
+    m_ioThread->setObjectName(QString("RoomIO-%1").arg(name));
+    m_transport = new RoomTransport();
+    m_transport->moveToThread(m_ioThread);
+    
+    // Les messages décodés arrivent sur le thread de l'interface via des connexions en file d'attente
+    connect(m_transport, &RoomTransport::peerConnected, this, &Room::handlePeerConnected, Qt::QueuedConnection);
+    connect(m_transport, &RoomTransport::peerDisconnected, this, &Room::handlePeerDisconnected, Qt::QueuedConnection);
+    connect(m_transport, &RoomTransport::messageReceived, this, &Room::processMessage, Qt::QueuedConnection);
+    connect(m_transport, &RoomTransport::assetTransferFinished, this, &Room::handleAssetTransferFinished, Qt::QueuedConnection);
+    connect(m_transport, &RoomTransport::clockSampled, this, &Room::handleClockSample, Qt::QueuedConnection);
+    connect(AssetStore::instance(), &AssetStore::fileImported, this, &Room::handleFileImported, Qt::QueuedConnection);
+    
+    m_ioThread->start();
+    updateClockInfo();
 }
 
 Room::~Room()
@@ -46,6 +82,14 @@ Room::~Room()
         disconnect();
     }
     
+    // Fermer les connexions restantes puis arrêter le thread réseau
+    QMetaObject::invokeMethod(m_transport, [this]() {
+        m_transport->shutdown();
+    }, Qt::BlockingQueuedConnection);
+    m_ioThread->quit();
+    m_ioThread->wait();
+    delete m_transport;
+    
     // Suppression du board
     delete m_board;
 }
@@ -117,44 +161,22 @@ bool Room::startServer()
         return false;
     }
     
-    // Fermer le serveur existant si nécessaire
-    if (m_server) {
-        qDebug() << "Serveur existant détecté, fermeture avant redémarrage";
-        m_server->close();
-        m_server->deleteLater();
-        m_server = nullptr;
-    }
-    
-    // Créer le serveur
+    // Démarrer l'écoute sur le thread réseau et attendre le résultat
     qDebug() << "Création d'un nouveau serveur";
-    m_server = new QTcpServer(this);
-    
-    // Connecter le signal de nouvelle connexion
-    connect(m_server, &QTcpServer::newConnection, this, &Room::handleNewConnection);
-    
-    // Tenter le démarrage sur différentes adresses si nécessaire
-    bool serverStartSuccess = false;
-    
-    // D'abord essayer Any (toutes les interfaces)
-    qDebug() << "Tentative de démarrage sur QHostAddress::Any";
-    serverStartSuccess = m_server->listen(QHostAddress::Any, m_port);
-    
-    // Si ça ne fonctionne pas, essayer sur localhost
-    if (!serverStartSuccess) {
-        qDebug() << "Échec sur Any, tentative sur localhost";
-        serverStartSuccess = m_server->listen(QHostAddress::LocalHost, m_port);
-    }
+    int listeningPort = -1;
+    const int requestedPort = m_port;
+    QMetaObject::invokeMethod(m_transport, [this, requestedPort, &listeningPort]() {
+        listeningPort = m_transport->startServer(requestedPort);
+    }, Qt::BlockingQueuedConnection);
     
     // Vérifier si le serveur a démarré
-    if (!serverStartSuccess) {
-        qDebug() << "ERREUR critique lors du démarrage du serveur:" << m_server->errorString();
-        m_server->deleteLater();
-        m_server = nullptr;
+    if (listeningPort < 0) {
         return false;
     }
+    m_serverRunning = true;
     
     // Récupérer le port sur lequel le serveur écoute (au cas où le port demandé n'était pas disponible)
-    m_port = m_server->serverPort();
+    m_port = listeningPort;
     qDebug() << "Serveur démarré avec succès sur le port" << m_port;
     
     // Obtenir l'adresse IP locale pour générer le code d'invitation
@@ -193,122 +215,72 @@ bool Room::connectToRoom(const QString &address, int port, const QString &userna
         return false;
     }
     
-    // Créer un nouveau socket client si nécessaire
-    if (!m_clientSocket) {
-        m_clientSocket = new QTcpSocket(this);
-        
-        QObject::connect(m_clientSocket, &QTcpSocket::readyRead,
-                         this, &Room::handleDataReceived);
-        QObject::connect(m_clientSocket, &QTcpSocket::disconnected,
-                         this, &Room::handleClientDisconnected);
-        QObject::connect(m_clientSocket, &QTcpSocket::errorOccurred,
-                         this, [this](QAbstractSocket::SocketError socketError) {
-            qDebug() << "Erreur de socket:" << m_clientSocket->errorString() 
-                     << "Code d'erreur:" << socketError;
-        });
-    }
-    
-    // Se connecter au serveur si le socket n'est pas déjà connecté
-    if (m_clientSocket->state() == QTcpSocket::UnconnectedState) {
-        qDebug() << "Tentative de connexion à" << address << ":" << port;
-        
-        m_clientSocket->connectToHost(address, port);
-        
-        if (m_clientSocket->waitForConnected(3000)) {
-            qDebug() << "Connexion établie avec succès, envoi des informations utilisateur";
-            
-            // Envoyer les informations utilisateur
-            QJsonObject data;
-            data["username"] = username;
-            sendMessage(m_clientSocket, "join", data);
-            
-            return true;
-        } else {
-            qDebug() << "Échec de la connexion:" << m_clientSocket->errorString();
-        }
-    } else {
-        qDebug() << "Socket déjà dans l'état:" << m_clientSocket->state();
+    // Se connecter au serveur si nous ne sommes pas déjà connectés
+    if (m_hostPeer != 0) {
+        qDebug() << "Déjà connecté à l'hôte";
+        return false;
     }
     
-    return false;
+    // La connexion est établie sur le thread réseau, l'appel reste bloquant comme auparavant
+    quint64 hostPeer = 0;
+    QMetaObject::invokeMethod(m_transport, [this, address, port, &hostPeer]() {
+        hostPeer = m_transport->connectToHost(address, port);
+    }, Qt::BlockingQueuedConnection);
+    
+    if (hostPeer == 0) {
+        return false;
+    }
+    
+    m_hostPeer = hostPeer;
+    qDebug() << "Connexion établie avec succès, envoi des informations utilisateur";
+    
+    // Envoyer les informations utilisateur et les codecs supportés
+    QJsonObject data;
+    data["username"] = username;
+    data["protocol_version"] = RoomProtocol::ProtocolVersion;
+    data["codecs"] = QJsonArray::fromStringList(RoomProtocol::supportedCodecs());
+    sendMessage(m_hostPeer, "join", data);
+    
+    return true;
 }
 
 void Room::disconnect()
 {
-    if (m_clientSocket) {
-        if (m_clientSocket->state() == QTcpSocket::ConnectedState) {
-            // Informer le serveur de la déconnexion
-            QJsonObject data;
-            data["reason"] = "user_disconnect";
-            sendMessage(m_clientSocket, "disconnect", data);
-            
-            m_clientSocket->disconnectFromHost();
-        }
+    if (m_hostPeer != 0) {
+        // Informer le serveur de la déconnexion
+        QJsonObject data;
+        data["reason"] = "user_disconnect";
+        sendMessage(m_hostPeer, "disconnect", data);
+        
+        const quint64 hostPeer = m_hostPeer;
+        QMetaObject::invokeMethod(m_transport, [this, hostPeer]() {
+            m_transport->disconnectPeer(hostPeer);
+        }, Qt::QueuedConnection);
     }
 }
 
-void Room::handleNewConnection()
+void Room::handlePeerConnected(quint64 peerId)
 {
-    while (m_server && m_server->hasPendingConnections()) {
-        QTcpSocket *socket = m_server->nextPendingConnection();
-        
-        if (socket) {
-            QObject::connect(socket, &QTcpSocket::readyRead, this, &Room::handleDataReceived);
-            QObject::connect(socket, &QTcpSocket::disconnected, this, &Room::handleClientDisconnected);
-            
-            // L'utilisateur sera correctement identifié quand il enverra ses infos
-            m_users[socket] = ConnectedUser();
-        }
-    }
+    // L'utilisateur sera correctement identifié quand il enverra ses infos
+    m_users[peerId] = ConnectedUser(QString(), peerId);
 }
 
-void Room::handleDataReceived()
+void Room::handlePeerDisconnected(quint64 peerId)
 {
-    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket) {
-        qDebug() << "ERREUR: handleDataReceived appelé sans socket valide";
-        return;
-    }
-    
-    QByteArray data = socket->readAll();
-    qDebug() << "Données reçues de" << (m_users.contains(socket) ? m_users[socket].username : "inconnu") 
-             << "taille:" << data.size() << "octets";
+    // Côté client, la perte de la connexion avec l'hôte
+    m_clocks.remove(peerId);
     
-    if (data.isEmpty()) {
-        qDebug() << "AVERTISSEMENT: Données reçues vides";
+    if (peerId == m_hostPeer) {
+        qDebug() << "Connexion avec l'hôte fermée";
+        m_hostPeer = 0;
         return;
     }
     
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
-    
-    if (parseError.error != QJsonParseError::NoError) {
-        qDebug() << "ERREUR: Impossible de parser les données JSON:" << parseError.errorString();
-        qDebug() << "Contenu reçu:" << data;
-        return;
-    }
-    
-    if (!doc.isObject()) {
-        qDebug() << "ERREUR: Document JSON reçu n'est pas un objet";
-        return;
-    }
-    
-    QJsonObject message = doc.object();
-    QString messageType = message["type"].toString();
-    QJsonObject messageData = message["data"].toObject();
-    
-    qDebug() << "Message de type" << messageType << "reçu et prêt à être traité";
-    processMessage(socket, messageType, messageData);
-}
-
-void Room::handleClientDisconnected()
-{
-    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket)
-        return;
-    
-    if (m_users.contains(socket)) {
-        QString username = m_users[socket].username;
+    if (m_users.contains(peerId)) {
+        QString username = m_users[peerId].username;
+        
+        // Retirer l'utilisateur avant de prévenir les autres pour ne pas lui écrire
+        m_users.remove(peerId);
         
         if (!username.isEmpty()) {
             emit userDisconnected(username);
@@ -320,67 +292,51 @@ void Room::handleClientDisconnected()
                 broadcastMessage("user_disconnect", data);
             }
         }
-        
-        m_users.remove(socket);
     }
-    
-    socket->deleteLater();
 }
 
-void Room::broadcastMessage(const QString &type, const QJsonObject &data, QTcpSocket *excludeSocket)
+void Room::broadcastMessage(const QString &type, const QJsonObject &data, quint64 excludePeer)
 {
     if (!m_isHost) {
         qDebug() << "ERREUR: Tentative de diffusion depuis un client";
         return;
     }
     
-    QJsonObject message;
-    message["type"] = type;
-    message["data"] = data;
-    
-    QJsonDocument doc(message);
-    QByteArray byteArray = doc.toJson(QJsonDocument::Compact);
-    
-    qDebug() << "Broadcasting message type:" << type << "to" << m_users.size() << "clients" 
-             << "taille:" << byteArray.size() << "octets";
-    
-    for (auto it = m_users.begin(); it != m_users.end(); ++it) {
-        // Ignorer le socket exclu (généralement l'expéditeur)
-        if (excludeSocket && it.key() == excludeSocket) {
-            qDebug() << "Skipping sender client:" << it.value().username;
-            continue;
-        }
-        
-        if (it.key() && it.key()->state() == QTcpSocket::ConnectedState) {
-            qDebug() << "Sending to client:" << it.value().username;
-            it.key()->write(byteArray);
-            it.key()->flush(); // S'assurer que les données sont envoyées immédiatement
-        } else {
-            qDebug() << "ERREUR: Socket client invalide ou déconnecté";
-        }
-    }
+    // L'encodage et l'écriture sont faits sur le thread réseau
+    QMetaObject::invokeMethod(m_transport, [this, type, data, excludePeer]() {
+        m_transport->broadcastMessage(type, data, excludePeer);
+    }, Qt::QueuedConnection);
 }
 
-void Room::sendMessage(QTcpSocket *socket, const QString &type, const QJsonObject &data)
+void Room::sendMessage(quint64 peerId, const QString &type, const QJsonObject &data)
 {
-    if (!socket || socket->state() != QTcpSocket::ConnectedState) {
-        qDebug() << "ERREUR: Tentative d'envoi de message à un socket non connecté ou invalide";
+    if (peerId == 0) {
+        qDebug() << "ERREUR: Tentative d'envoi de message à un pair non connecté ou invalide";
         return;
     }
     
-    QJsonObject message;
-    message["type"] = type;
-    message["data"] = data;
-    
-    QJsonDocument doc(message);
-    QByteArray byteArray = doc.toJson(QJsonDocument::Compact);
-    
-    qDebug() << "Envoi du message de type:" << type << "taille:" << byteArray.size() << "octets";
-    socket->write(byteArray);
-    socket->flush(); // S'assurer que les données sont envoyées immédiatement
+    QMetaObject::invokeMethod(m_transport, [this, peerId, type, data]() {
+        m_transport->sendMessage(peerId, type, data);
+    }, Qt::QueuedConnection);
+}
+
+void Room::setPeerCodec(quint64 peerId, RoomProtocol::Codec codec)
+{
+    // Exécuté dans l'ordre des envois déjà programmés sur le thread réseau
+    QMetaObject::invokeMethod(m_transport, [this, peerId, codec]() {
+        m_transport->setPeerCodec(peerId, codec);
+    }, Qt::QueuedConnection);
+}
+
+void Room::sendFrame(quint64 peerId, const QByteArray &frame)
+{
+    // QByteArray est partagé implicitement: la trame n'est pas copiée entre les threads
+    QMetaObject::invokeMethod(m_transport, [this, peerId, frame]() {
+        m_transport->sendFrame(peerId, frame);
+    }, Qt::QueuedConnection);
 }
 
-void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonObject &data)
+void Room::processMessage(quint64 peerId, const QString &type, const QJsonObject &data)
 {
     if (type == "soundpad_removed") {
         // Récupérer les informations du SoundPad supprimé
@@ -416,7 +372,27 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
             // Enregistrer l'utilisateur
             ConnectedUser user;
             user.username = username;
-            m_users[socket] = user;
+            user.peerId = peerId;
+            
+            // Négocier le codec: un client qui n'annonce rien reste en JSON
+            QStringList codecs;
+            for (const QJsonValue &codecValue : data["codecs"].toArray()) {
+                codecs.append(codecValue.toString());
+            }
+            user.codec = RoomProtocol::negotiateCodec(codecs);
+            m_users[peerId] = user;
+            
+            if (m_isHost) {
+                // La réponse 'welcome' part encore en JSON, les messages suivants utilisent le codec choisi
+                QJsonObject welcomeData;
+                welcomeData["protocol_version"] = RoomProtocol::ProtocolVersion;
+                welcomeData["codec"] = RoomProtocol::codecName(user.codec);
+                sendMessage(peerId, "welcome", welcomeData);
+                setPeerCodec(peerId, user.codec);
+                
+                qDebug() << "Codec négocié avec" << username << ":" << RoomProtocol::codecName(user.codec)
+                         << "(version de protocole du client:" << data["protocol_version"].toInt(1) << ")";
+            }
             
             // Notifier les autres utilisateurs
             QJsonObject joinData;
@@ -424,7 +400,7 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
             
             // Envoyer aux autres clients sauf celui qui vient de se connecter
             for (auto it = m_users.begin(); it != m_users.end(); ++it) {
-                if (it.key() != socket) {
+                if (it.key() != peerId) {
                     sendMessage(it.key(), "user_joined", joinData);
                 }
             }
@@ -446,7 +422,7 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
                 
                 // Ajouter tous les autres utilisateurs connectés
                 for (auto it = m_users.begin(); it != m_users.end(); ++it) {
-                    if (it.key() != socket && !it.value().username.isEmpty()) {
+                    if (it.key() != peerId && !it.value().username.isEmpty()) {
                         usersArray.append(it.value().username);
                         qDebug() << "Ajout d'un utilisateur à la liste:" << it.value().username;
                     }
@@ -455,53 +431,13 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
                 // Envoyer la liste complète au nouveau client
                 QJsonObject usersData;
                 usersData["users"] = usersArray;
-                sendMessage(socket, "users_list", usersData);
+                sendMessage(peerId, "users_list", usersData);
                 
-                // Si nous avons un board, l'envoyer au client
+                // Si nous avons un board, l'envoyer au client avec tous ses pads en un seul message
                 if (m_board) {
-                    // Utiliser l'ID fixe (toujours "1") pour le board principal
-                    if (m_board->objectName().isEmpty()) {
-                        m_board->setObjectName("1");
-                        qDebug() << "ID fixe attribué au board principal: 1";
-                    }
-                    
-                    // Envoyer les informations du board
-                    QJsonObject boardData;
-                    boardData["board_id"] = m_board->objectName();
-                    boardData["board_name"] = m_board->getTitle();
-                    
-                    qDebug() << "Envoi du board principal" << m_board->objectName() << "au client";
-                    sendMessage(socket, "board_added", boardData);
-                    
-                    // Envoyer tous les SoundPads du board après un court délai
-                    QTimer::singleShot(300, this, [this, socket] {
-                        // Envoyer les SoundPads du board principal
-                        qDebug() << "Envoi des" << m_board->getSoundPads().size() << "pads du board principal";
-                        
-                        for (SoundPad* pad : m_board->getSoundPads()) {
-                            // Générer un ID pour le pad s'il n'en a pas
-                            if (pad->objectName().isEmpty()) {
-                                QString padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
-                                pad->setObjectName(padId);
-                                qDebug() << "ID généré pour un pad sans identifiant:" << padId;
-                            }
-                            
-                            QJsonObject padData;
-                            padData["board_id"] = m_board->objectName();
-                            padData["pad_id"] = pad->objectName();
-                            padData["title"] = pad->getTitle();
-                            padData["file_path"] = pad->getFilePath();
-                            padData["image_path"] = pad->getImagePath();
-                            padData["can_duplicate_play"] = pad->getCanDuplicatePlay();
-                            padData["shortcut"] = pad->getShortcut().toString();
-                            
-                            qDebug() << "Envoi du pad" << pad->objectName() << "au client";
-                            sendMessage(socket, "soundpad_added", padData);
-                            
-                            // Petit délai pour éviter de surcharger le client
-                            QThread::msleep(50);
-                        }
-                    });
+                    qDebug() << "Envoi de l'instantané du board principal" << m_board->objectName()
+                             << "(" << m_board->getSoundPads().size() << "pads) au client";
+                    sendFrame(peerId, boardSnapshotFrame(m_users[peerId].codec));
                 }
             }
             
@@ -510,79 +446,44 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
         }
     }
     else if (type == "soundpad_added") {
-        // Récupérer les informations du SoundPad
-        QString boardId = data["board_id"].toString();
-        QString padId = data["pad_id"].toString();
-        QString title = data["title"].toString();
-        QString filePath = data["file_path"].toString();
-        QString imagePath = data["image_path"].toString();
-        bool canDuplicatePlay = data["can_duplicate_play"].toBool();
-        QString shortcutString = data["shortcut"].toString();
-        QKeySequence shortcut = QKeySequence(shortcutString);
+        // Si nous sommes l'hôte, retransmettre aux autres clients seulement si l'ajout a réussi
+        if (addRemoteSoundPad(data, peerId) && m_isHost) {
+            qDebug() << "Retransmission du SoundPad aux autres clients";
+            
+            // Exclure le pair qui a envoyé ce message pour éviter les duplications
+            broadcastMessage("soundpad_added", data, peerId);
+            
+            qDebug() << "SoundPad diffusé à tous les autres clients";
+        }
+    }
+    else if (type == "welcome") {
+        // Réponse de l'hôte au 'join': codec à utiliser pour nos prochains messages
+        RoomProtocol::Codec codec = RoomProtocol::negotiateCodec({ data["codec"].toString() });
         
-        qDebug() << "Message 'soundpad_added' reçu pour le board" << boardId << "et le pad" << padId;
-        qDebug() << "Détails du SoundPad reçu: titre=" << title << ", filePath=" << filePath;
+        qDebug() << "Message 'welcome' reçu, protocole" << data["protocol_version"].toInt()
+                 << "codec:" << RoomProtocol::codecName(codec);
         
-        // IMPORTANT: Nous attendons toujours le board avec l'ID "1" pour tous les messages réseau
-        if (boardId != "1") {
-            qDebug() << "AVERTISSEMENT: ID de board inattendu:" << boardId << ". Utilisation de l'ID '1' à la place.";
-            boardId = "1";
+        if (!m_isHost && m_hostPeer != 0) {
+            setPeerCodec(m_hostPeer, codec);
         }
+    }
+    else if (type == "board_snapshot") {
+        // Instantané complet du board envoyé par l'hôte lors de la connexion
+        QString boardName = data["board_name"].toString();
+        QJsonArray pads = data["pads"].toArray();
         
-        // Vérifier que nous avons un board correspondant
-        Board *targetBoard = nullptr;
-        if (m_board && (m_board->objectName() == boardId || m_board->objectName() == "1")) {
-            targetBoard = m_board;
-            qDebug() << "Board cible trouvé:" << targetBoard->objectName();
-            
-            // Assurer que le board a toujours l'ID correct "1"
-            if (targetBoard->objectName() != "1") {
-                qDebug() << "Correction de l'ID du board de" << targetBoard->objectName() << "vers '1'";
-                targetBoard->setObjectName("1");
-            }
-        } else {
-            qDebug() << "ERREUR: Board cible introuvable. objectName du board local:" << (m_board ? m_board->objectName() : "null");
-        }
+        qDebug() << "Message 'board_snapshot' reçu avec" << pads.size() << "pads";
         
-        if (targetBoard) {
-            // Vérifier si nous avons déjà un pad avec cet ID
-            SoundPad* existingPad = targetBoard->getSoundPadById(padId);
-            if (existingPad) {
-                qDebug() << "Un SoundPad avec l'ID" << padId << "existe déjà, ignoré";
-                return;
-            }
-            
-            qDebug() << "Création d'un nouveau SoundPad avec ID:" << padId;
-            
-            // Créer un nouveau SoundPad
-            SoundPad *newPad = new SoundPad(title, filePath, imagePath, canDuplicatePlay, shortcut, targetBoard);
-            newPad->setObjectName(padId);
-            
-            qDebug() << "Tentative d'ajout d'un nouveau SoundPad:" << padId;
-            
-            // Ajouter le pad au board et vérifier le résultat
-            bool ajoutReussi = targetBoard->addSoundPadFromRemote(newPad);
-            
-            if (!ajoutReussi) {
-                // Si l'ajout a échoué (pad en double), supprimer le pad créé
-                delete newPad;
-                qDebug() << "ERREUR: Suppression du pad en double, l'ajout a échoué";
-                return;
+        if (!m_isHost && m_board) {
+            // Toujours utiliser l'ID fixe "1" pour le board
+            m_board->setObjectName("1");
+            if (m_board->getTitle() != boardName) {
+                m_board->setTitle(boardName);
             }
             
-            qDebug() << "Ajout du SoundPad réussi avec ID:" << padId;
-            
-            // Si nous sommes l'hôte, retransmettre aux autres clients seulement si l'ajout a réussi
-            if (m_isHost) {
-                qDebug() << "Retransmission du SoundPad aux autres clients";
-                
-                // Exclure le socket qui a envoyé ce message pour éviter les duplications
-                broadcastMessage("soundpad_added", data, socket);
-                
-                qDebug() << "SoundPad diffusé à tous les autres clients";
+            for (const QJsonValue &padValue : pads) {
+                addRemoteSoundPad(padValue.toObject(), peerId);
             }
-        } else {
-            qDebug() << "ERREUR: Impossible de trouver le board" << boardId << "pour ajouter le SoundPad";
         }
     }
     else if (type == "board_added") {
@@ -620,10 +521,14 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
                 
                 // Mettre à jour les propriétés du pad
                 pad->setTitle(data["title"].toString());
-                pad->setFilePath(data["filePath"].toString());
-                pad->setImagePath(data["imagePath"].toString());
+                resolveAsset(pad, false, data["filePath"].toString(), data["fileHash"].toString(),
+                             data["fileSize"].toInteger(), peerId);
+                resolveAsset(pad, true, data["imagePath"].toString(), data["imageHash"].toString(),
+                             data["imageSize"].toInteger(), peerId);
                 pad->setCanDuplicatePlay(data["canDuplicatePlay"].toBool());
                 pad->setShortcut(QKeySequence(data["shortcut"].toString()));
+                pad->setMacro(macroFromData(data["macro"]));
+                ++m_boardRevision;
 
                 // Émettre le signal de modification
                 emit soundpadModified(board, pad);
@@ -631,7 +536,7 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
                 // Si nous sommes l'hôte, retransmettre aux autres clients
                 if (m_isHost) {
                     qDebug() << "Retransmission des modifications aux autres clients";
-                    broadcastMessage("soundpad_modified", data, socket);
+                    broadcastMessage("soundpad_modified", data, peerId);
                 }
             } else {
                 qDebug() << "Impossible de trouver le pad" << padId << "dans le board" << boardId;
@@ -640,9 +545,314 @@ void Room::processMessage(QTcpSocket *socket, const QString &type, const QJsonOb
             qDebug() << "Impossible de trouver le board" << boardId << "pour modifier le SoundPad";
         }
     }
+    else if (type == "soundpad_play") {
+        QString boardId = data["board_id"].toString();
+        QString padId = data["pad_id"].toString();
+        
+        SoundPad *pad = nullptr;
+        if (m_board && m_board->objectName() == boardId) {
+            pad = m_board->getSoundPadById(padId);
+        }
+        
+        if (pad) {
+            // Sans instant commun (émetteur ou récepteur non synchronisé), jouer tout de suite
+            qint64 localTime = 0;
+            if (data.contains("at") && isClockSynchronized()) {
+                localTime = toLocalTime(data["at"].toInteger());
+                const qint64 late = LatencyMonitor::now() / 1000 + AudioEngine::instance()->outputLatency() / 1000 - localTime;
+                if (late > 0) {
+                    // Le mixeur saute le début du son pour rester aligné avec les autres pairs
+                    qDebug() << "AVERTISSEMENT: Lecture du pad" << padId << "reçue avec" << late / 1000.0
+                             << "ms de retard, début du son sauté";
+                }
+            }
+            pad->playAt(localTime * 1000);
+        } else {
+            qDebug() << "Impossible de trouver le pad" << padId << "dans le board" << boardId << "pour le jouer";
+        }
+        
+        // L'instant est dans l'horloge de l'hôte: le message est retransmis tel quel
+        if (m_isHost) {
+            broadcastMessage("soundpad_play", data, peerId);
+        }
+    }
     // Autres messages...
 }
 
+bool Room::addRemoteSoundPad(const QJsonObject &data, quint64 sourcePeer)
+{
+    // Récupérer les informations du SoundPad
+    QString boardId = data["board_id"].toString();
+    QString padId = data["pad_id"].toString();
+    QString title = data["title"].toString();
+    QString filePath = data["file_path"].toString();
+    QString imagePath = data["image_path"].toString();
+    bool canDuplicatePlay = data["can_duplicate_play"].toBool();
+    QString shortcutString = data["shortcut"].toString();
+    QKeySequence shortcut = QKeySequence(shortcutString);
+    
+    qDebug() << "Ajout d'un SoundPad distant pour le board" << boardId << "et le pad" << padId;
+    qDebug() << "Détails du SoundPad reçu: titre=" << title << ", filePath=" << filePath;
+    
+    // IMPORTANT: Nous attendons toujours le board avec l'ID "1" pour tous les messages réseau
+    if (boardId != "1") {
+        qDebug() << "AVERTISSEMENT: ID de board inattendu:" << boardId << ". Utilisation de l'ID '1' à la place.";
+        boardId = "1";
+    }
+    
+    // Vérifier que nous avons un board correspondant
+    Board *targetBoard = nullptr;
+    if (m_board && (m_board->objectName() == boardId || m_board->objectName() == "1")) {
+        targetBoard = m_board;
+        qDebug() << "Board cible trouvé:" << targetBoard->objectName();
+        
+        // Assurer que le board a toujours l'ID correct "1"
+        if (targetBoard->objectName() != "1") {
+            qDebug() << "Correction de l'ID du board de" << targetBoard->objectName() << "vers '1'";
+            targetBoard->setObjectName("1");
+        }
+    } else {
+        qDebug() << "ERREUR: Board cible introuvable. objectName du board local:" << (m_board ? m_board->objectName() : "null");
+    }
+    
+    if (targetBoard) {
+        // Vérifier si nous avons déjà un pad avec cet ID
+        SoundPad* existingPad = targetBoard->getSoundPadById(padId);
+        if (existingPad) {
+            qDebug() << "Un SoundPad avec l'ID" << padId << "existe déjà, ignoré";
+            return false;
+        }
+        
+        qDebug() << "Création d'un nouveau SoundPad avec ID:" << padId;
+        
+        // Créer un nouveau SoundPad; ses fichiers sont résolus via le stockage local
+        SoundPad *newPad = new SoundPad(title, QString(), QString(), canDuplicatePlay, shortcut, targetBoard);
+        newPad->setObjectName(padId);
+        newPad->setMacro(macroFromData(data["macro"]));
+        
+        qDebug() << "Tentative d'ajout d'un nouveau SoundPad:" << padId;
+        
+        // Ajouter le pad au board et vérifier le résultat
+        bool ajoutReussi = targetBoard->addSoundPadFromRemote(newPad);
+        
+        if (!ajoutReussi) {
+            // Si l'ajout a échoué (pad en double), supprimer le pad créé
+            delete newPad;
+            qDebug() << "ERREUR: Suppression du pad en double, l'ajout a échoué";
+            return false;
+        }
+        
+        resolveAsset(newPad, false, filePath, data["file_hash"].toString(), data["file_size"].toInteger(), sourcePeer);
+        resolveAsset(newPad, true, imagePath, data["image_hash"].toString(), data["image_size"].toInteger(), sourcePeer);
+        
+        qDebug() << "Ajout du SoundPad réussi avec ID:" << padId;
+        return true;
+    } else {
+        qDebug() << "ERREUR: Impossible de trouver le board" << boardId << "pour ajouter le SoundPad";
+    }
+    
+    return false;
+}
+
+QJsonObject Room::soundPadData(Board *board, SoundPad *pad) const
+{
+    QJsonObject padData;
+    padData["board_id"] = board->objectName();
+    padData["pad_id"] = pad->objectName();
+    padData["title"] = pad->getTitle();
+    padData["file_path"] = pad->getFilePath();
+    padData["image_path"] = pad->getImagePath();
+    padData["can_duplicate_play"] = pad->getCanDuplicatePlay();
+    padData["shortcut"] = pad->getShortcut().toString();
+    if (pad->isMacro()) {
+        padData["macro"] = macroData(pad);
+    }
+    addAssetInfo(padData, pad->getFilePath(), "file_hash", "file_size");
+    addAssetInfo(padData, pad->getImagePath(), "image_hash", "image_size");
+    
+    return padData;
+}
+
+QJsonArray Room::macroData(const SoundPad *pad)
+{
+    QJsonArray members;
+    for (const SoundPad::MacroMember &member : pad->getMacro()) {
+        QJsonObject memberData;
+        memberData["pad_id"] = member.padId;
+        memberData["offset"] = member.offset;
+        memberData["gain"] = member.gain;
+        members.append(memberData);
+    }
+    return members;
+}
+
+QVector<SoundPad::MacroMember> Room::macroFromData(const QJsonValue &data)
+{
+    QVector<SoundPad::MacroMember> members;
+    for (const QJsonValue &value : data.toArray()) {
+        const QJsonObject memberData = value.toObject();
+        SoundPad::MacroMember member;
+        member.padId = memberData["pad_id"].toString();
+        member.offset = qBound(0, memberData["offset"].toInt(), 10000);
+        member.gain = qBound(0.0, memberData["gain"].toDouble(1.0), 2.0);
+        if (!member.padId.isEmpty() && members.size() < AudioMixer::MaxGroupMembers) {
+            members.append(member);
+        }
+    }
+    return members;
+}
+
+void Room::addAssetInfo(QJsonObject &data, const QString &path, const QString &hashKey, const QString &sizeKey) const
+{
+    if (path.isEmpty()) {
+        return;
+    }
+    
+    // Hacher et copier un gros fichier bloquerait l'interface: l'import se fait à côté
+    const QString hash = AssetStore::instance()->cachedHash(path);
+    if (hash.isEmpty()) {
+        AssetStore::instance()->importFileAsync(path);
+        return;
+    }
+    
+    data[hashKey] = hash;
+    data[sizeKey] = AssetStore::instance()->fileSize(hash);
+}
+
+void Room::resolveAsset(SoundPad *pad, bool isImage, const QString &path, const QString &hash,
+                        qint64 size, quint64 sourcePeer)
+{
+    // Un pair qui n'envoie pas d'empreinte valide ne peut pas fournir le fichier
+    if (!hash.isEmpty() && !AssetStore::isValidHash(hash)) {
+        qDebug() << "AVERTISSEMENT: Empreinte invalide reçue du pair" << sourcePeer << ":" << hash;
+    }
+    if (!AssetStore::isValidHash(hash)) {
+        if (isImage) {
+            pad->setImagePath(path);
+        } else {
+            pad->setFilePath(path);
+        }
+        return;
+    }
+    
+    AssetStore *store = AssetStore::instance();
+    if (store->contains(hash)) {
+        const QString localPath = store->filePath(hash);
+        if (isImage && pad->getImagePath() != localPath) {
+            pad->setImagePath(localPath);
+        } else if (!isImage && pad->getFilePath() != localPath) {
+            pad->setFilePath(localPath);
+        }
+        return;
+    }
+    
+    qDebug() << "Fichier" << hash << "absent du stockage local, téléchargement auprès du pair" << sourcePeer;
+    
+    m_pendingAssets.insert(hash, { pad, isImage });
+    
+    const QString suffix = QFileInfo(path).suffix();
+    QMetaObject::invokeMethod(m_transport, [transport = m_transport, sourcePeer, hash, suffix, size]() {
+        transport->fetchAsset(sourcePeer, hash, suffix, size);
+    }, Qt::QueuedConnection);
+}
+
+void Room::handleAssetTransferFinished(const QString &hash, bool success)
+{
+    const QList<PendingAsset> waiting = m_pendingAssets.values(hash);
+    m_pendingAssets.remove(hash);
+    
+    if (!success) {
+        qDebug() << "ERREUR: Échec du téléchargement du fichier" << hash << "pour" << waiting.size() << "pads";
+        return;
+    }
+    
+    const QString localPath = AssetStore::instance()->filePath(hash);
+    for (const PendingAsset &pending : waiting) {
+        if (!pending.pad) {
+            continue;
+        }
+        
+        if (pending.isImage) {
+            pending.pad->setImagePath(localPath);
+        } else {
+            pending.pad->setFilePath(localPath);
+        }
+        emit soundpadModified(m_board, pending.pad);
+    }
+    
+    qDebug() << "Fichier" << hash << "disponible, appliqué à" << waiting.size() << "pads";
+}
+
+void Room::handleFileImported(const QString &filePath, const QString &hash)
+{
+    if (hash.isEmpty()) {
+        qDebug() << "AVERTISSEMENT: Fichier introuvable, il ne pourra pas être transféré:" << filePath;
+        return;
+    }
+    if (!m_board) {
+        return;
+    }
+    
+    for (SoundPad *pad : m_board->getSoundPads()) {
+        if (pad->getFilePath() == filePath || pad->getImagePath() == filePath) {
+            invalidateBoardSnapshot();
+            notifySoundPadModified(m_board, pad);
+        }
+    }
+}
+
+QByteArray Room::boardSnapshotFrame(RoomProtocol::Codec codec)
+{
+    // Une nouvelle révision du board invalide toutes les trames encodées
+    if (m_snapshotRevision != m_boardRevision) {
+        m_snapshotFrames.clear();
+        m_snapshotRevision = m_boardRevision;
+    }
+    
+    // Réutiliser la trame déjà encodée tant que le board n'a pas changé
+    if (m_snapshotFrames.contains(codec)) {
+        return m_snapshotFrames.value(codec);
+    }
+    
+    // Utiliser l'ID fixe (toujours "1") pour le board principal
+    if (m_board->objectName().isEmpty()) {
+        m_board->setObjectName("1");
+        qDebug() << "ID fixe attribué au board principal: 1";
+    }
+    
+    QJsonArray padsArray;
+    for (SoundPad *pad : m_board->getSoundPads()) {
+        // Générer un ID pour le pad s'il n'en a pas
+        if (pad->objectName().isEmpty()) {
+            QString padId = SoundPad::createId();
+            pad->setObjectName(padId);
+            qDebug() << "ID généré pour un pad sans identifiant:" << padId;
+        }
+        
+        padsArray.append(soundPadData(m_board, pad));
+    }
+    
+    QJsonObject snapshotData;
+    snapshotData["board_id"] = m_board->objectName();
+    snapshotData["board_name"] = m_board->getTitle();
+    snapshotData["revision"] = static_cast<qint64>(m_boardRevision);
+    snapshotData["pads"] = padsArray;
+    
+    QByteArray frame = RoomProtocol::encodeMessage("board_snapshot", snapshotData, codec);
+    m_snapshotFrames.insert(codec, frame);
+    
+    qDebug() << "Instantané du board encodé en" << RoomProtocol::codecName(codec)
+             << "(révision" << m_boardRevision << "):"
+             << padsArray.size() << "pads," << frame.size() << "octets";
+    
+    return frame;
+}
+
+void Room::invalidateBoardSnapshot()
+{
+    ++m_boardRevision;
+}
+
 void Room::notifySoundPadAdded(Board *board, SoundPad *pad)
 {
     qDebug() << "Entrée dans notifySoundPadAdded pour board:" << (board ? board->objectName() : "null") 
@@ -661,7 +871,7 @@ void Room::notifySoundPadAdded(Board *board, SoundPad *pad)
     
     // Générer un identifiant unique si nécessaire
     if (pad->objectName().isEmpty()) {
-        QString padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
+        QString padId = SoundPad::createId();
         pad->setObjectName(padId);
         qDebug() << "ID généré pour un pad sans identifiant dans notifySoundPadAdded:" << padId;
     }
@@ -669,22 +879,15 @@ void Room::notifySoundPadAdded(Board *board, SoundPad *pad)
     qDebug() << "Notification d'ajout du SoundPad:" << pad->objectName() << "au Board:" << board->objectName();
     
     // Créer les données à envoyer
-    QJsonObject padData;
-    padData["board_id"] = board->objectName();
-    padData["pad_id"] = pad->objectName();
-    padData["title"] = pad->getTitle();
-    padData["file_path"] = pad->getFilePath();
-    padData["image_path"] = pad->getImagePath();
-    padData["can_duplicate_play"] = pad->getCanDuplicatePlay();
-    padData["shortcut"] = pad->getShortcut().toString();
+    QJsonObject padData = soundPadData(board, pad);
     
     // Diffuser à tous les clients si nous sommes l'hôte
     if (m_isHost) {
         qDebug() << "Diffusion du message 'soundpad_added' à tous les clients";
         broadcastMessage("soundpad_added", padData);
-    } else if (m_clientSocket && m_clientSocket->state() == QAbstractSocket::ConnectedState) {
+    } else if (m_hostPeer != 0) {
         qDebug() << "Envoi du message 'soundpad_added' à l'hôte";
-        sendMessage(m_clientSocket, "soundpad_added", padData);
+        sendMessage(m_hostPeer, "soundpad_added", padData);
     }
     
     // Émettre le signal local
@@ -714,7 +917,7 @@ void Room::notifySoundPadRemoved(Board *board, SoundPad *pad)
     
     // Vérifier que le pad a un identifiant valide
     if (pad->objectName().isEmpty()) {
-        padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
+        padId = SoundPad::createId();
         pad->setObjectName(padId);
         qDebug() << "ID généré pour un pad sans identifiant dans notifySoundPadRemoved:" << padId;
     } else {
@@ -732,9 +935,9 @@ void Room::notifySoundPadRemoved(Board *board, SoundPad *pad)
     if (m_isHost) {
         qDebug() << "Diffusion du message 'soundpad_removed' à tous les clients";
         broadcastMessage("soundpad_removed", padData);
-    } else if (m_clientSocket && m_clientSocket->state() == QAbstractSocket::ConnectedState) {
+    } else if (m_hostPeer != 0) {
         qDebug() << "Envoi du message 'soundpad_removed' à l'hôte";
-        sendMessage(m_clientSocket, "soundpad_removed", padData);
+        sendMessage(m_hostPeer, "soundpad_removed", padData);
     }
     
     // Émettre le signal local avec le pad et le board
@@ -760,7 +963,7 @@ void Room::notifySoundPadModified(Board *board, SoundPad *pad)
 
     // Vérifier que le pad a un ID
     if (pad->objectName().isEmpty()) {
-        QString padId = QString("pad_%1").arg(QDateTime::currentMSecsSinceEpoch());
+        QString padId = SoundPad::createId();
         pad->setObjectName(padId);
         qDebug() << "ID généré pour le pad dans notifySoundPadModified:" << padId;
     }
@@ -773,7 +976,10 @@ void Room::notifySoundPadModified(Board *board, SoundPad *pad)
     padData["imagePath"] = pad->getImagePath();
     padData["canDuplicatePlay"] = pad->getCanDuplicatePlay();
     padData["shortcut"] = pad->getShortcut().toString();
+    padData["macro"] = macroData(pad);
     padData["boardId"] = board->objectName();
+    addAssetInfo(padData, pad->getFilePath(), "fileHash", "fileSize");
+    addAssetInfo(padData, pad->getImagePath(), "imageHash", "imageSize");
 
     qDebug() << "Diffusion du message soundpad_modified aux clients";
     
@@ -781,9 +987,9 @@ void Room::notifySoundPadModified(Board *board, SoundPad *pad)
     if (m_isHost) {
         qDebug() << "Diffusion du message 'soundpad_modified' à tous les clients";
         broadcastMessage("soundpad_modified", padData);
-    } else if (m_clientSocket && m_clientSocket->state() == QAbstractSocket::ConnectedState) {
+    } else if (m_hostPeer != 0) {
         qDebug() << "Envoi du message 'soundpad_modified' à l'hôte";
-        sendMessage(m_clientSocket, "soundpad_modified", padData);
+        sendMessage(m_hostPeer, "soundpad_modified", padData);
     }
 
     // Émettre le signal local
@@ -792,20 +998,135 @@ void Room::notifySoundPadModified(Board *board, SoundPad *pad)
     qDebug() << "SoundPad" << pad->objectName() << "modifié et diffusé aux clients";
 }
 
-void Room::stopServer()
+void Room::notifySoundPadPlayed(SoundPad *pad, qint64 inputTime)
+{
+    if (!pad || !m_board) {
+        qDebug() << "ERREUR: pad invalide dans notifySoundPadPlayed";
+        return;
+    }
+    
+    // Seul dans la room: aucune raison de retarder le son
+    const bool connected = m_isHost ? !m_users.isEmpty() : m_hostPeer != 0;
+    if (!connected) {
+        pad->playAt(0, inputTime);
+        return;
+    }
+    
+    QJsonObject playData;
+    playData["board_id"] = m_board->objectName();
+    playData["pad_id"] = pad->objectName();
+    
+    qint64 localTime = 0;
+    if (isClockSynchronized()) {
+        const qint64 at = roomTime() + playbackLead();
+        playData["at"] = at;
+        localTime = toLocalTime(at) * 1000;
+    } else {
+        qDebug() << "AVERTISSEMENT: Horloge de l'hôte pas encore mesurée, lecture immédiate du pad" << pad->objectName();
+    }
+    
+    if (m_isHost) {
+        broadcastMessage("soundpad_play", playData);
+    } else {
+        sendMessage(m_hostPeer, "soundpad_play", playData);
+    }
+    
+    // Un son planifié n'est pas compté dans la latence de déclenchement: son retard est voulu
+    pad->playAt(localTime, localTime == 0 ? inputTime : 0);
+}
+
+void Room::handleClockSample(quint64 peerId, qint64 t0, qint64 t1, qint64 t2, qint64 t3,
+                             qint64 outputLatency, qint64 lead)
 {
-    if (m_server && m_server->isListening()) {
-        // Fermer toutes les connexions
-        for (QTcpSocket *socket : m_users.keys()) {
-            socket->close();
-            socket->deleteLater();
+    // Pair déjà déconnecté: la réponse est arrivée trop tard
+    if (peerId != m_hostPeer && !m_users.contains(peerId)) {
+        return;
+    }
+    
+    PeerClock &clock = m_clocks[peerId];
+    const bool first = !clock.sync.isSynchronized();
+    clock.sync.addSample(t0, t1, t2, t3);
+    clock.outputLatency = outputLatency;
+    clock.lead = lead;
+    
+    if (first) {
+        qDebug() << "Horloge du pair" << peerId << "mesurée: écart" << clock.sync.offset() << "µs, aller-retour"
+                 << clock.sync.delay() << "µs, latence de sortie" << outputLatency << "µs";
+    }
+    
+    updateClockInfo();
+}
+
+bool Room::isClockSynchronized() const
+{
+    if (m_isHost) {
+        return true;
+    }
+    auto it = m_clocks.constFind(m_hostPeer);
+    return it != m_clocks.constEnd() && it.value().sync.isSynchronized();
+}
+
+qint64 Room::roomTime() const
+{
+    const qint64 local = LatencyMonitor::now() / 1000;
+    if (m_isHost) {
+        return local;
+    }
+    return m_clocks.value(m_hostPeer).sync.toRemote(local);
+}
+
+qint64 Room::toLocalTime(qint64 time) const
+{
+    if (m_isHost) {
+        return time;
+    }
+    return m_clocks.value(m_hostPeer).sync.toLocal(time);
+}
+
+qint64 Room::playbackLead() const
+{
+    const qint64 ownLatency = AudioEngine::instance()->outputLatency() / 1000;
+    qint64 lead = ownLatency;
+    
+    if (m_isHost) {
+        // Le client le plus lointain, sortie audio comprise, fixe l'avance
+        for (auto it = m_clocks.constBegin(); it != m_clocks.constEnd(); ++it) {
+            const PeerClock &clock = it.value();
+            if (clock.sync.isSynchronized()) {
+                lead = qMax(lead, clock.sync.delay() / 2 + 3 * clock.sync.jitter() + clock.outputLatency);
+            }
         }
+    } else if (m_clocks.contains(m_hostPeer)) {
+        // Notre trajet vers l'hôte, puis l'avance qu'il annonce pour la suite
+        const PeerClock clock = m_clocks.value(m_hostPeer);
+        lead = clock.sync.delay() / 2 + 3 * clock.sync.jitter() + qMax(clock.lead, ownLatency);
+    }
+    
+    lead += PlayMargin;
+    return lead < MaxPlayLead ? lead : MaxPlayLead;
+}
+
+void Room::updateClockInfo()
+{
+    const qint64 outputLatency = AudioEngine::instance()->outputLatency() / 1000;
+    const qint64 lead = playbackLead();
+    QMetaObject::invokeMethod(m_transport, [this, outputLatency, lead]() {
+        m_transport->setClockInfo(outputLatency, lead);
+    }, Qt::QueuedConnection);
+}
+
+void Room::stopServer()
+{
+    if (m_serverRunning) {
+        // Fermer toutes les connexions et arrêter le serveur sur le thread réseau
+        QMetaObject::invokeMethod(m_transport, [this]() {
+            m_transport->stopServer();
+        }, Qt::BlockingQueuedConnection);
         
         // Vider la liste des utilisateurs
         m_users.clear();
-        
-        // Arrêter le serveur
-        m_server->close();
+        m_clocks.clear();
+        m_serverRunning = false;
         
         // Émettre le signal d'arrêt du serveur
         emit serverStopped();
@@ -3,9 +3,10 @@
 
 #include <QObject>
 #include <QString>
-#include <QTcpServer>
-#include <QTcpSocket>
+#include <QThread>
 #include <QMap>
+#include <QMultiHash>
+#include <QPointer>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -13,28 +14,44 @@
 #include <QNetworkInterface>
 #include "board.h"
 #include "soundpad.h"
+#include "roomprotocol.h"
+#include "clocksync.h"
 
 class User;
+class RoomTransport;
 
 /**
  * @brief Classe représentant une salle de collaboration
  * 
  * Cette classe gère les connexions client, le serveur, le tableau et les utilisateurs connectés.
+ * Les sockets sont gérés par un RoomTransport exécuté sur un thread dédié ; la Room
+ * ne manipule que des identifiants de pairs et des messages déjà décodés.
+ *
+ * Un pad déclenché dans la room est joué au même instant par tous les participants :
+ * l'horloge de l'hôte sert d'horloge commune, chaque client estime son écart avec elle
+ * (ClockSync, à partir des sondages du transport) et le message 'soundpad_play' porte
+ * l'instant de lecture dans cette horloge. Cet instant est pris assez loin dans le futur
+ * pour que le message atteigne chaque participant et traverse sa sortie audio : délai
+ * réseau, gigue et latence de sortie de chacun sont mesurés et échangés en continu.
  */
 class Room : public QObject
 {
     Q_OBJECT
     
 public:
+    static constexpr qint64 PlayMargin = 5000;      ///< Marge ajoutée à l'avance d'une lecture synchronisée (µs)
+    static constexpr qint64 MaxPlayLead = 500000;   ///< Avance maximale d'une lecture synchronisée (µs)
+
     /**
      * @brief Structure définissant un utilisateur connecté
      */
     struct ConnectedUser {
         QString username;       // Nom d'utilisateur
-        QTcpSocket *socket;     // Socket de connexion
+        quint64 peerId;         // Identifiant de la connexion dans le RoomTransport
+        RoomProtocol::Codec codec; // Codec négocié lors du 'join'
         
-        ConnectedUser(const QString &name = "", QTcpSocket *sock = nullptr)
-            : username(name), socket(sock) {}
+        ConnectedUser(const QString &name = "", quint64 peer = 0)
+            : username(name), peerId(peer), codec(RoomProtocol::JsonCodec) {}
     };
     
     /**
@@ -172,6 +189,16 @@ public slots:
      */
     void notifySoundPadModified(Board *board, SoundPad *pad);
 
+    /**
+     * @brief Joue un SoundPad déclenché localement chez tous les participants
+     * @details L'instant de lecture est choisi dans l'horloge commune, envoyé aux autres
+     *          participants, puis le pad est planifié localement au même instant. Sans
+     *          horloge synchronisée, le son est joué tout de suite partout.
+     * @param pad SoundPad déclenché
+     * @param inputTime Réception du clic ou de la touche (LatencyMonitor::now())
+     */
+    void notifySoundPadPlayed(SoundPad *pad, qint64 inputTime);
+
 signals:
     /**
      * @brief Signal émis lorsqu'un utilisateur se connecte
@@ -227,60 +254,229 @@ signals:
 private slots:
     /**
      * @brief Gère une nouvelle connexion entrante
+     * @param peerId Identifiant du pair connecté
+     */
+    void handlePeerConnected(quint64 peerId);
+    
+    /**
+     * @brief Gère la déconnexion d'un pair
+     * @param peerId Identifiant du pair déconnecté
+     */
+    void handlePeerDisconnected(quint64 peerId);
+    
+    /**
+     * @brief Traite un message reçu
+     * @param peerId Pair qui a envoyé le message
+     * @param type Type de message
+     * @param data Données du message
      */
-    void handleNewConnection();
+    void processMessage(quint64 peerId, const QString &type, const QJsonObject &data);
     
     /**
-     * @brief Gère la réception de données
+     * @brief Marque l'instantané encodé du board comme obsolète
      */
-    void handleDataReceived();
+    void invalidateBoardSnapshot();
     
     /**
-     * @brief Gère la déconnexion d'un client
+     * @brief Applique aux pads en attente un fichier dont le téléchargement est terminé
+     * @param hash Empreinte du fichier
+     * @param success true si le fichier est disponible localement
      */
-    void handleClientDisconnected();
+    void handleAssetTransferFinished(const QString &hash, bool success);
+
+    /**
+     * @brief Diffuse de nouveau les pads dont un fichier vient d'être importé
+     * @details Leur description envoyée plus tôt ne contenait pas encore l'empreinte.
+     * @param filePath Chemin du fichier importé
+     * @param hash Empreinte du fichier, vide en cas d'échec
+     */
+    void handleFileImported(const QString &filePath, const QString &hash);
+    
+    /**
+     * @brief Ajoute un échange d'horloge à l'estimation propre à un pair
+     * @param peerId Pair sondé
+     * @param t0 Envoi du ping (µs, horloge locale)
+     * @param t1 Réception du ping par le pair (µs, horloge du pair)
+     * @param t2 Envoi du pong par le pair (µs, horloge du pair)
+     * @param t3 Réception du pong (µs, horloge locale)
+     * @param outputLatency Latence de la sortie audio du pair (µs)
+     * @param lead Avance annoncée par le pair (µs)
+     */
+    void handleClockSample(quint64 peerId, qint64 t0, qint64 t1, qint64 t2, qint64 t3,
+                           qint64 outputLatency, qint64 lead);
     
 private:
+    /**
+     * @brief Pad dont le son ou l'image attend la fin d'un téléchargement
+     */
+    struct PendingAsset {
+        QPointer<SoundPad> pad;   // Pad à mettre à jour (nul s'il a été supprimé entre-temps)
+        bool isImage;             // true pour l'image, false pour le son
+    };
+    
+    /**
+     * @brief Horloge et latences mesurées d'un pair
+     */
+    struct PeerClock {
+        ClockSync sync;           // Écart entre l'horloge du pair et la nôtre
+        qint64 outputLatency;     // Latence de la sortie audio du pair (µs)
+        qint64 lead;              // Avance annoncée par le pair (µs)
+        
+        PeerClock() : outputLatency(0), lead(0) {}
+    };
+    
+
     QString m_name;                       // Nom de la room
     QString m_invitationCode;             // Code d'invitation
     QString m_hostUsername;               // Nom d'utilisateur de l'hôte
     Board *m_board;                       // Board principal
-    QMap<QTcpSocket*, ConnectedUser> m_users; // Utilisateurs connectés
-    QTcpServer *m_server;               // Serveur TCP
-    QTcpSocket *m_clientSocket;         // Socket client
+    QMap<quint64, ConnectedUser> m_users; // Utilisateurs connectés, par identifiant de pair
+    RoomTransport *m_transport;         // Couche réseau (serveur et sockets)
+    QThread *m_ioThread;                // Thread d'exécution de m_transport
+    quint64 m_hostPeer;                 // Pair représentant l'hôte (client uniquement, 0 si non connecté)
+    bool m_serverRunning;               // Indique si le serveur écoute
     bool m_isHost;                      // Indique si l'utilisateur est l'hôte
     int m_port;                         // Port d'écoute
+    quint64 m_boardRevision;            // Révision courante du board, incrémentée à chaque modification
+    quint64 m_snapshotRevision;         // Révision du board encodée dans m_snapshotFrames
+    QMap<RoomProtocol::Codec, QByteArray> m_snapshotFrames; // Trames 'board_snapshot' encodées par codec
+    QMultiHash<QString, PendingAsset> m_pendingAssets; // Pads en attente de fichiers, par empreinte
+    QMap<quint64, PeerClock> m_clocks;  // Horloges mesurées, par identifiant de pair
     
     /**
      * @brief Envoie un message à tous les clients
      * @param type Type de message
      * @param data Données à envoyer
-     * @param excludeSocket Socket à exclure de la diffusion (optionnel)
+     * @param excludePeer Pair à exclure de la diffusion (optionnel)
      */
-    void broadcastMessage(const QString &type, const QJsonObject &data, QTcpSocket *excludeSocket = nullptr);
+    void broadcastMessage(const QString &type, const QJsonObject &data, quint64 excludePeer = 0);
     
     /**
-     * @brief Envoie un message à un client spécifique
-     * @param socket Socket du client
+     * @brief Envoie un message à un pair spécifique
+     * @param peerId Identifiant du pair
      * @param type Type de message
      * @param data Données à envoyer
      */
-    void sendMessage(QTcpSocket *socket, const QString &type, const QJsonObject &data);
+    void sendMessage(quint64 peerId, const QString &type, const QJsonObject &data);
     
     /**
-     * @brief Traite un message reçu
-     * @param socket Socket qui a envoyé le message
-     * @param type Type de message
-     * @param data Données du message
+     * @brief Envoie une trame déjà encodée à un pair
+     * @param peerId Identifiant du pair
+     * @param frame Trame complète (en-tête de longueur inclus)
      */
-    void processMessage(QTcpSocket *socket, const QString &type, const QJsonObject &data);
+    void sendFrame(quint64 peerId, const QByteArray &frame);
+    
+    /**
+     * @brief Change le codec utilisé pour les prochains messages envoyés à un pair
+     * @param peerId Identifiant du pair
+     * @param codec Codec négocié
+     */
+    void setPeerCodec(quint64 peerId, RoomProtocol::Codec codec);
     
     /**
      * @brief Vérifie si les boards sont correctement chargés et envoie une confirmation à l'hôte
      * @param boardIds Liste des identifiants de boards à vérifier
-     * @param socket Socket à utiliser pour envoyer la confirmation
+     * @param peerId Pair auquel envoyer la confirmation
+     */
+    void confirmBoardsLoaded(const QJsonArray &boardIds, quint64 peerId);
+    
+    /**
+     * @brief Crée et ajoute au board un SoundPad décrit par un message réseau
+     * @param data Description du pad (format 'soundpad_added')
+     * @param sourcePeer Pair qui a envoyé la description et auprès duquel télécharger les fichiers
+     * @return true si le pad a été ajouté, false s'il existait déjà ou si le board est introuvable
+     */
+    bool addRemoteSoundPad(const QJsonObject &data, quint64 sourcePeer);
+    
+    /**
+     * @brief Ajoute l'empreinte et la taille d'un fichier à la description d'un pad
+     * @details Seule une empreinte déjà connue est ajoutée. Sinon le fichier est importé
+     *          dans le stockage en arrière-plan, et le pad est de nouveau diffusé une fois
+     *          l'empreinte calculée (handleFileImported()).
+     * @param data Description du pad à compléter
+     * @param path Chemin local du fichier
+     * @param hashKey Clé recevant l'empreinte
+     * @param sizeKey Clé recevant la taille
+     */
+    void addAssetInfo(QJsonObject &data, const QString &path, const QString &hashKey, const QString &sizeKey) const;
+
+    /**
+     * @brief Décrit les membres d'une macro pour la clé "macro" d'un message
+     * @param pad Pad décrit
+     * @return Tableau de {pad_id, offset, gain}, vide pour un pad ordinaire
+     */
+    static QJsonArray macroData(const SoundPad *pad);
+
+    /**
+     * @brief Relit les membres d'une macro reçus d'un pair
+     * @param data Valeur de la clé "macro"
+     * @return Membres de la macro, vide pour un pad ordinaire
+     */
+    static QVector<SoundPad::MacroMember> macroFromData(const QJsonValue &data);
+    
+    /**
+     * @brief Associe à un pad le fichier décrit par un message réseau
+     * @details Si le fichier est déjà présent dans le stockage, le pad l'utilise directement ;
+     *          sinon il est téléchargé auprès de sourcePeer et le pad est mis à jour à la fin
+     *          du transfert. Sans empreinte (pair ancien), le chemin reçu est utilisé tel quel.
+     * @param pad Pad à mettre à jour
+     * @param isImage true pour l'image, false pour le son
+     * @param path Chemin du fichier chez l'émetteur
+     * @param hash Empreinte du fichier
+     * @param size Taille du fichier
+     * @param sourcePeer Pair qui possède le fichier
+     */
+    void resolveAsset(SoundPad *pad, bool isImage, const QString &path, const QString &hash,
+                      qint64 size, quint64 sourcePeer);
+    
+    /**
+     * @brief Construit la description réseau d'un SoundPad
+     * @param board Board contenant le SoundPad
+     * @param pad SoundPad à décrire
+     * @return Données au format 'soundpad_added'
+     */
+    QJsonObject soundPadData(Board *board, SoundPad *pad) const;
+    
+    /**
+     * @brief Obtient la trame 'board_snapshot' du board principal
+     * @details La trame n'est encodée qu'une fois par révision du board et par codec,
+     *          puis réutilisée pour chaque client qui rejoint la room.
+     * @param codec Codec négocié avec le client
+     * @return Trame encodée contenant le board et la description de tous ses pads
+     */
+    QByteArray boardSnapshotFrame(RoomProtocol::Codec codec);
+    
+    /**
+     * @brief Indique si l'horloge commune est connue localement
+     * @return true pour l'hôte, ou pour un client ayant mesuré son écart avec l'hôte
+     */
+    bool isClockSynchronized() const;
+    
+    /**
+     * @brief Obtient l'heure actuelle dans l'horloge commune (celle de l'hôte)
+     * @return Instant en µs
+     */
+    qint64 roomTime() const;
+    
+    /**
+     * @brief Convertit un instant de l'horloge commune en instant local
+     * @param time Instant dans l'horloge commune (µs)
+     * @return Instant local (µs, LatencyMonitor::now() / 1000)
+     */
+    qint64 toLocalTime(qint64 time) const;
+    
+    /**
+     * @brief Calcule l'avance nécessaire pour que tous les participants jouent à temps
+     * @details L'hôte couvre le trajet vers chaque client (demi aller-retour et trois fois la
+     *          gigue) et sa sortie audio ; un client y ajoute son propre trajet vers l'hôte.
+     * @return Avance en µs, au plus MaxPlayLead
+     */
+    qint64 playbackLead() const;
+    
+    /**
+     * @brief Transmet au transport la latence de sortie et l'avance à annoncer aux pairs
      */
-    void confirmBoardsLoaded(const QJsonArray &boardIds, QTcpSocket *socket);
+    void updateClockInfo();
 };
 
 #endif // ROOM_H
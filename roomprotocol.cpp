@@ -0,0 +1,318 @@
+#include "roomprotocol.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QCborValue>
+#include <QCborMap>
+#include <QCborArray>
+#include <QHash>
+#include <iterator>
+#include <QtEndian>
+#include <QDebug>
+
+// Types de messages et clés connus, remplacés par leur index en CBOR.
+// Ne jamais renuméroter ni retirer d'entrée : ces valeurs font partie du protocole.
+static const char *const s_messageTypes[] = {
+    nullptr, "join", "welcome", "user_joined", "users_list", "user_disconnect", "disconnect",
+    "board_added", "board_snapshot", "soundpad_added", "soundpad_removed", "soundpad_modified",
+    "room_renamed", "asset_request", "asset_chunk", "asset_missing", "soundpad_play", "clock_ping",
+    "clock_pong"
+};
+
+static const char *const s_keys[] = {
+    nullptr, "board_id", "pad_id", "title", "file_path", "image_path", "can_duplicate_play",
+    "shortcut", "board_name", "pads", "revision", "username", "users", "name", "reason",
+    "id", "boardId", "filePath", "imagePath", "canDuplicatePlay", "protocol_version",
+    "codecs", "codec", "hash", "offset", "length", "total", "chunk", "file_hash", "file_size",
+    "image_hash", "image_size", "fileHash", "fileSize", "imageHash", "imageSize", "at", "t0", "t1",
+    "t2", "output_latency", "lead", "macro", "gain"
+};
+
+// Clé dont la valeur est du binaire encodé en base64 en JSON, transmis brut en CBOR
+static const char *const s_binaryKey = "chunk";
+
+// Clés de premier niveau d'un message CBOR
+static const int CborTypeKey = 0;
+static const int CborDataKey = 1;
+
+static QHash<QString, int> buildCodes(const char *const table[], int size)
+{
+    QHash<QString, int> codes;
+    for (int i = 1; i < size; ++i) {
+        codes.insert(QString::fromLatin1(table[i]), i);
+    }
+    return codes;
+}
+
+static const QHash<QString, int> &messageTypeCodes()
+{
+    static const QHash<QString, int> codes = buildCodes(s_messageTypes, int(std::size(s_messageTypes)));
+    return codes;
+}
+
+static const QHash<QString, int> &keyCodes()
+{
+    static const QHash<QString, int> codes = buildCodes(s_keys, int(std::size(s_keys)));
+    return codes;
+}
+
+static QCborValue toCbor(const QJsonValue &value);
+
+static QCborMap toCborMap(const QJsonObject &object)
+{
+    QCborMap map;
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        const int code = keyCodes().value(it.key(), 0);
+        const QCborValue value = it.key() == QLatin1String(s_binaryKey)
+            ? QCborValue(QByteArray::fromBase64(it.value().toString().toLatin1()))
+            : toCbor(it.value());
+        if (code) {
+            map.insert(code, value);
+        } else {
+            map.insert(it.key(), value);
+        }
+    }
+    return map;
+}
+
+static QCborValue toCbor(const QJsonValue &value)
+{
+    switch (value.type()) {
+        case QJsonValue::Object:
+            return toCborMap(value.toObject());
+        case QJsonValue::Array: {
+            QCborArray array;
+            for (const QJsonValue &item : value.toArray()) {
+                array.append(toCbor(item));
+            }
+            return array;
+        }
+        case QJsonValue::Double: {
+            // Les nombres entiers sont encodés sur le plus petit entier CBOR possible
+            // (hors de l'intervalle d'un qint64, la conversion serait indéfinie)
+            const double number = value.toDouble();
+            if (number >= -9223372036854775808.0 && number < 9223372036854775808.0) {
+                const qint64 integer = static_cast<qint64>(number);
+                if (static_cast<double>(integer) == number) {
+                    return QCborValue(integer);
+                }
+            }
+            return QCborValue(number);
+        }
+        default:
+            return QCborValue::fromJsonValue(value);
+    }
+}
+
+static QJsonValue fromCbor(const QCborValue &value);
+
+static QJsonObject fromCborMap(const QCborMap &map)
+{
+    QJsonObject object;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        QString key;
+        if (it.key().isInteger()) {
+            const qint64 code = it.key().toInteger();
+            if (code <= 0 || code >= qint64(std::size(s_keys))) {
+                qDebug() << "AVERTISSEMENT: Clé CBOR inconnue ignorée:" << code;
+                continue;
+            }
+            key = QString::fromLatin1(s_keys[code]);
+        } else {
+            key = it.key().toString();
+        }
+        object.insert(key, fromCbor(it.value()));
+    }
+    return object;
+}
+
+static QJsonValue fromCbor(const QCborValue &value)
+{
+    if (value.isMap()) {
+        return fromCborMap(value.toMap());
+    }
+    if (value.isArray()) {
+        QJsonArray array;
+        for (const QCborValue &item : value.toArray()) {
+            array.append(fromCbor(item));
+        }
+        return array;
+    }
+    if (value.isInteger()) {
+        return QJsonValue(value.toInteger());
+    }
+    if (value.isByteArray()) {
+        // Même représentation que dans un message JSON
+        return QString::fromLatin1(value.toByteArray().toBase64());
+    }
+    return value.toJsonValue();
+}
+
+QString RoomProtocol::codecName(Codec codec)
+{
+    return codec == CborCodec ? QStringLiteral("cbor") : QStringLiteral("json");
+}
+
+RoomProtocol::Codec RoomProtocol::negotiateCodec(const QStringList &codecs)
+{
+    return codecs.contains(codecName(CborCodec)) ? CborCodec : JsonCodec;
+}
+
+QStringList RoomProtocol::supportedCodecs()
+{
+    return { codecName(CborCodec), codecName(JsonCodec) };
+}
+
+QByteArray RoomProtocol::encodeMessage(const QString &type, const QJsonObject &data, Codec codec,
+                                       const QByteArray &binary)
+{
+    if (codec == CborCodec) {
+        QCborMap message;
+        const int typeCode = messageTypeCodes().value(type, 0);
+        if (typeCode) {
+            message.insert(CborTypeKey, typeCode);
+        } else {
+            message.insert(CborTypeKey, type);
+        }
+        QCborMap dataMap = toCborMap(data);
+        if (!binary.isEmpty()) {
+            dataMap.insert(keyCodes().value(QLatin1String(s_binaryKey)), binary);
+        }
+        message.insert(CborDataKey, dataMap);
+
+        return frame(QCborValue(message).toCbor());
+    }
+
+    QJsonObject message;
+    message["type"] = type;
+    if (binary.isEmpty()) {
+        message["data"] = data;
+    } else {
+        QJsonObject dataWithBinary = data;
+        dataWithBinary[s_binaryKey] = QString::fromLatin1(binary.toBase64());
+        message["data"] = dataWithBinary;
+    }
+
+    return frame(QJsonDocument(message).toJson(QJsonDocument::Compact));
+}
+
+QByteArray RoomProtocol::frame(const QByteArray &payload)
+{
+    QByteArray result;
+    result.reserve(HeaderSize + payload.size());
+
+    // En-tête: taille du contenu sur 4 octets big-endian
+    uchar header[HeaderSize];
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size()), header);
+    result.append(reinterpret_cast<const char*>(header), HeaderSize);
+    result.append(payload);
+
+    return result;
+}
+
+bool RoomProtocol::takeFrames(QByteArray &buffer, QList<QByteArray> &frames)
+{
+    qsizetype offset = 0;
+
+    // Extraire toutes les trames complètes présentes dans le tampon
+    while (buffer.size() - offset >= HeaderSize) {
+        const quint32 length = qFromBigEndian<quint32>(buffer.constData() + offset);
+
+        if (length > MaxFrameSize) {
+            qDebug() << "ERREUR: Taille de trame invalide:" << length << "octets";
+            return false;
+        }
+
+        // Trame incomplète: attendre la suite des données
+        if (buffer.size() - offset - HeaderSize < static_cast<qsizetype>(length)) {
+            break;
+        }
+
+        frames.append(buffer.mid(offset + HeaderSize, length));
+        offset += HeaderSize + length;
+    }
+
+    // Retirer en une seule fois les octets consommés
+    if (offset > 0) {
+        buffer.remove(0, offset);
+    }
+
+    return true;
+}
+
+bool RoomProtocol::decodeMessage(const QByteArray &payload, QString &type, QJsonObject &data,
+                                 QByteArray *binary)
+{
+    if (payload.isEmpty()) {
+        qDebug() << "AVERTISSEMENT: Trame reçue vide";
+        return false;
+    }
+
+    // Un contenu JSON commence toujours par '{', une table CBOR jamais
+    if (payload.at(0) != '{') {
+        QCborParserError parseError;
+        QCborValue message = QCborValue::fromCbor(payload, &parseError);
+
+        if (parseError.error != QCborError::NoError || !message.isMap()) {
+            qDebug() << "ERREUR: Impossible de parser les données CBOR:" << parseError.errorString();
+            return false;
+        }
+
+        QCborMap map = message.toMap();
+        QCborValue typeValue = map.value(CborTypeKey);
+        if (typeValue.isInteger()) {
+            const qint64 typeCode = typeValue.toInteger();
+            if (typeCode > 0 && typeCode < qint64(std::size(s_messageTypes))) {
+                type = QString::fromLatin1(s_messageTypes[typeCode]);
+            }
+        } else {
+            type = typeValue.toString();
+        }
+        QCborMap dataMap = map.value(CborDataKey).toMap();
+        if (binary) {
+            // Le contenu binaire est remis tel quel, sans détour par le base64
+            const int binaryCode = keyCodes().value(QLatin1String(s_binaryKey));
+            const QCborValue binaryValue = dataMap.value(binaryCode);
+            if (binaryValue.isByteArray()) {
+                *binary = binaryValue.toByteArray();
+                dataMap.remove(binaryCode);
+            }
+        }
+        data = fromCborMap(dataMap);
+
+        return !type.isEmpty();
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(payload, &parseError);
+
+    if (parseError.error != QJsonParseError::NoError) {
+        qDebug() << "ERREUR: Impossible de parser les données JSON:" << parseError.errorString();
+        return false;
+    }
+
+    if (!doc.isObject()) {
+        qDebug() << "ERREUR: Document JSON reçu n'est pas un objet";
+        return false;
+    }
+
+    QJsonObject message = doc.object();
+    type = message["type"].toString();
+    data = message["data"].toObject();
+    if (binary && data.contains(s_binaryKey)) {
+        *binary = QByteArray::fromBase64(data.take(s_binaryKey).toString().toLatin1());
+    }
+
+    return !type.isEmpty();
+}
+
+QString RoomProtocol::supersedeKey(const QString &type, const QJsonObject &data)
+{
+    if (type == "soundpad_modified") {
+        return type + "/" + data["boardId"].toString() + "/" + data["id"].toString();
+    }
+    if (type == "room_renamed") {
+        return type;
+    }
+
+    return QString();
+}
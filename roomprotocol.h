@@ -0,0 +1,114 @@
+#ifndef ROOMPROTOCOL_H
+#define ROOMPROTOCOL_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+
+/**
+ * @brief Format de trame utilisé sur les sockets TCP d'une Room
+ *
+ * Chaque message est précédé d'un en-tête de 4 octets (big-endian) contenant
+ * la taille du contenu qui suit. Le récepteur accumule les octets reçus dans un
+ * tampon propre à chaque socket et en extrait toutes les trames complètes, ce qui
+ * rend le protocole insensible au découpage ou à la fusion des lectures TCP.
+ *
+ * Le contenu d'une trame est soit un objet JSON compact, soit une table CBOR dont
+ * le type et les clés connus sont remplacés par de petits entiers. Le codec d'envoi
+ * est choisi lors du 'join' (champ 'codecs' du client, réponse 'welcome' de l'hôte) ;
+ * à la réception, le codec est reconnu au premier octet, ce qui permet de dialoguer
+ * avec un pair qui ne connaît que JSON.
+ *
+ * Un message peut porter un contenu binaire (champ 'chunk' des transferts de fichiers),
+ * passé à part des données : il est transmis brut en CBOR et n'est encodé en base64
+ * que dans une trame JSON.
+ */
+class RoomProtocol
+{
+public:
+    static const int HeaderSize = 4;                        ///< Taille de l'en-tête de longueur
+    static const quint32 MaxFrameSize = 16 * 1024 * 1024;   ///< Taille maximale d'une trame
+    static const int ProtocolVersion = 5;                   ///< Version annoncée dans le 'join'
+
+    /**
+     * @brief Encodage du contenu des trames
+     */
+    enum Codec {
+        JsonCodec,  ///< Objet JSON compact, compris par tous les pairs
+        CborCodec   ///< Table CBOR à clés entières
+    };
+
+    /**
+     * @brief Obtient le nom d'un codec tel qu'il est échangé lors du 'join'
+     * @param codec Codec
+     * @return Nom du codec ("json" ou "cbor")
+     */
+    static QString codecName(Codec codec);
+
+    /**
+     * @brief Choisit le meilleur codec parmi ceux annoncés par un pair
+     * @param codecs Noms des codecs supportés par le pair
+     * @return CborCodec si le pair le supporte, JsonCodec sinon
+     */
+    static Codec negotiateCodec(const QStringList &codecs);
+
+    /**
+     * @brief Obtient la liste des codecs supportés localement, par ordre de préférence
+     * @return Noms des codecs
+     */
+    static QStringList supportedCodecs();
+
+    /**
+     * @brief Encode un message et l'encadre pour l'envoi
+     * @param type Type de message
+     * @param data Données du message
+     * @param codec Encodage du contenu
+     * @param binary Contenu binaire du message (champ 'chunk'), vide si aucun
+     * @return Trame prête à être écrite sur le socket
+     */
+    static QByteArray encodeMessage(const QString &type, const QJsonObject &data, Codec codec = JsonCodec,
+                                    const QByteArray &binary = QByteArray());
+
+    /**
+     * @brief Ajoute l'en-tête de longueur devant un contenu
+     * @param payload Contenu de la trame
+     * @return Trame complète
+     */
+    static QByteArray frame(const QByteArray &payload);
+
+    /**
+     * @brief Extrait toutes les trames complètes d'un tampon de réception
+     * @details Les octets consommés sont retirés du tampon ; une trame incomplète
+     *          y reste jusqu'à la prochaine lecture.
+     * @param buffer Tampon de réception du socket
+     * @param frames Liste recevant le contenu des trames extraites
+     * @return false si le flux est corrompu (taille de trame invalide)
+     */
+    static bool takeFrames(QByteArray &buffer, QList<QByteArray> &frames);
+
+    /**
+     * @brief Décode le contenu d'une trame, quel que soit son codec
+     * @param payload Contenu de la trame
+     * @param type Reçoit le type du message
+     * @param data Reçoit les données du message
+     * @param binary Reçoit le contenu binaire du message, retiré des données (nullptr pour
+     *               le laisser dans les données, encodé en base64)
+     * @return true si le message est valide
+     */
+    static bool decodeMessage(const QByteArray &payload, QString &type, QJsonObject &data,
+                              QByteArray *binary = nullptr);
+
+    /**
+     * @brief Détermine si un message peut remplacer une version plus ancienne non encore envoyée
+     * @details Seuls les messages décrivant l'état complet d'un objet (ex: 'soundpad_modified')
+     *          peuvent être remplacés ; les autres doivent tous être livrés.
+     * @param type Type de message
+     * @param data Données du message
+     * @return Clé identifiant l'objet mis à jour, ou une chaîne vide
+     */
+    static QString supersedeKey(const QString &type, const QJsonObject &data);
+};
+
+#endif // ROOMPROTOCOL_H
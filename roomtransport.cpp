@@ -0,0 +1,647 @@
+#include "roomtransport.h"
+#include "roomprotocol.h"
+#include "assetstore.h"
+#include "latencymonitor.h"
+#include <QHostAddress>
+#include <QTimer>
+#include <QDebug>
+
+RoomTransport::RoomTransport(QObject *parent)
+    : QObject(parent)
+    , m_server(nullptr)
+    , m_nextPeerId(1)
+    , m_clockTimer(nullptr)
+    , m_outputLatency(0)
+    , m_lead(0)
+{
+    // Enfant du transport: suit moveToThread et ne démarre qu'avec le premier pair
+    m_clockTimer = new QTimer(this);
+    m_clockTimer->setInterval(ClockPingInterval);
+    connect(m_clockTimer, &QTimer::timeout, this, &RoomTransport::pingPeers);
+}
+
+RoomTransport::~RoomTransport()
+{
+    shutdown();
+}
+
+int RoomTransport::startServer(int port)
+{
+    // Fermer le serveur existant si nécessaire
+    if (m_server) {
+        qDebug() << "Serveur existant détecté, fermeture avant redémarrage";
+        m_server->close();
+        m_server->deleteLater();
+        m_server = nullptr;
+    }
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &RoomTransport::handleNewConnection);
+
+    // D'abord essayer Any (toutes les interfaces)
+    qDebug() << "Tentative de démarrage sur QHostAddress::Any";
+    bool serverStartSuccess = m_server->listen(QHostAddress::Any, port);
+
+    // Si ça ne fonctionne pas, essayer sur localhost
+    if (!serverStartSuccess) {
+        qDebug() << "Échec sur Any, tentative sur localhost";
+        serverStartSuccess = m_server->listen(QHostAddress::LocalHost, port);
+    }
+
+    if (!serverStartSuccess) {
+        qDebug() << "ERREUR critique lors du démarrage du serveur:" << m_server->errorString();
+        m_server->deleteLater();
+        m_server = nullptr;
+        return -1;
+    }
+
+    return m_server->serverPort();
+}
+
+void RoomTransport::stopServer()
+{
+    // Fermer toutes les connexions
+    for (auto it = m_peers.begin(); it != m_peers.end(); ++it) {
+        QObject::disconnect(it.value().socket, nullptr, this, nullptr);
+        it.value().socket->close();
+        it.value().socket->deleteLater();
+    }
+    m_peers.clear();
+    m_peerIds.clear();
+
+    if (m_server) {
+        m_server->close();
+    }
+}
+
+quint64 RoomTransport::connectToHost(const QString &address, int port)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+
+    connect(socket, &QTcpSocket::errorOccurred, this, [socket](QAbstractSocket::SocketError socketError) {
+        qDebug() << "Erreur de socket:" << socket->errorString()
+                 << "Code d'erreur:" << socketError;
+    });
+
+    qDebug() << "Tentative de connexion à" << address << ":" << port;
+    socket->connectToHost(address, port);
+
+    if (!socket->waitForConnected(3000)) {
+        qDebug() << "Échec de la connexion:" << socket->errorString();
+        socket->deleteLater();
+        return 0;
+    }
+
+    return addPeer(socket);
+}
+
+void RoomTransport::disconnectPeer(quint64 peerId)
+{
+    auto it = m_peers.find(peerId);
+    if (it != m_peers.end()) {
+        it.value().socket->disconnectFromHost();
+    }
+}
+
+void RoomTransport::sendMessage(quint64 peerId, const QString &type, const QJsonObject &data)
+{
+    auto it = m_peers.find(peerId);
+    if (it == m_peers.end()) {
+        qDebug() << "ERREUR: Tentative d'envoi de message à un pair inconnu:" << peerId;
+        return;
+    }
+
+    QByteArray frame = RoomProtocol::encodeMessage(type, data, it.value().codec);
+
+    qDebug() << "Envoi du message de type:" << type << "taille:" << frame.size() << "octets";
+    enqueueFrame(peerId, it.value(), frame, RoomProtocol::supersedeKey(type, data));
+}
+
+void RoomTransport::broadcastMessage(const QString &type, const QJsonObject &data, quint64 excludePeer)
+{
+    // Le message n'est encodé qu'une seule fois par codec pour tous les destinataires
+    QByteArray frames[2];
+    QString supersedeKey = RoomProtocol::supersedeKey(type, data);
+
+    qDebug() << "Broadcasting message type:" << type << "to" << m_peers.size() << "clients";
+
+    for (auto it = m_peers.begin(); it != m_peers.end(); ++it) {
+        // Ignorer le pair exclu (généralement l'expéditeur)
+        if (excludePeer && it.key() == excludePeer) {
+            continue;
+        }
+
+        QByteArray &frame = frames[it.value().codec];
+        if (frame.isEmpty()) {
+            frame = RoomProtocol::encodeMessage(type, data, it.value().codec);
+        }
+        enqueueFrame(it.key(), it.value(), frame, supersedeKey);
+    }
+}
+
+void RoomTransport::sendFrame(quint64 peerId, const QByteArray &frame)
+{
+    auto it = m_peers.find(peerId);
+    if (it == m_peers.end()) {
+        qDebug() << "ERREUR: Tentative d'envoi de trame à un pair inconnu:" << peerId;
+        return;
+    }
+
+    enqueueFrame(peerId, it.value(), frame);
+}
+
+void RoomTransport::setPeerCodec(quint64 peerId, RoomProtocol::Codec codec)
+{
+    auto it = m_peers.find(peerId);
+    if (it != m_peers.end()) {
+        qDebug() << "Codec" << RoomProtocol::codecName(codec) << "utilisé pour le pair" << peerId;
+        it.value().codec = codec;
+    }
+}
+
+void RoomTransport::setClockInfo(qint64 outputLatency, qint64 lead)
+{
+    m_outputLatency = outputLatency;
+    m_lead = lead;
+}
+
+void RoomTransport::shutdown()
+{
+    m_clockTimer->stop();
+
+    // Laisser partir les derniers messages (ex: 'disconnect') avant la fermeture
+    for (auto it = m_peers.begin(); it != m_peers.end(); ++it) {
+        QTcpSocket *socket = it.value().socket;
+        QObject::disconnect(socket, nullptr, this, nullptr);
+
+        if (socket->state() == QTcpSocket::ConnectedState && !it.value().dropped) {
+            for (const OutgoingFrame &pending : it.value().sendQueue) {
+                socket->write(pending.bytes);
+            }
+            for (const OutgoingFrame &pending : it.value().bulkQueue) {
+                socket->write(pending.bytes);
+            }
+        }
+        if (socket->state() == QTcpSocket::ConnectedState && socket->bytesToWrite() > 0) {
+            socket->waitForBytesWritten(500);
+        }
+        socket->abort();
+        delete socket;
+    }
+    m_peers.clear();
+    m_peerIds.clear();
+
+    if (m_server) {
+        m_server->close();
+        delete m_server;
+        m_server = nullptr;
+    }
+}
+
+void RoomTransport::handleNewConnection()
+{
+    while (m_server && m_server->hasPendingConnections()) {
+        QTcpSocket *socket = m_server->nextPendingConnection();
+
+        if (socket) {
+            // L'utilisateur sera correctement identifié quand il enverra ses infos
+            emit peerConnected(addPeer(socket));
+        }
+    }
+}
+
+void RoomTransport::handleDataReceived()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_peerIds.contains(socket)) {
+        qDebug() << "ERREUR: handleDataReceived appelé sans socket valide";
+        return;
+    }
+
+    const quint64 peerId = m_peerIds.value(socket);
+    Peer &peer = m_peers[peerId];
+    const qint64 received = clockTime();
+
+    // Accumuler les octets reçus dans le tampon propre à ce pair
+    peer.readBuffer.append(socket->readAll());
+
+    // Extraire toutes les trames complètes, une lecture peut en contenir plusieurs
+    QList<QByteArray> frames;
+    if (!RoomProtocol::takeFrames(peer.readBuffer, frames)) {
+        qDebug() << "ERREUR: Flux corrompu reçu du pair" << peerId << ", fermeture de la connexion";
+        peer.readBuffer.clear();
+        socket->abort();
+        return;
+    }
+
+    // Le décodage a lieu ici, la Room ne reçoit que des messages prêts à être traités
+    for (const QByteArray &payload : frames) {
+        QString messageType;
+        QJsonObject messageData;
+        QByteArray messageBinary;
+
+        if (!RoomProtocol::decodeMessage(payload, messageType, messageData, &messageBinary)) {
+            qDebug() << "Contenu reçu:" << payload;
+            continue;
+        }
+
+        // Les transferts de fichiers ne concernent pas l'interface
+        if (messageType.startsWith("asset_")) {
+            handleAssetMessage(peerId, messageType, messageData, messageBinary);
+            continue;
+        }
+        if (messageType.startsWith("clock_")) {
+            handleClockMessage(peerId, messageType, messageData, received);
+            continue;
+        }
+
+        emit messageReceived(peerId, messageType, messageData);
+    }
+}
+
+void RoomTransport::handleSocketDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_peerIds.contains(socket)) {
+        return;
+    }
+
+    const quint64 peerId = m_peerIds.take(socket);
+    m_peers.remove(peerId);
+    socket->deleteLater();
+
+    // Abandonner les téléchargements fournis par ce pair; le fichier partiel permettra de reprendre
+    const QStringList hashes = m_downloads.keys();
+    for (const QString &hash : hashes) {
+        if (m_downloads.value(hash).peerId == peerId) {
+            finishDownload(hash, false);
+        }
+    }
+
+    // Oublier ses demandes en attente
+    for (auto it = m_pendingRequests.begin(); it != m_pendingRequests.end(); ++it) {
+        it.value().removeIf([peerId](const PendingRequest &request) {
+            return request.peerId == peerId;
+        });
+    }
+
+    emit peerDisconnected(peerId);
+}
+
+quint64 RoomTransport::addPeer(QTcpSocket *socket)
+{
+    const quint64 peerId = m_nextPeerId++;
+
+    socket->setParent(this);
+    m_peers.insert(peerId, Peer(socket));
+    m_peerIds.insert(socket, peerId);
+
+    connect(socket, &QTcpSocket::readyRead, this, &RoomTransport::handleDataReceived);
+    connect(socket, &QTcpSocket::disconnected, this, &RoomTransport::handleSocketDisconnected);
+    connect(socket, &QTcpSocket::bytesWritten, this, &RoomTransport::handleBytesWritten);
+
+    // Première mesure d'horloge dès la connexion, puis à intervalle régulier
+    if (!m_clockTimer->isActive()) {
+        m_clockTimer->start();
+    }
+    QMetaObject::invokeMethod(this, [this, peerId]() {
+        QJsonObject pingData;
+        pingData["t0"] = clockTime();
+        writeClockMessage(peerId, "clock_ping", pingData);
+    }, Qt::QueuedConnection);
+
+    return peerId;
+}
+
+void RoomTransport::pingPeers()
+{
+    if (m_peers.isEmpty()) {
+        m_clockTimer->stop();
+        return;
+    }
+
+    const QList<quint64> peerIds = m_peers.keys();
+    for (quint64 peerId : peerIds) {
+        // Un ping attendrait derrière les octets en attente: sonder ce pair au prochain intervalle
+        Peer &peer = m_peers[peerId];
+        if (peer.socket->bytesToWrite() > 0 && peer.deferredPings < MaxDeferredPings) {
+            peer.deferredPings++;
+            continue;
+        }
+        peer.deferredPings = 0;
+
+        QJsonObject pingData;
+        pingData["t0"] = clockTime();
+        writeClockMessage(peerId, "clock_ping", pingData);
+    }
+}
+
+void RoomTransport::handleClockMessage(quint64 peerId, const QString &type, const QJsonObject &data, qint64 received)
+{
+    if (type == "clock_ping") {
+        // Répondre aussitôt: le temps passé ici est déduit du délai par t2 - t1
+        QJsonObject pongData;
+        pongData["t0"] = data["t0"].toInteger();
+        pongData["t1"] = received;
+        pongData["t2"] = clockTime();
+        writeClockMessage(peerId, "clock_pong", pongData);
+    }
+    else if (type == "clock_pong") {
+        emit clockSampled(peerId, data["t0"].toInteger(), data["t1"].toInteger(), data["t2"].toInteger(),
+                          received, data["output_latency"].toInteger(), data["lead"].toInteger());
+    }
+}
+
+void RoomTransport::writeClockMessage(quint64 peerId, const QString &type, const QJsonObject &data)
+{
+    auto it = m_peers.find(peerId);
+    if (it == m_peers.end()) {
+        return;
+    }
+
+    Peer &peer = it.value();
+    if (peer.dropped || peer.socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    QJsonObject clockData = data;
+    clockData["output_latency"] = m_outputLatency;
+    clockData["lead"] = m_lead;
+
+    // Trame complète écrite d'un bloc: elle ne peut pas s'intercaler dans une autre
+    peer.socket->write(RoomProtocol::encodeMessage(type, clockData, peer.codec));
+}
+
+qint64 RoomTransport::clockTime()
+{
+    return LatencyMonitor::now() / 1000;
+}
+
+void RoomTransport::handleBytesWritten()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_peerIds.contains(socket)) {
+        return;
+    }
+
+    // Reprendre l'envoi une fois le socket redescendu sous le seuil bas
+    const quint64 peerId = m_peerIds.value(socket);
+    const Peer &peer = m_peers[peerId];
+    const bool hasPending = !peer.sendQueue.isEmpty() || !peer.bulkQueue.isEmpty();
+    if (hasPending && !peer.flushScheduled && socket->bytesToWrite() <= LowWatermark) {
+        flushPeer(peerId);
+    }
+}
+
+void RoomTransport::enqueueFrame(quint64 peerId, Peer &peer, const QByteArray &frame,
+                                 const QString &supersedeKey, bool bulk)
+{
+    if (!peer.socket || peer.dropped || peer.socket->state() != QTcpSocket::ConnectedState) {
+        qDebug() << "ERREUR: Socket client invalide ou déconnecté";
+        return;
+    }
+
+    // Une mise à jour plus récente remplace celle qui n'a pas encore été envoyée
+    bool superseded = false;
+    if (!supersedeKey.isEmpty()) {
+        for (OutgoingFrame &pending : peer.sendQueue) {
+            if (pending.supersedeKey == supersedeKey) {
+                peer.queuedBytes += frame.size() - pending.bytes.size();
+                pending.bytes = frame;
+                superseded = true;
+                break;
+            }
+        }
+    }
+
+    if (!superseded) {
+        (bulk ? peer.bulkQueue : peer.sendQueue).append({frame, supersedeKey});
+        peer.queuedBytes += frame.size();
+    }
+
+    // Pair trop lent: le déconnecter plutôt que de laisser sa file grossir sans limite
+    if (peer.queuedBytes > MaxQueuedBytes) {
+        qDebug() << "ERREUR: File d'envoi du pair" << peerId << "saturée (" << peer.queuedBytes
+                 << "octets), déconnexion";
+        peer.dropped = true;
+        peer.sendQueue.clear();
+        peer.bulkQueue.clear();
+        peer.queuedBytes = 0;
+
+        // Différer la fermeture: elle retire le pair de m_peers, éventuellement en cours de parcours
+        QMetaObject::invokeMethod(peer.socket, &QTcpSocket::abort, Qt::QueuedConnection);
+        return;
+    }
+
+    // Regrouper toutes les trames émises pendant ce tour de boucle en une seule écriture
+    if (!peer.flushScheduled) {
+        peer.flushScheduled = true;
+        QMetaObject::invokeMethod(this, [this, peerId]() {
+            flushPeer(peerId);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void RoomTransport::flushPeer(quint64 peerId)
+{
+    auto it = m_peers.find(peerId);
+    if (it == m_peers.end()) {
+        return;
+    }
+
+    Peer &peer = it.value();
+    peer.flushScheduled = false;
+
+    if (peer.dropped || peer.socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    // Les trames de contrôle passent avant les portions de fichiers
+    auto nextQueue = [&peer]() -> QList<OutgoingFrame>& {
+        return !peer.sendQueue.isEmpty() ? peer.sendQueue : peer.bulkQueue;
+    };
+
+    // Écrire tant que le socket reste sous le seuil haut; la suite attendra bytesWritten
+    while (!nextQueue().isEmpty() && peer.socket->bytesToWrite() < HighWatermark) {
+        // Une grosse trame est écrite telle quelle, sans copie supplémentaire
+        if (nextQueue().first().bytes.size() >= CoalesceLimit) {
+            OutgoingFrame pending = nextQueue().takeFirst();
+            peer.queuedBytes -= pending.bytes.size();
+            peer.socket->write(pending.bytes);
+            continue;
+        }
+
+        // Les petites trames consécutives sont concaténées en une seule écriture
+        QByteArray chunk;
+        chunk.reserve(CoalesceLimit);
+        while (!nextQueue().isEmpty()
+               && chunk.size() + nextQueue().first().bytes.size() <= CoalesceLimit) {
+            OutgoingFrame pending = nextQueue().takeFirst();
+            peer.queuedBytes -= pending.bytes.size();
+            chunk.append(pending.bytes);
+        }
+        peer.socket->write(chunk);
+    }
+}
+
+void RoomTransport::fetchAsset(quint64 peerId, const QString &hash, const QString &suffix, qint64 size)
+{
+    AssetStore *store = AssetStore::instance();
+    if (!AssetStore::isValidHash(hash)) {
+        qDebug() << "ERREUR: Empreinte invalide, téléchargement refusé:" << hash;
+        return;
+    }
+    if (store->contains(hash) || m_downloads.contains(hash) || !m_peers.contains(peerId)) {
+        return;
+    }
+
+    // Reprendre après les octets déjà reçus lors d'une connexion précédente
+    Download download;
+    download.peerId = peerId;
+    download.suffix = suffix;
+    download.size = size;
+    download.requestedOffset = store->partialSize(hash);
+    download.inFlight = 0;
+
+    // Un fichier partiel plus grand que prévu est inutilisable
+    if (download.requestedOffset > size) {
+        store->discardPartial(hash);
+        download.requestedOffset = 0;
+    }
+
+    qDebug() << "Téléchargement du fichier" << hash << "auprès du pair" << peerId
+             << "(" << download.requestedOffset << "/" << size << "octets déjà présents)";
+
+    m_downloads.insert(hash, download);
+
+    if (download.requestedOffset >= size) {
+        finishDownload(hash, store->finalizeDownload(hash, suffix));
+        return;
+    }
+
+    requestNextChunks(hash);
+}
+
+void RoomTransport::handleAssetMessage(quint64 peerId, const QString &type, const QJsonObject &data,
+                                       const QByteArray &chunk)
+{
+    const QString hash = data["hash"].toString();
+    AssetStore *store = AssetStore::instance();
+
+    // L'empreinte sert de nom de fichier: un pair ne doit pas pouvoir y glisser un chemin
+    if (!AssetStore::isValidHash(hash)) {
+        qDebug() << "AVERTISSEMENT: Message" << type << "du pair" << peerId << "ignoré, empreinte invalide:" << hash;
+        return;
+    }
+
+    if (type == "asset_request") {
+        const qint64 offset = data["offset"].toInteger();
+        const qint64 length = qBound<qint64>(0, data["length"].toInteger(AssetChunkSize), AssetChunkSize);
+
+        if (store->contains(hash)) {
+            sendAssetChunk(peerId, hash, offset, length);
+        } else if (m_downloads.contains(hash)) {
+            // Nous sommes nous-mêmes en train de le recevoir: répondre dès qu'il sera complet
+            m_pendingRequests[hash].append({ peerId, offset, length });
+        } else {
+            QJsonObject missingData;
+            missingData["hash"] = hash;
+            sendMessage(peerId, "asset_missing", missingData);
+        }
+    }
+    else if (type == "asset_chunk") {
+        auto it = m_downloads.find(hash);
+        if (it == m_downloads.end() || it.value().peerId != peerId) {
+            return;
+        }
+
+        const qint64 offset = data["offset"].toInteger();
+
+        // Une portion vide ou courte avant la fin: le fichier est plus petit qu'annoncé
+        if (chunk.isEmpty() || (chunk.size() < AssetChunkSize && offset + chunk.size() < it.value().size)) {
+            qDebug() << "ERREUR: Fichier" << hash << "plus court que la taille annoncée ("
+                     << offset + chunk.size() << "/" << it.value().size << "octets)";
+            store->discardPartial(hash);
+            finishDownload(hash, false);
+            return;
+        }
+
+        if (!store->writeChunk(hash, offset, chunk)) {
+            finishDownload(hash, false);
+            return;
+        }
+
+        it.value().inFlight--;
+
+        if (offset + chunk.size() >= it.value().size) {
+            finishDownload(hash, store->finalizeDownload(hash, it.value().suffix));
+        } else {
+            requestNextChunks(hash);
+        }
+    }
+    else if (type == "asset_missing") {
+        if (m_downloads.contains(hash) && m_downloads.value(hash).peerId == peerId) {
+            qDebug() << "Le pair" << peerId << "ne possède pas le fichier" << hash;
+            finishDownload(hash, false);
+        }
+    }
+}
+
+void RoomTransport::sendAssetChunk(quint64 peerId, const QString &hash, qint64 offset, qint64 length)
+{
+    auto it = m_peers.find(peerId);
+    if (it == m_peers.end()) {
+        return;
+    }
+
+    const qint64 total = AssetStore::instance()->fileSize(hash);
+    const QByteArray chunk = AssetStore::instance()->readChunk(hash, offset, length);
+
+    QJsonObject chunkData;
+    chunkData["hash"] = hash;
+    chunkData["offset"] = offset;
+    chunkData["total"] = total;
+
+    // Les portions passent après les messages de contrôle déjà en file
+    enqueueFrame(peerId, it.value(), RoomProtocol::encodeMessage("asset_chunk", chunkData, it.value().codec, chunk),
+                 QString(), true);
+}
+
+void RoomTransport::requestNextChunks(const QString &hash)
+{
+    auto it = m_downloads.find(hash);
+    if (it == m_downloads.end()) {
+        return;
+    }
+
+    Download &download = it.value();
+    while (download.inFlight < AssetWindow && download.requestedOffset < download.size) {
+        QJsonObject requestData;
+        requestData["hash"] = hash;
+        requestData["offset"] = download.requestedOffset;
+        requestData["length"] = AssetChunkSize;
+        sendMessage(download.peerId, "asset_request", requestData);
+
+        download.requestedOffset += AssetChunkSize;
+        download.inFlight++;
+    }
+}
+
+void RoomTransport::finishDownload(const QString &hash, bool success)
+{
+    m_downloads.remove(hash);
+
+    // Répondre aux pairs qui attendaient ce fichier
+    const QList<PendingRequest> pending = m_pendingRequests.take(hash);
+    for (const PendingRequest &request : pending) {
+        if (success) {
+            sendAssetChunk(request.peerId, hash, request.offset, request.length);
+        } else {
+            QJsonObject missingData;
+            missingData["hash"] = hash;
+            sendMessage(request.peerId, "asset_missing", missingData);
+        }
+    }
+
+    emit assetTransferFinished(hash, success);
+}
@@ -0,0 +1,364 @@
+#ifndef ROOMTRANSPORT_H
+#define ROOMTRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "roomprotocol.h"
+
+class QTimer;
+
+/**
+ * @brief Couche réseau d'une Room, exécutée sur son propre thread
+ *
+ * Cette classe possède le serveur TCP et tous les sockets. Elle encode et décode
+ * les trames sur le thread d'entrées/sorties puis transmet à la Room des messages
+ * déjà décodés via des signaux (connexions en file d'attente). Chaque connexion est
+ * identifiée par un identifiant de pair, les sockets ne quittant jamais ce thread.
+ *
+ * Les envois passent par une file bornée propre à chaque pair : les trames émises
+ * pendant un même tour de boucle d'événements sont regroupées en une seule écriture,
+ * l'écriture est suspendue au-dessus de HighWatermark octets en attente dans le socket
+ * et reprend sous LowWatermark. Une mise à jour remplace la précédente encore en file
+ * pour le même objet ; si la file dépasse malgré tout MaxQueuedBytes, le pair est
+ * considéré comme trop lent et déconnecté. Cette limite dépasse la taille maximale
+ * d'une trame, si bien qu'une trame légitime passe toujours dans une file vide.
+ *
+ * Le transfert des fichiers (messages 'asset_*') est entièrement traité ici : les
+ * fichiers sont demandés par portions de AssetChunkSize octets, avec au plus
+ * AssetWindow portions en vol, et les portions sont envoyées dans une file de moindre
+ * priorité afin que les messages de contrôle passent toujours en premier.
+ *
+ * Les messages d'horloge ('clock_ping' / 'clock_pong') sont eux aussi traités ici,
+ * horodatés dès leur lecture et écrits directement dans le socket : ni la file d'envoi
+ * ni le thread de l'interface ne viennent fausser les instants mesurés. Chaque pair est
+ * sondé toutes les ClockPingInterval ms et chaque échange complet est remis à la Room
+ * (clockSampled()). Un message d'horloge attend toutefois derrière les octets déjà
+ * confiés au socket (jusqu'à HighWatermark) : le sondage d'un pair est donc reporté
+ * tant que son socket a encore des octets à écrire, au plus MaxDeferredPings fois de
+ * suite pour qu'un long transfert ne prive pas l'horloge de toute mesure. Un
+ * 'clock_pong' part malgré tout : son délai gonflé écarte l'échange de l'estimation.
+ */
+class RoomTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const qint64 HighWatermark = 256 * 1024;     ///< Suspension des écritures (octets en attente dans le socket)
+    static const qint64 LowWatermark = 64 * 1024;       ///< Reprise des écritures
+    static const qint64 CoalesceLimit = 64 * 1024;      ///< Taille maximale d'une écriture regroupée
+    static const qint64 MaxQueuedBytes = 2LL * RoomProtocol::MaxFrameSize; ///< Taille maximale de la file d'un pair
+    static const qint64 AssetChunkSize = 64 * 1024;     ///< Taille d'une portion de fichier transférée
+    static const int AssetWindow = 4;                   ///< Nombre de portions demandées à l'avance
+    static const int ClockPingInterval = 1000;          ///< Intervalle entre deux sondages d'horloge (ms)
+    static const int MaxDeferredPings = 5;              ///< Sondages reportés de suite avant d'envoyer malgré tout
+
+    static_assert(MaxQueuedBytes >= RoomProtocol::HeaderSize + qint64(RoomProtocol::MaxFrameSize),
+                  "La file d'un pair doit pouvoir contenir une trame de taille maximale");
+
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit RoomTransport(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructeur
+     */
+    ~RoomTransport();
+
+public slots:
+    /**
+     * @brief Démarre l'écoute des connexions entrantes
+     * @param port Port d'écoute souhaité
+     * @return Port effectivement utilisé, ou -1 en cas d'échec
+     */
+    int startServer(int port);
+
+    /**
+     * @brief Ferme toutes les connexions et arrête le serveur
+     */
+    void stopServer();
+
+    /**
+     * @brief Établit une connexion vers un hôte
+     * @param address Adresse de l'hôte
+     * @param port Port de l'hôte
+     * @return Identifiant du pair représentant l'hôte, ou 0 en cas d'échec
+     */
+    quint64 connectToHost(const QString &address, int port);
+
+    /**
+     * @brief Ferme proprement la connexion avec un pair
+     * @param peerId Identifiant du pair
+     */
+    void disconnectPeer(quint64 peerId);
+
+    /**
+     * @brief Envoie un message à un pair
+     * @param peerId Identifiant du pair
+     * @param type Type de message
+     * @param data Données du message
+     */
+    void sendMessage(quint64 peerId, const QString &type, const QJsonObject &data);
+
+    /**
+     * @brief Envoie un message à tous les pairs connectés
+     * @param type Type de message
+     * @param data Données du message
+     * @param excludePeer Pair à exclure de la diffusion (0 pour aucun)
+     */
+    void broadcastMessage(const QString &type, const QJsonObject &data, quint64 excludePeer = 0);
+
+    /**
+     * @brief Envoie une trame déjà encodée à un pair
+     * @param peerId Identifiant du pair
+     * @param frame Trame complète (en-tête de longueur inclus)
+     */
+    void sendFrame(quint64 peerId, const QByteArray &frame);
+
+    /**
+     * @brief Définit le codec utilisé pour les prochains messages envoyés à un pair
+     * @param peerId Identifiant du pair
+     * @param codec Codec négocié lors du 'join'
+     */
+    void setPeerCodec(quint64 peerId, RoomProtocol::Codec codec);
+
+    /**
+     * @brief Télécharge un fichier manquant auprès d'un pair
+     * @details Le téléchargement reprend à la fin d'un éventuel fichier partiel. Une
+     *          demande pour un fichier déjà en cours de téléchargement est ignorée.
+     * @param peerId Pair qui possède le fichier
+     * @param hash Empreinte du fichier
+     * @param suffix Extension du fichier d'origine
+     * @param size Taille totale du fichier
+     */
+    void fetchAsset(quint64 peerId, const QString &hash, const QString &suffix, qint64 size);
+
+    /**
+     * @brief Définit les informations de lecture synchronisée jointes aux messages d'horloge
+     * @param outputLatency Latence de la sortie audio locale (µs)
+     * @param lead Avance annoncée pour planifier une lecture (µs)
+     */
+    void setClockInfo(qint64 outputLatency, qint64 lead);
+
+    /**
+     * @brief Ferme toutes les connexions avant l'arrêt du thread
+     */
+    void shutdown();
+
+signals:
+    /**
+     * @brief Signal émis lorsqu'un client se connecte au serveur
+     * @param peerId Identifiant du nouveau pair
+     */
+    void peerConnected(quint64 peerId);
+
+    /**
+     * @brief Signal émis lorsqu'une connexion est fermée
+     * @param peerId Identifiant du pair déconnecté
+     */
+    void peerDisconnected(quint64 peerId);
+
+    /**
+     * @brief Signal émis pour chaque message complet reçu et décodé
+     * @param peerId Identifiant du pair émetteur
+     * @param type Type de message
+     * @param data Données du message
+     */
+    void messageReceived(quint64 peerId, const QString &type, const QJsonObject &data);
+
+    /**
+     * @brief Signal émis à la fin d'un téléchargement de fichier
+     * @param hash Empreinte du fichier
+     * @param success true si le fichier est maintenant disponible localement
+     */
+    void assetTransferFinished(const QString &hash, bool success);
+
+    /**
+     * @brief Signal émis pour chaque échange d'horloge complet avec un pair
+     * @details t0 et t3 sont dans l'horloge locale, t1 et t2 dans celle du pair (µs).
+     * @param peerId Identifiant du pair sondé
+     * @param t0 Envoi du ping
+     * @param t1 Réception du ping par le pair
+     * @param t2 Envoi du pong par le pair
+     * @param t3 Réception du pong
+     * @param outputLatency Latence de la sortie audio du pair (µs)
+     * @param lead Avance annoncée par le pair (µs)
+     */
+    void clockSampled(quint64 peerId, qint64 t0, qint64 t1, qint64 t2, qint64 t3,
+                      qint64 outputLatency, qint64 lead);
+
+private slots:
+    /**
+     * @brief Gère une nouvelle connexion entrante
+     */
+    void handleNewConnection();
+
+    /**
+     * @brief Gère la réception de données sur un socket
+     */
+    void handleDataReceived();
+
+    /**
+     * @brief Gère la fermeture d'un socket
+     */
+    void handleSocketDisconnected();
+
+    /**
+     * @brief Reprend les écritures lorsque le socket s'est vidé
+     */
+    void handleBytesWritten();
+
+    /**
+     * @brief Envoie un 'clock_ping' à chaque pair connecté
+     * @details Un pair dont le socket n'est pas vide est sondé à l'intervalle suivant, sauf
+     *          après MaxDeferredPings reports de suite.
+     */
+    void pingPeers();
+
+private:
+    /**
+     * @brief Trame en attente d'envoi
+     */
+    struct OutgoingFrame {
+        QByteArray bytes;       // Trame complète
+        QString supersedeKey;   // Clé de remplacement (vide si la trame ne peut pas être remplacée)
+    };
+
+    /**
+     * @brief Téléchargement de fichier en cours
+     */
+    struct Download {
+        quint64 peerId;         // Pair qui fournit le fichier
+        QString suffix;         // Extension du fichier d'origine
+        qint64 size;            // Taille totale attendue
+        qint64 requestedOffset; // Fin de la dernière portion demandée
+        int inFlight;           // Portions demandées mais pas encore reçues
+    };
+
+    /**
+     * @brief Demande de portion en attente de la fin d'un téléchargement local
+     */
+    struct PendingRequest {
+        quint64 peerId;         // Pair demandeur
+        qint64 offset;          // Position demandée
+        qint64 length;          // Taille demandée
+    };
+
+    /**
+     * @brief État d'une connexion
+     */
+    struct Peer {
+        QTcpSocket *socket;             // Socket de connexion
+        QByteArray readBuffer;          // Tampon de réassemblage des trames
+        QList<OutgoingFrame> sendQueue; // Trames de contrôle en attente d'écriture
+        QList<OutgoingFrame> bulkQueue; // Portions de fichiers, envoyées après les trames de contrôle
+        qint64 queuedBytes;             // Taille totale des deux files
+        bool flushScheduled;            // Une écriture regroupée est déjà programmée
+        bool dropped;                   // Pair déconnecté pour dépassement de file
+        int deferredPings;              // Sondages d'horloge reportés de suite (socket non vide)
+        RoomProtocol::Codec codec;      // Codec d'envoi négocié (JSON tant que rien n'est négocié)
+
+        Peer(QTcpSocket *sock = nullptr)
+            : socket(sock), queuedBytes(0), flushScheduled(false), dropped(false), deferredPings(0)
+            , codec(RoomProtocol::JsonCodec) {}
+    };
+
+    QTcpServer *m_server;                   // Serveur TCP (hôte uniquement)
+    QMap<quint64, Peer> m_peers;            // Connexions ouvertes par identifiant
+    QMap<QTcpSocket*, quint64> m_peerIds;   // Identifiant associé à chaque socket
+    quint64 m_nextPeerId;                   // Prochain identifiant attribué
+    QMap<QString, Download> m_downloads;    // Téléchargements en cours par empreinte
+    QMap<QString, QList<PendingRequest>> m_pendingRequests; // Demandes reçues pour des fichiers en cours de téléchargement
+    QTimer *m_clockTimer;                   // Sondage périodique des horloges
+    qint64 m_outputLatency;                 // Latence de sortie locale annoncée (µs)
+    qint64 m_lead;                          // Avance de planification annoncée (µs)
+
+    /**
+     * @brief Enregistre un socket connecté et connecte ses signaux
+     * @param socket Socket à enregistrer
+     * @return Identifiant attribué au pair
+     */
+    quint64 addPeer(QTcpSocket *socket);
+
+    /**
+     * @brief Place une trame dans la file d'envoi d'un pair
+     * @param peerId Identifiant du pair destinataire
+     * @param peer Pair destinataire
+     * @param frame Trame complète
+     * @param supersedeKey Clé de remplacement d'une trame plus ancienne encore en file
+     * @param bulk true pour une portion de fichier, envoyée après les trames de contrôle
+     */
+    void enqueueFrame(quint64 peerId, Peer &peer, const QByteArray &frame,
+                      const QString &supersedeKey = QString(), bool bulk = false);
+
+    /**
+     * @brief Écrit dans le socket autant de trames en file que le permet le seuil haut
+     * @param peerId Identifiant du pair
+     */
+    void flushPeer(quint64 peerId);
+
+    /**
+     * @brief Traite un message de transfert de fichier
+     * @param peerId Pair émetteur
+     * @param type Type de message ('asset_request', 'asset_chunk' ou 'asset_missing')
+     * @param data Données du message
+     * @param chunk Portion de fichier reçue ('asset_chunk'), brute
+     */
+    void handleAssetMessage(quint64 peerId, const QString &type, const QJsonObject &data,
+                            const QByteArray &chunk);
+
+    /**
+     * @brief Traite un message d'horloge
+     * @param peerId Pair émetteur
+     * @param type Type de message ('clock_ping' ou 'clock_pong')
+     * @param data Données du message
+     * @param received Lecture de la trame (µs, horloge locale)
+     */
+    void handleClockMessage(quint64 peerId, const QString &type, const QJsonObject &data, qint64 received);
+
+    /**
+     * @brief Écrit un message d'horloge sans passer par la file d'envoi
+     * @details Le message reste derrière les octets déjà écrits dans le socket.
+     * @param peerId Identifiant du pair
+     * @param type Type de message
+     * @param data Données du message
+     */
+    void writeClockMessage(quint64 peerId, const QString &type, const QJsonObject &data);
+
+    /**
+     * @brief Obtient l'heure de l'horloge locale utilisée pour la synchronisation
+     * @return LatencyMonitor::now() en µs
+     */
+    static qint64 clockTime();
+
+    /**
+     * @brief Envoie une portion de fichier disponible localement
+     * @param peerId Pair demandeur
+     * @param hash Empreinte du fichier
+     * @param offset Position demandée
+     * @param length Taille demandée
+     */
+    void sendAssetChunk(quint64 peerId, const QString &hash, qint64 offset, qint64 length);
+
+    /**
+     * @brief Demande les portions suivantes d'un téléchargement dans la limite de la fenêtre
+     * @param hash Empreinte du fichier
+     */
+    void requestNextChunks(const QString &hash);
+
+    /**
+     * @brief Termine un téléchargement et répond aux demandes qui l'attendaient
+     * @param hash Empreinte du fichier
+     * @param success true si le fichier est complet et vérifié
+     */
+    void finishDownload(const QString &hash, bool success);
+};
+
+#endif // ROOMTRANSPORT_H
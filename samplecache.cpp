@@ -0,0 +1,96 @@
+#include "samplecache.h"
+#include <QMutexLocker>
+#include <QDebug>
+
+SampleCache::SampleCache(qint64 budget)
+    : m_memoryUsage(0)
+    , m_budget(budget)
+    , m_useCounter(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+}
+
+std::shared_ptr<const AudioSample> SampleCache::lookup(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+
+    m_hits++;
+    it->lastUse = ++m_useCounter;
+    return it->sample;
+}
+
+bool SampleCache::contains(const QString &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(key);
+}
+
+QStringList SampleCache::insert(const QString &key, std::shared_ptr<const AudioSample> sample)
+{
+    QStringList evicted;
+    if (!sample) {
+        return evicted;
+    }
+
+    const qint64 bytes = sample->memoryUsage();
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_memoryUsage -= it->bytes;
+    }
+
+    m_entries.insert(key, { std::move(sample), ++m_useCounter, bytes });
+    m_memoryUsage += bytes;
+
+    // Le son ajouté va être joué: l'évincer aussitôt le ferait décoder à chaque lecture
+    evictLocked(evicted, key);
+    return evicted;
+}
+
+QStringList SampleCache::setBudget(qint64 budget)
+{
+    QStringList evicted;
+    QMutexLocker locker(&m_mutex);
+    m_budget = qMax<qint64>(0, budget);
+    evictLocked(evicted);
+    return evicted;
+}
+
+SampleCache::Stats SampleCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return { int(m_entries.size()), m_memoryUsage, m_budget, m_hits, m_misses, m_evictions };
+}
+
+void SampleCache::evictLocked(QStringList &evicted, const QString &keep)
+{
+    while (m_memoryUsage > m_budget) {
+        // Chercher le son utilisé le moins récemment
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it.key() != keep && (oldest == m_entries.end() || it->lastUse < oldest->lastUse)) {
+                oldest = it;
+            }
+        }
+
+        if (oldest == m_entries.end()) {
+            break;
+        }
+
+        qDebug() << "Éviction du son décodé" << oldest.key() << "(" << oldest->bytes << "octets)";
+
+        // Une voix qui joue encore ce son garde sa propre référence
+        evicted.append(oldest.key());
+        m_memoryUsage -= oldest->bytes;
+        m_entries.erase(oldest);
+        m_evictions++;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef SAMPLECACHE_H
+#define SAMPLECACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+#include <memory>
+#include "audiosample.h"
+
+/**
+ * @brief Cache mémoire des sons décodés, limité par un budget global
+ *
+ * Les sons sont indexés par le chemin de leur fichier. Lorsque la mémoire occupée
+ * dépasse le budget, les sons utilisés le moins récemment sont retirés du cache ;
+ * une voix en cours de lecture conserve sa propre référence et n'est pas interrompue.
+ *
+ * Le cache compte les succès et les échecs de lookup() pour vérifier qu'un board
+ * « chaud » se joue entièrement depuis la mémoire.
+ *
+ * Toutes les méthodes peuvent être appelées depuis n'importe quel thread.
+ */
+class SampleCache
+{
+public:
+    static const qint64 DefaultBudget = 512LL * 1024 * 1024; ///< Budget mémoire par défaut
+
+    /**
+     * @brief Statistiques d'utilisation du cache
+     */
+    struct Stats {
+        int samples;            // Nombre de sons en cache
+        qint64 memoryUsage;     // Mémoire occupée (octets)
+        qint64 budget;          // Budget mémoire (octets)
+        quint64 hits;           // Sons trouvés en cache
+        quint64 misses;         // Sons absents du cache
+        quint64 evictions;      // Sons retirés pour respecter le budget
+    };
+
+    /**
+     * @brief Constructeur
+     * @param budget Mémoire maximale occupée par les sons (octets)
+     */
+    explicit SampleCache(qint64 budget = DefaultBudget);
+
+    /**
+     * @brief Cherche un son et compte un succès ou un échec
+     * @param key Chemin du fichier audio
+     * @return Son décodé, ou nullptr s'il n'est pas en cache
+     */
+    std::shared_ptr<const AudioSample> lookup(const QString &key);
+
+    /**
+     * @brief Indique si un son est en cache, sans modifier les compteurs
+     * @param key Chemin du fichier audio
+     */
+    bool contains(const QString &key) const;
+
+    /**
+     * @brief Ajoute un son au cache, puis évince si nécessaire
+     * @details Le son ajouté n'est jamais évincé, quitte à dépasser le budget.
+     * @param key Chemin du fichier audio
+     * @param sample Son décodé
+     * @return Chemins des sons évincés
+     */
+    QStringList insert(const QString &key, std::shared_ptr<const AudioSample> sample);
+
+    /**
+     * @brief Définit le budget mémoire
+     * @param budget Mémoire maximale (octets)
+     * @return Chemins des sons évincés
+     */
+    QStringList setBudget(qint64 budget);
+
+    /**
+     * @brief Obtient les statistiques d'utilisation
+     * @return Statistiques courantes
+     */
+    Stats stats() const;
+
+private:
+    /**
+     * @brief Son en cache
+     */
+    struct Entry {
+        std::shared_ptr<const AudioSample> sample;  // Son décodé
+        quint64 lastUse;                            // Ordre du dernier accès
+        qint64 bytes;                               // Mémoire occupée
+    };
+
+    QHash<QString, Entry> m_entries;    // Sons par chemin
+    qint64 m_memoryUsage;               // Mémoire occupée
+    qint64 m_budget;                    // Budget mémoire
+    quint64 m_useCounter;               // Compteur d'accès, pour l'ordre LRU
+    quint64 m_hits;                     // Succès de lookup()
+    quint64 m_misses;                   // Échecs de lookup()
+    quint64 m_evictions;                // Sons évincés
+    mutable QMutex m_mutex;             // Protège le cache
+
+    /**
+     * @brief Retire les sons les moins récemment utilisés jusqu'à respecter le budget (verrou tenu)
+     * @param evicted Liste recevant les chemins des sons retirés
+     * @param keep Chemin du son à épargner (celui qui vient d'être ajouté)
+     */
+    void evictLocked(QStringList &evicted, const QString &keep = QString());
+};
+
+#endif // SAMPLECACHE_H
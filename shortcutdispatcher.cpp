@@ -0,0 +1,132 @@
+#include "shortcutdispatcher.h"
+#include "soundpad.h"
+#include "latencymonitor.h"
+#include <QApplication>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QTextEdit>
+#include <QPlainTextEdit>
+#include <QAbstractSpinBox>
+#include <QKeySequenceEdit>
+#include <QDebug>
+
+ShortcutDispatcher::ShortcutDispatcher(QWidget *scope)
+    : QObject(scope)
+    , m_scope(scope)
+{
+    qApp->installEventFilter(this);
+}
+
+ShortcutDispatcher::~ShortcutDispatcher()
+{
+    qApp->removeEventFilter(this);
+}
+
+SoundPad *ShortcutDispatcher::updatePad(SoundPad *pad)
+{
+    if (!pad) {
+        return nullptr;
+    }
+
+    const int key = keyFor(pad->getShortcut());
+    if (m_padKeys.contains(pad) && m_padKeys.value(pad) == key) {
+        return m_owners.value(key) == pad ? nullptr : m_owners.value(key);
+    }
+
+    // Un pad détruit sans passer par removePad() ne doit pas rester dans les tables
+    if (!m_padKeys.contains(pad)) {
+        connect(pad, &QObject::destroyed, this, [this](QObject *object) {
+            releaseKey(object);
+            m_padKeys.remove(object);
+        });
+    }
+
+    releaseKey(pad);
+    m_padKeys.insert(pad, key);
+    if (key == 0) {
+        return nullptr;
+    }
+
+    SoundPad *owner = m_owners.value(key);
+    if (owner) {
+        qDebug() << "AVERTISSEMENT: Raccourci" << pad->getShortcut().toString() << "déjà utilisé par le pad"
+                 << owner->getTitle() << ", inactif pour" << pad->getTitle();
+        emit conflictDetected(pad, owner, pad->getShortcut());
+        return owner;
+    }
+
+    m_owners.insert(key, pad);
+    return nullptr;
+}
+
+void ShortcutDispatcher::removePad(SoundPad *pad)
+{
+    releaseKey(pad);
+    m_padKeys.remove(pad);
+    disconnect(pad, &QObject::destroyed, this, nullptr);
+}
+
+bool ShortcutDispatcher::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_UNUSED(watched);
+
+    if (event->type() != QEvent::KeyPress) {
+        return false;
+    }
+
+    // Dater la touche dès sa réception, pour la mesure de latence
+    const qint64 inputTime = LatencyMonitor::now();
+
+    // Recherche en temps constant avant toute autre vérification
+    QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
+    const int key = keyEvent->keyCombination().toCombined() & ~int(Qt::KeypadModifier);
+    SoundPad *pad = m_owners.value(key);
+    if (!pad) {
+        return false;
+    }
+
+    // Laisser la touche à l'application hors du tableau visible ou pendant une saisie
+    if (!m_scope->isVisible() || QApplication::activeModalWidget() || QApplication::activePopupWidget()
+        || QApplication::activeWindow() != m_scope->window()) {
+        return false;
+    }
+    QWidget *focus = QApplication::focusWidget();
+    if (qobject_cast<QLineEdit*>(focus) || qobject_cast<QTextEdit*>(focus) || qobject_cast<QPlainTextEdit*>(focus)
+        || qobject_cast<QAbstractSpinBox*>(focus) || qobject_cast<QKeySequenceEdit*>(focus)) {
+        return false;
+    }
+
+    // Touche maintenue: ne pas redéclencher, mais ne pas la laisser au widget qui a le focus
+    if (!keyEvent->isAutoRepeat()) {
+        pad->play(inputTime);
+    }
+    return true;
+}
+
+int ShortcutDispatcher::keyFor(const QKeySequence &shortcut)
+{
+    if (shortcut.isEmpty()) {
+        return 0;
+    }
+    return shortcut[0].toCombined() & ~int(Qt::KeypadModifier);
+}
+
+void ShortcutDispatcher::releaseKey(QObject *pad)
+{
+    const int key = m_padKeys.value(pad, 0);
+    if (key == 0 || m_owners.value(key) != pad) {
+        return;
+    }
+
+    m_owners.remove(key);
+
+    // Confier la combinaison à un pad qui la réclamait
+    for (auto it = m_padKeys.cbegin(); it != m_padKeys.cend(); ++it) {
+        if (it.key() != pad && it.value() == key) {
+            m_owners.insert(key, static_cast<SoundPad*>(it.key()));
+            qDebug() << "Raccourci" << QKeySequence(key).toString() << "réattribué au pad"
+                     << static_cast<SoundPad*>(it.key())->getTitle();
+            break;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef SHORTCUTDISPATCHER_H
+#define SHORTCUTDISPATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QKeySequence>
+
+class QWidget;
+class SoundPad;
+
+/**
+ * @brief Répartiteur des raccourcis clavier des pads d'un tableau
+ *
+ * Le répartiteur est installé comme filtre d'événements de l'application : une touche
+ * déclenche son pad quel que soit le widget qui a le focus, sans parcourir les
+ * widgets. Les raccourcis sont indexés par combinaison de touches dans une table de
+ * hachage, si bien que le coût d'une touche ne dépend pas du nombre de pads.
+ *
+ * Seul le premier accord d'un raccourci est pris en compte. Un raccourci déjà utilisé
+ * par un autre pad du tableau est signalé par conflictDetected() et reste inactif
+ * jusqu'à ce que le pad qui l'utilise le libère.
+ *
+ * Les touches sont laissées à l'application lorsque le tableau est masqué (autre
+ * onglet), qu'une fenêtre modale ou un menu est ouvert, ou qu'un champ de saisie a le
+ * focus.
+ */
+class ShortcutDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructeur
+     * @param scope Widget du tableau: les raccourcis ne sont actifs que s'il est visible
+     */
+    explicit ShortcutDispatcher(QWidget *scope);
+    ~ShortcutDispatcher();
+
+    /**
+     * @brief Enregistre ou met à jour le raccourci d'un pad
+     * @param pad Pad dont le raccourci a changé
+     * @return Pad qui utilise déjà ce raccourci, ou nullptr s'il n'y a pas de conflit
+     */
+    SoundPad *updatePad(SoundPad *pad);
+
+    /**
+     * @brief Retire un pad ; un pad en conflit sur le même raccourci en prend possession
+     * @param pad Pad retiré
+     */
+    void removePad(SoundPad *pad);
+
+    /**
+     * @brief Obtient le pad déclenché par une combinaison de touches
+     * @param combination Touche et modificateurs (QKeyCombination::toCombined())
+     * @return Pad, ou nullptr si la combinaison n'est pas utilisée
+     */
+    SoundPad *padForKey(int combination) const { return m_owners.value(combination); }
+
+signals:
+    /**
+     * @brief Signal émis lorsqu'un pad reçoit un raccourci déjà utilisé
+     * @param pad Pad dont le raccourci est inactif
+     * @param owner Pad qui utilise déjà le raccourci
+     * @param shortcut Raccourci en conflit
+     */
+    void conflictDetected(SoundPad *pad, SoundPad *owner, const QKeySequence &shortcut);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QWidget *m_scope;                       // Widget du tableau
+    QHash<int, SoundPad*> m_owners;         // Pad actif par combinaison de touches
+    QHash<QObject*, int> m_padKeys;         // Combinaison voulue par chaque pad (conflits compris)
+
+    /**
+     * @brief Normalise le premier accord d'un raccourci
+     * @param shortcut Raccourci du pad
+     * @return Combinaison sans le modificateur du pavé numérique, ou 0 si le raccourci est vide
+     */
+    static int keyFor(const QKeySequence &shortcut);
+
+    /**
+     * @brief Libère la combinaison d'un pad et la confie à un pad en conflit s'il y en a un
+     * @param pad Pad qui libère sa combinaison
+     */
+    void releaseKey(QObject *pad);
+};
+
+#endif // SHORTCUTDISPATCHER_H
@@ -1,71 +1,56 @@
 #include "soundpad.h"
+#include "assetstore.h"
+#include "audioengine.h"
+#include "latencymonitor.h"
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
-#include <QDragEnterEvent>
-#include <QMimeData>
-#include <QKeyEvent>
 #include <QDialog>
 #include <QFormLayout>
+#include <QHBoxLayout>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QCheckBox>
 #include <QKeySequenceEdit>
 #include <QMenu>
+#include <QWidget>
+#include <QUuid>
 
 SoundPad::SoundPad(const QString &title, 
                    const QString &filePath,
                    const QString &imagePath,
                    bool canDuplicatePlay,
                    const QKeySequence &shortcut,
-                   QWidget *parent)
-    : QWidget(parent)
+                   QObject *parent)
+    : QObject(parent)
     , m_title(title)
     , m_filePath(filePath)
     , m_imagePath(imagePath)
     , m_canDuplicatePlay(canDuplicatePlay)
     , m_isPlaying(false)
+    , m_sharedPlayback(false)
     , m_shortcut(shortcut)
-    , m_button(nullptr)
-    , m_imageLabel(nullptr)
-    , m_titleLabel(nullptr)
-    , m_layout(nullptr)
-    , m_mediaPlayer(nullptr)
-    , m_audioOutput(nullptr)
 {
-    // Configuration de l'apparence et des comportements
-    setupUi();
+    // Les fichiers du stockage utilisés par ce pad ne doivent pas être évincés
+    AssetStore::instance()->retain(m_filePath);
+    AssetStore::instance()->retain(m_imagePath);
     
-    // Chargement de l'image si un chemin est spécifié
-    if (!m_imagePath.isEmpty()) {
-        m_image = QPixmap(m_imagePath);
-        updateUI();
-    }
-    
-    // Configuration du lecteur média
-    m_mediaPlayer = new QMediaPlayer(this);
-    m_audioOutput = new QAudioOutput(this);
-    m_mediaPlayer->setAudioOutput(m_audioOutput);
-    
-    if (!m_filePath.isEmpty()) {
-        m_mediaPlayer->setSource(QUrl::fromLocalFile(m_filePath));
-    }
-    
-    // Connexion du signal de fin de lecture
-    connect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, this, [this](QMediaPlayer::PlaybackState state) {
-        if (state == QMediaPlayer::StoppedState) {
-            m_isPlaying = false;
-            m_button->setStyleSheet(""); // Réinitialiser le style
-        }
-    });
+    updateUI();
     
-    // Accepter le glisser-déposer
-    setAcceptDrops(true);
+    // Décoder le son à l'avance pour que le premier déclenchement soit immédiat
+    AudioEngine::instance()->setPadSound(reinterpret_cast<quintptr>(this), m_filePath);
 }
 
 SoundPad::~SoundPad()
 {
-    delete m_mediaPlayer;
-    delete m_audioOutput;
+    AudioEngine::instance()->removePad(reinterpret_cast<quintptr>(this));
+    AssetStore::instance()->release(m_filePath);
+    AssetStore::instance()->release(m_imagePath);
+}
+
+QString SoundPad::createId()
+{
+    return QString("pad_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
 }
 
 void SoundPad::setTitle(const QString &title)
@@ -76,24 +61,18 @@ void SoundPad::setTitle(const QString &title)
 
 void SoundPad::setFilePath(const QString &filePath)
 {
+    AssetStore::instance()->retain(filePath);
+    AssetStore::instance()->release(m_filePath);
     m_filePath = filePath;
-    if (m_mediaPlayer) {
-        m_mediaPlayer->setSource(QUrl::fromLocalFile(m_filePath));
-    }
+    AudioEngine::instance()->setPadSound(reinterpret_cast<quintptr>(this), m_filePath);
+    updateUI();
 }
 
 void SoundPad::setImagePath(const QString &imagePath)
 {
+    AssetStore::instance()->retain(imagePath);
+    AssetStore::instance()->release(m_imagePath);
     m_imagePath = imagePath;
-    if (!m_imagePath.isEmpty()) {
-        m_image = QPixmap(m_imagePath);
-        updateUI();
-    }
-}
-
-void SoundPad::setImage(const QPixmap &image)
-{
-    m_image = image;
     updateUI();
 }
 
@@ -109,12 +88,16 @@ bool SoundPad::isPlaying() const
 
 void SoundPad::setShortcut(const QKeySequence &shortcut)
 {
-    m_shortcut = shortcut;
+    if (m_shortcut != shortcut) {
+        m_shortcut = shortcut;
+        updateUI();
+        emit shortcutChanged(this);
+    }
 }
 
 bool SoundPad::importSound()
 {
-    QString filePath = QFileDialog::getOpenFileName(this, 
+    QString filePath = QFileDialog::getOpenFileName(dialogParent(), 
         tr("Importer un son"), 
         QString(), 
         tr("Fichiers audio (*.mp3 *.wav *.ogg)"));
@@ -126,27 +109,76 @@ bool SoundPad::importSound()
     return false;
 }
 
-void SoundPad::play()
+void SoundPad::play(qint64 inputTime)
 {
-    if (m_filePath.isEmpty()) {
-        QMessageBox::warning(this, tr("Avertissement"), tr("Aucun fichier audio sélectionné."));
+    if (inputTime == 0) {
+        inputTime = LatencyMonitor::now();
+    }
+    
+    if (m_filePath.isEmpty() && !isMacro()) {
+        QMessageBox::warning(dialogParent(), tr("Avertissement"), tr("Aucun fichier audio sélectionné."));
         return;
     }
     
     if (m_canDuplicatePlay || !m_isPlaying) {
-        // Si on peut dupliquer la lecture ou si le son n'est pas déjà en cours de lecture
-        m_mediaPlayer->play();
-        m_isPlaying = true;
-        
-        // Indication visuelle que le pad est actif
-        m_button->setStyleSheet("background-color: rgba(0, 255, 0, 100);");
+        // Dans une room, c'est elle qui choisit l'instant commun à tous les participants
+        if (m_sharedPlayback) {
+            emit playRequested(this, inputTime);
+        } else {
+            playAt(0, inputTime);
+        }
+    }
+}
+
+void SoundPad::playAt(qint64 time, qint64 inputTime)
+{
+    // Les membres d'une macro sont connus du tableau, qui les joue ensemble
+    if (isMacro()) {
+        emit macroPlayed(this, time, inputTime);
+        return;
+    }
+    
+    if (m_filePath.isEmpty() || (!m_canDuplicatePlay && m_isPlaying)) {
+        return;
+    }
+    
+    // Un pad à lecture multiple superpose chaque déclenchement dans une nouvelle voix
+    const quintptr padKey = reinterpret_cast<quintptr>(this);
+    if (time == 0) {
+        AudioEngine::instance()->play(padKey, !m_canDuplicatePlay, 1.0f, 0.0f, inputTime);
+    } else {
+        AudioEngine::instance()->playAt(padKey, !m_canDuplicatePlay, time);
     }
+    showPlaying();
+}
+
+void SoundPad::showPlaying()
+{
+    m_isPlaying = true;
+    emit appearanceChanged(this);
+}
+
+void SoundPad::showStopped()
+{
+    m_isPlaying = false;
+    emit appearanceChanged(this);
+}
+
+void SoundPad::setMacro(const QVector<MacroMember> &macro)
+{
+    m_macro = macro;
+    updateUI();
+}
+
+void SoundPad::setSharedPlayback(bool shared)
+{
+    m_sharedPlayback = shared;
 }
 
 void SoundPad::editMetadata()
 {
     // Création d'une boîte de dialogue pour l'édition des métadonnées
-    QDialog dialog(this);
+    QDialog dialog(dialogParent());
     dialog.setWindowTitle(tr("Configurer le SoundPad"));
     
     QFormLayout formLayout(&dialog);
@@ -182,8 +214,8 @@ void SoundPad::editMetadata()
     formLayout.addRow(&buttonsLayout);
     
     // Connexion des signaux
-    connect(&importSoundButton, &QPushButton::clicked, this, [&filePathEdit, this]() {
-        QString filePath = QFileDialog::getOpenFileName(this, 
+    connect(&importSoundButton, &QPushButton::clicked, this, [&filePathEdit, &dialog]() {
+        QString filePath = QFileDialog::getOpenFileName(&dialog, 
             tr("Importer un son"), 
             QString(), 
             tr("Fichiers audio (*.mp3 *.wav *.ogg)"));
@@ -193,8 +225,8 @@ void SoundPad::editMetadata()
         }
     });
     
-    connect(&importImageButton, &QPushButton::clicked, this, [&imagePathEdit, this]() {
-        QString imagePath = QFileDialog::getOpenFileName(this, 
+    connect(&importImageButton, &QPushButton::clicked, this, [&imagePathEdit, &dialog]() {
+        QString imagePath = QFileDialog::getOpenFileName(&dialog, 
             tr("Importer une image"), 
             QString(), 
             tr("Images (*.png *.jpg *.jpeg *.bmp)"));
@@ -217,10 +249,14 @@ void SoundPad::editMetadata()
             hasChanges = true;
         }
         if (m_filePath != filePathEdit.text()) {
+            AssetStore::instance()->retain(filePathEdit.text());
+            AssetStore::instance()->release(m_filePath);
             m_filePath = filePathEdit.text();
             hasChanges = true;
         }
         if (m_imagePath != imagePathEdit.text()) {
+            AssetStore::instance()->retain(imagePathEdit.text());
+            AssetStore::instance()->release(m_imagePath);
             m_imagePath = imagePathEdit.text();
             hasChanges = true;
         }
@@ -228,24 +264,22 @@ void SoundPad::editMetadata()
             m_canDuplicatePlay = duplicateCheckBox.isChecked();
             hasChanges = true;
         }
-        if (m_shortcut != shortcutEdit.keySequence()) {
+        const bool shortcutModified = m_shortcut != shortcutEdit.keySequence();
+        if (shortcutModified) {
             m_shortcut = shortcutEdit.keySequence();
             hasChanges = true;
         }
         
-        // Chargement de l'image et du son
-        if (!m_imagePath.isEmpty()) {
-            m_image = QPixmap(m_imagePath);
-        }
-        
-        if (!m_filePath.isEmpty()) {
-            m_mediaPlayer->setSource(QUrl::fromLocalFile(m_filePath));
-        }
+        // Chargement du son
+        AudioEngine::instance()->setPadSound(reinterpret_cast<quintptr>(this), m_filePath);
         
         // Mise à jour de l'interface
         updateUI();
         
         // Émission des signaux de modification
+        if (shortcutModified) {
+            emit shortcutChanged(this);
+        }
         if (hasChanges) {
             emit metadataChanged();
             emit soundPadModified(this);
@@ -253,136 +287,62 @@ void SoundPad::editMetadata()
     }
 }
 
-bool SoundPad::dragAndDrop()
-{
-    // Cette fonction n'est pas directement utilisée, mais fait partie de l'interface
-    // L'implémentation est réalisée via les événements dragEnterEvent et dropEvent
-    return true;
-}
-
-void SoundPad::keyPressEvent(QKeyEvent *event)
-{
-    // Vérifier si la touche appuyée correspond au raccourci
-    if (!m_shortcut.isEmpty() && event->keyCombination().toCombined() == m_shortcut[0].toCombined()) {
-        play();
-        event->accept();
-    } else {
-        QWidget::keyPressEvent(event);
-    }
-}
-
-void SoundPad::dragEnterEvent(QDragEnterEvent *event)
+void SoundPad::importFile(const QString &filePath)
 {
-    // Vérification que les données contiennent des URLs
-    if (event->mimeData()->hasUrls()) {
-        event->acceptProposedAction();
-    }
-}
-
-void SoundPad::dropEvent(QDropEvent *event)
-{
-    const QMimeData *mimeData = event->mimeData();
+    // Vérifier si c'est un fichier audio ou une image
+    QFileInfo fileInfo(filePath);
+    QString suffix = fileInfo.suffix().toLower();
     
-    if (mimeData->hasUrls()) {
-        QList<QUrl> urlList = mimeData->urls();
-        
-        // On ne traite que le premier fichier déposé
-        if (!urlList.isEmpty()) {
-            QString filePath = urlList.first().toLocalFile();
-            
-            // Vérifier si c'est un fichier audio ou une image
-            QFileInfo fileInfo(filePath);
-            QString suffix = fileInfo.suffix().toLower();
-            
-            if (suffix == "mp3" || suffix == "wav" || suffix == "ogg") {
-                setFilePath(filePath);
-                QMessageBox::information(this, tr("Fichier importé"), 
-                    tr("Le fichier audio a été importé avec succès."));
-            } else if (suffix == "png" || suffix == "jpg" || suffix == "jpeg" || suffix == "bmp") {
-                setImagePath(filePath);
-                QMessageBox::information(this, tr("Image importée"), 
-                    tr("L'image a été importée avec succès."));
-            } else {
-                QMessageBox::warning(this, tr("Format non supporté"), 
-                    tr("Le fichier déposé n'est ni un fichier audio ni une image supportée."));
-            }
-        }
+    if (suffix == "mp3" || suffix == "wav" || suffix == "ogg") {
+        setFilePath(filePath);
+        QMessageBox::information(dialogParent(), tr("Fichier importé"), 
+            tr("Le fichier audio a été importé avec succès."));
+    } else if (suffix == "png" || suffix == "jpg" || suffix == "jpeg" || suffix == "bmp") {
+        setImagePath(filePath);
+        QMessageBox::information(dialogParent(), tr("Image importée"), 
+            tr("L'image a été importée avec succès."));
+    } else {
+        QMessageBox::warning(dialogParent(), tr("Format non supporté"), 
+            tr("Le fichier déposé n'est ni un fichier audio ni une image supportée."));
     }
-    
-    event->acceptProposedAction();
 }
 
-void SoundPad::setupUi()
+void SoundPad::showContextMenu(const QPoint &globalPos)
 {
-    // Configuration du layout principal
-    m_layout = new QVBoxLayout(this);
-    m_layout->setContentsMargins(2, 2, 2, 2);
-    m_layout->setSpacing(2);
-    
-    // Création des éléments UI
-    m_button = new QPushButton(this);
-    m_button->setMinimumSize(100, 100);
-    m_button->setMaximumSize(150, 150);
-    m_button->setCursor(Qt::PointingHandCursor);
-    
-    m_imageLabel = new QLabel(this);
-    m_imageLabel->setAlignment(Qt::AlignCenter);
-    m_imageLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    
-    m_titleLabel = new QLabel(m_title, this);
-    m_titleLabel->setAlignment(Qt::AlignCenter);
+    QMenu *contextMenu = new QMenu(dialogParent());
     
-    // Organisation du layout
-    m_layout->addWidget(m_imageLabel);
-    m_layout->addWidget(m_titleLabel);
+    QAction *playAction = new QAction(tr("Jouer"), contextMenu);
+    QAction *editAction = new QAction(tr("Configurer"), contextMenu);
+    QAction *macroAction = new QAction(tr("Macro..."), contextMenu);
     
-    // Configuration du bouton
-    m_button->setLayout(m_layout);
-    
-    // Connexion du signal de clic
-    connect(m_button, &QPushButton::clicked, this, &SoundPad::play);
-    
-    // Configuration du menu contextuel
-    setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(this, &QWidget::customContextMenuRequested, this, [this](const QPoint &pos) {
-        QMenu *contextMenu = new QMenu(this);
-        
-        QAction *playAction = new QAction(tr("Jouer"), this);
-        QAction *editAction = new QAction(tr("Configurer"), this);
-        
-        connect(playAction, &QAction::triggered, this, &SoundPad::play);
-        connect(editAction, &QAction::triggered, this, &SoundPad::editMetadata);
-        
-        contextMenu->addAction(playAction);
-        contextMenu->addAction(editAction);
-        
-        contextMenu->exec(mapToGlobal(pos));
-        delete contextMenu; // Libérer la mémoire après utilisation
+    connect(playAction, &QAction::triggered, this, &SoundPad::play);
+    connect(editAction, &QAction::triggered, this, &SoundPad::editMetadata);
+    connect(macroAction, &QAction::triggered, this, [this]() {
+        emit macroEditRequested(this);
     });
     
-    // Mise à jour initiale de l'UI
-    updateUI();
+    contextMenu->addAction(playAction);
+    contextMenu->addAction(editAction);
+    contextMenu->addAction(macroAction);
+    
+    contextMenu->exec(globalPos);
+    delete contextMenu; // Libérer la mémoire après utilisation
 }
 
 void SoundPad::updateUI()
 {
-    // Mise à jour de l'image
-    if (!m_image.isNull()) {
-        QPixmap scaledImage = m_image.scaled(m_imageLabel->size(), 
-                                           Qt::KeepAspectRatio, 
-                                           Qt::SmoothTransformation);
-        m_imageLabel->setPixmap(scaledImage);
-    } else {
-        // Image par défaut si aucune n'est spécifiée
-        m_imageLabel->setText(tr("Aucune image"));
-    }
-    
-    // Mise à jour du titre
-    m_titleLabel->setText(m_title.isEmpty() ? tr("Sans titre") : m_title);
-    
     // Tooltip avec les informations du pad
-    setToolTip(QString("%1\nFichier: %2\nRaccourci: %3")
-               .arg(m_title)
-               .arg(m_filePath.isEmpty() ? tr("Non défini") : m_filePath)
-               .arg(m_shortcut.isEmpty() ? tr("Non défini") : m_shortcut.toString()));
+    const QString sound = isMacro() ? tr("Macro de %n pad(s)", nullptr, int(m_macro.size()))
+                                    : (m_filePath.isEmpty() ? tr("Non défini") : m_filePath);
+    m_toolTip = QString("%1\nFichier: %2\nRaccourci: %3")
+                .arg(m_title)
+                .arg(sound)
+                .arg(m_shortcut.isEmpty() ? tr("Non défini") : m_shortcut.toString());
+    
+    emit appearanceChanged(this);
+}
+
+QWidget *SoundPad::dialogParent() const
+{
+    return qobject_cast<QWidget*>(parent());
 }
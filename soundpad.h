@@ -1,24 +1,43 @@
 #ifndef SOUNDPAD_H
 #define SOUNDPAD_H
 
+#include <QObject>
 #include <QString>
-#include <QPixmap>
 #include <QKeySequence>
-#include <QWidget>
-#include <QPushButton>
-#include <QLabel>
-#include <QVBoxLayout>
-#include <QAudioOutput>
-#include <QMediaPlayer>
+#include <QPoint>
+#include <QVector>
+
+class QWidget;
 
 /**
  * @brief Classe représentant un pad sonore pouvant jouer un son avec une image associée
+ *
+ * Le pad ne possède aucun lecteur audio : la lecture est confiée à l'AudioEngine
+ * partagé, qui décode le son en arrière-plan dès que le fichier est connu.
+ *
+ * Il ne se dessine pas non plus et n'est pas un widget : le tableau l'affiche dans une
+ * vue unique (PadModel et PadDelegate), qui lui transmet clics, menu contextuel et
+ * fichiers déposés, et que le pad prévient par appearanceChanged(). Ses fenêtres de
+ * configuration et ses messages s'ouvrent au-dessus du tableau qui le possède.
+ *
+ * Un pad peut aussi être une macro : au lieu de son propre son, il joue un groupe
+ * d'autres pads du tableau, chacun avec son décalage et son gain. Le tableau résout les
+ * membres et les confie ensemble à l'AudioEngine (macroPlayed()).
  */
-class SoundPad : public QWidget
+class SoundPad : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * @brief Pad joué par une macro
+     */
+    struct MacroMember {
+        QString padId;          ///< Identifiant du pad dans le tableau
+        int offset = 0;         ///< Décalage après le déclenchement de la macro (ms)
+        double gain = 1.0;      ///< Gain linéaire appliqué au pad
+    };
+
     /**
      * @brief Constructeur de SoundPad
      * @param title Titre du pad
@@ -26,17 +45,23 @@ public:
      * @param imagePath Chemin vers l'image (optionnel)
      * @param canDuplicatePlay Si true, peut jouer plusieurs fois simultanément
      * @param shortcut Raccourci clavier (optionnel)
-     * @param parent Widget parent
+     * @param parent Objet parent, normalement le tableau du pad
      */
     explicit SoundPad(const QString &title = "", 
                       const QString &filePath = "",
                       const QString &imagePath = "",
                       bool canDuplicatePlay = false,
                       const QKeySequence &shortcut = QKeySequence(),
-                      QWidget *parent = nullptr);
+                      QObject *parent = nullptr);
     
     ~SoundPad();
 
+    /**
+     * @brief Génère un identifiant de pad unique, y compris entre participants d'une room
+     * @return Identifiant de la forme "pad_<uuid>"
+     */
+    static QString createId();
+
     // Getters et setters
     QString getTitle() const { return m_title; }
     void setTitle(const QString &title);
@@ -47,16 +72,30 @@ public:
     QString getImagePath() const { return m_imagePath; }
     void setImagePath(const QString &imagePath);
     
-    QPixmap getImage() const { return m_image; }
-    void setImage(const QPixmap &image);
-    
     bool getCanDuplicatePlay() const { return m_canDuplicatePlay; }
     void setCanDuplicatePlay(bool canDuplicatePlay);
     
     bool isPlaying() const;
     
+    QString toolTip() const { return m_toolTip; }
+    
     QKeySequence getShortcut() const { return m_shortcut; }
     void setShortcut(const QKeySequence &shortcut);
+    
+    QVector<MacroMember> getMacro() const { return m_macro; }
+    void setMacro(const QVector<MacroMember> &macro);
+    bool isMacro() const { return !m_macro.isEmpty(); }
+    
+    /**
+     * @brief Affiche le pad comme actif, jusqu'à la fin de sa lecture
+     * @details Appelé lorsque son son est lancé par le pad lui-même ou par une macro.
+     */
+    void showPlaying();
+    
+    /**
+     * @brief Affiche le pad comme inactif, à la fin de la lecture de son son
+     */
+    void showStopped();
 
 public slots:
     /**
@@ -67,13 +106,44 @@ public slots:
     
     /**
      * @brief Joue le son associé au pad
+     * @param inputTime Réception du clic ou de la touche (LatencyMonitor::now()), pour la
+     *                  mesure de latence ; 0 pour dater l'appel lui-même
+     */
+    void play(qint64 inputTime = 0);
+    
+    /**
+     * @brief Joue le son du pad à un instant précis, sans passer par la room
+     * @details Utilisé pour les déclenchements planifiés par la room, locaux ou distants.
+     * @param time Instant où le son doit être entendu (LatencyMonitor::now()) ; 0 pour
+     *             jouer tout de suite
+     * @param inputTime Réception du clic ou de la touche, pour la mesure de latence d'un
+     *                  son joué tout de suite ; 0 si non mesuré
+     */
+    void playAt(qint64 time, qint64 inputTime = 0);
+    
+    /**
+     * @brief Confie les déclenchements locaux à la room plutôt que de les jouer directement
+     * @param shared Si true, play() émet playRequested() au lieu de jouer le son
      */
-    void play();
+    void setSharedPlayback(bool shared);
     
     /**
      * @brief Ouvre une fenêtre pour éditer les métadonnées
      */
     void editMetadata();
+    
+    /**
+     * @brief Ouvre le menu contextuel du pad
+     * @param globalPos Position du menu à l'écran
+     */
+    void showContextMenu(const QPoint &globalPos);
+    
+    /**
+     * @brief Importe un fichier déposé sur le pad
+     * @details Un son remplace celui du pad, une image remplace son image.
+     * @param filePath Chemin du fichier déposé
+     */
+    void importFile(const QString &filePath);
 
 signals:
     /**
@@ -87,49 +157,58 @@ signals:
      */
     void soundPadModified(SoundPad* pad);
 
-protected:
     /**
-     * @brief Gère les événements de glisser-déposer
+     * @brief Signal émis lorsque le raccourci clavier du pad change
+     * @param pad Le SoundPad modifié
      */
-    bool dragAndDrop();
-    
+    void shortcutChanged(SoundPad* pad);
+
     /**
-     * @brief Capte les événements clavier pour les raccourcis
+     * @brief Signal émis par play() lorsque la lecture est partagée (setSharedPlayback())
+     * @param pad Le SoundPad déclenché
+     * @param inputTime Réception du clic ou de la touche (LatencyMonitor::now())
      */
-    void keyPressEvent(QKeyEvent *event) override;
-    
+    void playRequested(SoundPad* pad, qint64 inputTime);
+
     /**
-     * @brief Traite les événements de glisser-déposer
+     * @brief Signal émis lorsqu'une macro doit jouer ses membres
+     * @param pad La macro déclenchée
+     * @param time Instant où les membres doivent être entendus (LatencyMonitor::now()), 0 pour tout de suite
+     * @param inputTime Réception du clic ou de la touche, 0 si non mesuré
      */
-    void dragEnterEvent(QDragEnterEvent *event) override;
-    void dropEvent(QDropEvent *event) override;
+    void macroPlayed(SoundPad* pad, qint64 time, qint64 inputTime);
+
+    /**
+     * @brief Signal émis lorsque l'utilisateur demande à modifier la macro du pad
+     * @param pad Le SoundPad concerné
+     */
+    void macroEditRequested(SoundPad* pad);
+
+    /**
+     * @brief Signal émis lorsque le pad doit être redessiné (titre, image, son ou lecture)
+     * @param pad Le SoundPad concerné
+     */
+    void appearanceChanged(SoundPad* pad);
 
 private:
     QString m_title;          // Titre du pad
     QString m_filePath;       // Chemin vers le fichier audio
     QString m_imagePath;      // Chemin vers l'image
-    QPixmap m_image;          // Image associée
     bool m_canDuplicatePlay;  // Si true, peut jouer plusieurs fois simultanément 
     bool m_isPlaying;         // Indique si le son est en cours de lecture
+    bool m_sharedPlayback;    // Déclenchements confiés à la room (playRequested)
     QKeySequence m_shortcut;  // Raccourci clavier associé
-
-    // Éléments UI
-    QPushButton *m_button;    // Bouton principal du pad
-    QLabel *m_imageLabel;     // Label pour afficher l'image
-    QLabel *m_titleLabel;     // Label pour afficher le titre
-    QVBoxLayout *m_layout;    // Layout principal
-
-    // Lecteur audio
-    QMediaPlayer *m_mediaPlayer;
-    QAudioOutput *m_audioOutput;
+    QVector<MacroMember> m_macro; // Pads joués par la macro (vide: pad ordinaire)
+    QString m_toolTip;        // Infobulle affichée par la vue du tableau
 
     /**
-     * @brief Configure l'apparence du SoundPad
+     * @brief Obtient le widget au-dessus duquel ouvrir les fenêtres du pad
+     * @return Tableau parent, ou nullptr si le pad n'a pas de parent graphique
      */
-    void setupUi();
-    
+    QWidget *dialogParent() const;
+
     /**
-     * @brief Met à jour l'apparence en fonction des propriétés
+     * @brief Met à jour l'infobulle et demande à la vue de redessiner le pad
      */
     void updateUI();
 };
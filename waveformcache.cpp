@@ -0,0 +1,160 @@
+#include "waveformcache.h"
+#include "assetstore.h"
+#include "audioengine.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QAudioBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+#include <QMutexLocker>
+#include <QDebug>
+
+WaveformCache *WaveformCache::instance()
+{
+    static WaveformCache *cache = new WaveformCache();
+    return cache;
+}
+
+WaveformCache::WaveformCache(QObject *parent)
+    : QObject(parent)
+    , m_pool(nullptr)
+    , m_stopping(false)
+{
+    // À côté du dossier du stockage, qui prendrait ces fichiers pour des sons
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/peaks";
+    QDir().mkpath(m_directory);
+
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(1);
+    m_pool->setThreadPriority(QThread::LowestPriority);
+
+    // Préparer la forme d'onde des sons importés ou reçus d'une room
+    connect(AssetStore::instance(), &AssetStore::assetAdded, this, [this](const QString &hash) {
+        const QString path = AssetStore::instance()->filePath(hash);
+        const QString suffix = QFileInfo(path).suffix();
+        if (suffix == "mp3" || suffix == "wav" || suffix == "ogg") {
+            request(path);
+        }
+    });
+
+    // Le fichier évincé ne sera plus demandé sous cette empreinte: sa forme d'onde non plus
+    connect(AssetStore::instance(), &AssetStore::assetEvicted, this, [this](const QString &hash) {
+        QFile::remove(m_directory + "/" + hash + ".peaks");
+    }, Qt::DirectConnection);
+
+    // Abandonner les calculs en attente et interrompre celui en cours
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        m_stopping = true;
+        m_pool->clear();
+        m_pool->waitForDone();
+    });
+}
+
+std::shared_ptr<const WaveformPeaks> WaveformCache::peaks(const QString &filePath)
+{
+    if (filePath.isEmpty()) {
+        return nullptr;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_peaks.constFind(filePath);
+        if (it != m_peaks.constEnd()) {
+            return it.value();
+        }
+    }
+
+    request(filePath);
+    return nullptr;
+}
+
+void WaveformCache::request(const QString &filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_peaks.contains(filePath) || m_pending.contains(filePath)) {
+            return;
+        }
+        m_pending.insert(filePath);
+    }
+
+    m_pool->start([this, filePath]() {
+        process(filePath);
+    });
+}
+
+void WaveformCache::process(const QString &filePath)
+{
+    auto peaks = std::make_shared<WaveformPeaks>();
+
+    // Le nom d'un fichier du stockage est déjà son empreinte
+    QString hash = AssetStore::instance()->hashForStoredPath(filePath);
+    if (hash.isEmpty()) {
+        hash = AssetStore::hashFile(filePath);
+    }
+    const QString cachePath = m_directory + "/" + hash + ".peaks";
+
+    QFile cacheFile(cachePath);
+    const bool cached = !hash.isEmpty() && cacheFile.open(QIODevice::ReadOnly)
+                        && WaveformPeaks::fromByteArray(cacheFile.readAll(), *peaks);
+    cacheFile.close();
+
+    if (!cached) {
+        QElapsedTimer timer;
+        timer.start();
+        const ChunkedDecoder::Result built = build(filePath, m_stopping, *peaks);
+        if (built == ChunkedDecoder::Stopped) {
+            // Fermeture: rien n'est gardé, le calcul reprendra à la prochaine session
+            QMutexLocker locker(&m_mutex);
+            m_pending.remove(filePath);
+            return;
+        }
+        if (built == ChunkedDecoder::Finished) {
+            qDebug() << "Forme d'onde calculée:" << filePath << "en" << timer.elapsed() << "ms";
+            if (!hash.isEmpty() && cacheFile.open(QIODevice::WriteOnly)) {
+                cacheFile.write(peaks->toByteArray());
+            }
+        } else {
+            // Une pyramide vide évite de redécoder un fichier illisible à chaque dessin
+            peaks = std::make_shared<WaveformPeaks>();
+        }
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending.remove(filePath);
+        m_peaks.insert(filePath, peaks);
+    }
+
+    emit ready(filePath);
+}
+
+ChunkedDecoder::Result WaveformCache::build(const QString &filePath, const std::atomic<bool> &stopping,
+                                            WaveformPeaks &peaks)
+{
+    AudioSample chunk;
+
+    // Chaque tampon est résumé puis oublié
+    QString error;
+    const ChunkedDecoder::Result decoded = ChunkedDecoder::decode(filePath, [&](const QAudioBuffer &buffer) {
+        chunk.data.clear();
+        chunk.pcm16.clear();
+        chunk.channels = 0;
+        AudioEngine::appendBuffer(chunk, buffer);
+        if (chunk.channels > 0) {
+            peaks.append(chunk);
+        }
+        return true;
+    }, &stopping, &error);
+
+    if (decoded == ChunkedDecoder::Failed) {
+        qDebug() << "ERREUR: Forme d'onde impossible à calculer" << filePath << ":" << error;
+    }
+
+    peaks.finish();
+    return decoded;
+}
@@ -0,0 +1,91 @@
+#ifndef WAVEFORMCACHE_H
+#define WAVEFORMCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include "waveformpeaks.h"
+#include "chunkeddecoder.h"
+
+class QThreadPool;
+
+/**
+ * @brief Formes d'onde des fichiers audio, calculées en arrière-plan et gardées sur le disque
+ *
+ * La pyramide de crêtes (WaveformPeaks) de chaque fichier est calculée une seule fois,
+ * sur un thread de faible priorité, puis enregistrée dans le dossier "peaks" à côté du
+ * stockage, sous l'empreinte du contenu. Les fichiers ajoutés à l'AssetStore sont
+ * traités dès leur arrivée ; les autres le sont à la première demande. La forme d'onde
+ * d'un fichier évincé du stockage est supprimée avec lui.
+ *
+ * peaks() ne fait qu'une recherche en mémoire : un pad peut redessiner sa forme d'onde
+ * sans jamais lire ni décoder son son. Tant qu'elle n'est pas prête, il reçoit nullptr
+ * puis est prévenu par ready(). À la fermeture, le calcul en cours est interrompu sans
+ * rien enregistrer.
+ */
+class WaveformCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Obtient l'instance partagée par toute l'application
+     * @return Instance unique
+     */
+    static WaveformCache *instance();
+
+    /**
+     * @brief Obtient la forme d'onde d'un fichier, et la prépare en arrière-plan si besoin
+     * @param filePath Chemin du fichier audio
+     * @return Pyramide de crêtes, ou nullptr si elle n'est pas encore prête
+     */
+    std::shared_ptr<const WaveformPeaks> peaks(const QString &filePath);
+
+signals:
+    /**
+     * @brief Signal émis lorsque la forme d'onde d'un fichier devient disponible (thread de calcul)
+     * @param filePath Chemin du fichier, tel que donné à peaks()
+     */
+    void ready(const QString &filePath);
+
+private:
+    /**
+     * @brief Constructeur
+     * @param parent Objet parent
+     */
+    explicit WaveformCache(QObject *parent = nullptr);
+
+    QString m_directory;                                            // Dossier des formes d'onde enregistrées
+    QHash<QString, std::shared_ptr<const WaveformPeaks>> m_peaks;   // Formes d'onde prêtes, par chemin
+    QSet<QString> m_pending;                                        // Fichiers en cours de traitement
+    QThreadPool *m_pool;                                            // Thread de calcul
+    std::atomic<bool> m_stopping;                                   // Fermeture en cours: interrompre le calcul
+    QMutex m_mutex;                                                 // Protège les formes d'onde
+
+    /**
+     * @brief Lance le traitement d'un fichier s'il n'est ni prêt ni en cours
+     * @param filePath Chemin du fichier audio
+     */
+    void request(const QString &filePath);
+
+    /**
+     * @brief Relit ou calcule la forme d'onde d'un fichier (thread de calcul)
+     * @param filePath Chemin du fichier audio
+     */
+    void process(const QString &filePath);
+
+    /**
+     * @brief Décode un fichier par morceaux et construit sa pyramide (thread de calcul)
+     * @param filePath Chemin du fichier audio
+     * @param stopping Drapeau d'arrêt, levé à la fermeture
+     * @param peaks Reçoit la pyramide
+     * @return Issue du décodage
+     */
+    static ChunkedDecoder::Result build(const QString &filePath, const std::atomic<bool> &stopping, WaveformPeaks &peaks);
+};
+
+#endif // WAVEFORMCACHE_H
@@ -0,0 +1,155 @@
+#include "waveformpeaks.h"
+#include "mixkernels.h"
+#include <QDataStream>
+#include <QIODevice>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const quint32 Magic = 0x594E504B;   // "YNPK"
+const quint16 Version = 1;
+
+} // namespace
+
+WaveformPeaks::WaveformPeaks()
+    : m_frames(0)
+    , m_blockFrames(0)
+    , m_blockMinimum(1.0f)
+    , m_blockMaximum(-1.0f)
+{
+    m_levels.resize(1);
+}
+
+void WaveformPeaks::append(const AudioSample &chunk)
+{
+    const MixKernels::RangeFunction range = MixKernels::active().range[chunk.isInt16() ? 1 : 0];
+    const qint64 frames = chunk.frameCount();
+    const int channels = chunk.channels;
+    const int sampleBytes = chunk.isInt16() ? int(sizeof(qint16)) : int(sizeof(float));
+    const char *samples = static_cast<const char*>(chunk.samplesAt(0));
+
+    // Les canaux sont confondus: un bloc s'étend sur des échantillons contigus
+    qint64 frame = 0;
+    while (frame < frames) {
+        const qint64 count = qMin<qint64>(BaseFrames - m_blockFrames, frames - frame);
+        range(samples + frame * channels * sampleBytes, count * channels, m_blockMinimum, m_blockMaximum);
+        m_blockFrames += count;
+        frame += count;
+        if (m_blockFrames == BaseFrames) {
+            closeBlock();
+        }
+    }
+    m_frames += frames;
+}
+
+void WaveformPeaks::finish()
+{
+    if (m_blockFrames > 0) {
+        closeBlock();
+    }
+    buildLevels();
+}
+
+void WaveformPeaks::closeBlock()
+{
+    // Arrondir vers l'extérieur: un son très faible reste visible
+    Peak peak;
+    peak.minimum = qint8(qBound(-127, int(std::floor(m_blockMinimum * 127.0f)), 127));
+    peak.maximum = qint8(qBound(-127, int(std::ceil(m_blockMaximum * 127.0f)), 127));
+    m_levels[0].append(peak);
+
+    m_blockFrames = 0;
+    m_blockMinimum = 1.0f;
+    m_blockMaximum = -1.0f;
+}
+
+void WaveformPeaks::buildLevels()
+{
+    m_levels.resize(1);
+    while (m_levels.last().size() > 1) {
+        const QVector<Peak> &finer = m_levels.last();
+        QVector<Peak> coarser((finer.size() + 1) / 2);
+        for (int i = 0; i < coarser.size(); ++i) {
+            const Peak &first = finer[2 * i];
+            const Peak &second = 2 * i + 1 < finer.size() ? finer[2 * i + 1] : first;
+            coarser[i].minimum = qMin(first.minimum, second.minimum);
+            coarser[i].maximum = qMax(first.maximum, second.maximum);
+        }
+        m_levels.append(coarser);
+    }
+}
+
+void WaveformPeaks::peaks(int columns, QVector<Peak> &output) const
+{
+    output.clear();
+    if (isEmpty() || columns <= 0) {
+        return;
+    }
+
+    // Niveau le plus grossier offrant encore au moins une crête par colonne
+    int level = 0;
+    while (level + 1 < m_levels.size() && m_levels[level + 1].size() >= columns) {
+        ++level;
+    }
+    const QVector<Peak> &source = m_levels[level];
+    const qint64 count = source.size();
+
+    output.resize(columns);
+    for (int column = 0; column < columns; ++column) {
+        const qint64 begin = column * count / columns;
+        const qint64 end = qMax(begin + 1, (column + 1) * count / columns);
+        Peak peak = source[begin];
+        for (qint64 i = begin + 1; i < end; ++i) {
+            peak.minimum = qMin(peak.minimum, source[i].minimum);
+            peak.maximum = qMax(peak.maximum, source[i].maximum);
+        }
+        output[column] = peak;
+    }
+}
+
+QByteArray WaveformPeaks::toByteArray() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    const QVector<Peak> &base = m_levels.first();
+
+    stream << Magic << Version << qint32(BaseFrames) << m_frames << qint32(base.size());
+    stream.writeRawData(reinterpret_cast<const char*>(base.constData()), int(base.size() * sizeof(Peak)));
+    return data;
+}
+
+bool WaveformPeaks::fromByteArray(const QByteArray &data, WaveformPeaks &peaks)
+{
+    QDataStream stream(data);
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 baseFrames = 0;
+    qint64 frames = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> baseFrames >> frames >> count;
+
+    // Un cache écrit avec une autre résolution est recalculé
+    if (stream.status() != QDataStream::Ok || magic != Magic || version != Version
+        || baseFrames != BaseFrames || count < 0 || frames < 0) {
+        return false;
+    }
+
+    // Un fichier tronqué ou corrompu ne doit pas faire réserver plus que ce qu'il contient
+    const qint64 remaining = qMin<qint64>(data.size() - stream.device()->pos(), std::numeric_limits<int>::max());
+    if (qint64(count) * qint64(sizeof(Peak)) > remaining) {
+        return false;
+    }
+
+    QVector<Peak> base(count);
+    const int bytes = count * int(sizeof(Peak));
+    if (stream.readRawData(reinterpret_cast<char*>(base.data()), bytes) != bytes) {
+        return false;
+    }
+
+    peaks.m_levels.clear();
+    peaks.m_levels.append(base);
+    peaks.m_frames = frames;
+    peaks.buildLevels();
+    return true;
+}
@@ -0,0 +1,102 @@
+#ifndef WAVEFORMPEAKS_H
+#define WAVEFORMPEAKS_H
+
+#include <QVector>
+#include <QByteArray>
+#include "audiosample.h"
+
+/**
+ * @brief Pyramide de crêtes (minimum et maximum) d'un son, pour dessiner sa forme d'onde
+ *
+ * Le niveau le plus fin résume chaque bloc de BaseFrames trames, tous canaux confondus ;
+ * chaque niveau suivant fusionne deux crêtes du précédent. Les valeurs sont quantifiées
+ * sur 8 bits, arrondies vers l'extérieur pour ne jamais rogner l'enveloppe.
+ *
+ * Dessiner une forme d'onde revient à choisir le niveau le plus grossier qui offre au
+ * moins une crête par colonne, puis à fusionner quelques crêtes par colonne : le coût ne
+ * dépend que de la largeur dessinée, jamais de la durée du son.
+ *
+ * La pyramide est construite au fil du décodage (append() puis finish()) et seul le
+ * niveau le plus fin est enregistré (toByteArray()) : les autres sont recalculés au
+ * chargement.
+ */
+class WaveformPeaks
+{
+public:
+    static const int BaseFrames = 1024;     ///< Trames résumées par une crête du niveau le plus fin
+
+    /**
+     * @brief Crête d'un bloc, entre -127 et 127
+     */
+    struct Peak {
+        qint8 minimum;
+        qint8 maximum;
+    };
+
+    /**
+     * @brief Constructeur d'une pyramide vide, prête à recevoir un son
+     */
+    WaveformPeaks();
+
+    /**
+     * @brief Ajoute les trames suivantes du son
+     * @param chunk Trames en 16 bits ou en flottants, mono ou stéréo
+     */
+    void append(const AudioSample &chunk);
+
+    /**
+     * @brief Termine la construction: clôt le dernier bloc et calcule les niveaux grossiers
+     */
+    void finish();
+
+    /**
+     * @brief Indique si la pyramide ne contient aucune crête
+     */
+    bool isEmpty() const { return m_levels.isEmpty() || m_levels.first().isEmpty(); }
+
+    /**
+     * @brief Obtient la durée du son résumé
+     * @return Nombre de trames
+     */
+    qint64 frameCount() const { return m_frames; }
+
+    /**
+     * @brief Réduit la forme d'onde à un nombre de colonnes
+     * @param columns Nombre de colonnes dessinées
+     * @param output Reçoit une crête par colonne (vide si la pyramide est vide)
+     */
+    void peaks(int columns, QVector<Peak> &output) const;
+
+    /**
+     * @brief Sérialise la pyramide pour le cache sur disque
+     * @return Niveau le plus fin et durée du son
+     */
+    QByteArray toByteArray() const;
+
+    /**
+     * @brief Relit une pyramide sérialisée par toByteArray()
+     * @param data Données lues sur le disque
+     * @param peaks Reçoit la pyramide
+     * @return false si les données sont invalides ou d'une autre version
+     */
+    static bool fromByteArray(const QByteArray &data, WaveformPeaks &peaks);
+
+private:
+    QVector<QVector<Peak>> m_levels;    // Niveaux, du plus fin au plus grossier
+    qint64 m_frames;                    // Trames résumées
+    qint64 m_blockFrames;               // Trames déjà dans le bloc en cours
+    float m_blockMinimum;               // Minimum du bloc en cours
+    float m_blockMaximum;               // Maximum du bloc en cours
+
+    /**
+     * @brief Clôt le bloc en cours et l'ajoute au niveau le plus fin
+     */
+    void closeBlock();
+
+    /**
+     * @brief Calcule les niveaux grossiers à partir du niveau le plus fin
+     */
+    void buildLevels();
+};
+
+#endif // WAVEFORMPEAKS_H